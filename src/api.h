@@ -7,6 +7,13 @@
 #define TYPE_REQUEST 0
 #define TYPE_SHUTDOWN 1
 #define TYPE_PING 3
+// same as TYPE_REQUEST, but the request is followed by struct time_shift_request
+#define TYPE_REQUEST_TIME_SHIFT 4
+// same as TYPE_REQUEST, but the request is followed by struct squelch_request
+#define TYPE_REQUEST_SQUELCH 5
+// server responds with struct response where details contains the number of clients
+// followed by struct stats_device and struct stats_client for every client
+#define TYPE_STATS 6
 //server to client
 #define TYPE_RESPONSE 2
 
@@ -17,6 +24,10 @@ struct message_header {
 
 #define REQUEST_DESTINATION_FILE 0
 #define REQUEST_DESTINATION_SOCKET 1
+// native device samples (cu8 for rtl-sdr, cs8 for hackrf, cs16 for airspy) without any processing
+// sampling_rate should be equal to the server's band_sampling_rate and center_freq to band_freq
+#define REQUEST_DESTINATION_FILE_RAW 2
+#define REQUEST_DESTINATION_SOCKET_RAW 3
 
 struct request {
 	uint32_t center_freq;
@@ -25,12 +36,84 @@ struct request {
 	uint8_t destination;
 } __attribute__((packed));
 
+struct time_shift_request {
+	// start the stream this number of milliseconds in the past. Server should be configured with time_shift_seconds
+	uint32_t milliseconds;
+} __attribute__((packed));
+
+struct squelch_request {
+	// signal is present when its power is above the noise floor by this number of dB
+	uint8_t threshold_db;
+	// keep sending this number of milliseconds after the signal is gone
+	uint32_t hang_ms;
+	// send this number of milliseconds before the signal
+	uint32_t preroll_ms;
+} __attribute__((packed));
+
+// with squelch, the socket destination receives frames: the header followed by samples * 8 bytes of cf32
+struct squelch_frame {
+	// index of the first sample in the output stream. Network byte order
+	uint32_t sample_offset_high;
+	uint32_t sample_offset_low;
+	uint32_t samples;
+} __attribute__((packed));
+
+// all fields are in network byte order
+struct stats_device {
+	uint64_t buffers;
+	uint64_t samples;
+	// reported by the driver
+	uint64_t dropped_samples;
+	// received samples fell behind the clock. Diagnostic only, not reported as gaps
+	uint64_t lost_samples;
+	uint64_t gaps;
+	uint32_t observed_sampling_rate;
+	// bitmask of the cpus the device thread is allowed to run on
+	uint64_t thread_cpus;
+	// SCHED_FIFO priority of the device thread or 0
+	uint8_t thread_priority;
+} __attribute__((packed));
+
+// raw destinations are not filtered
+#define STATS_KERNEL_NONE 0
+#define STATS_KERNEL_NATIVE_CF32 1
+#define STATS_KERNEL_OPTIMIZED_CF32 2
+
+// all fields are in network byte order
+struct stats_client {
+	uint32_t id;
+	uint32_t center_freq;
+	uint32_t sampling_rate;
+	uint32_t band_freq;
+	uint8_t destination;
+	uint8_t kernel;
+	// buffers waiting for the dsp thread
+	uint32_t queue_depth;
+	uint64_t input_samples;
+	uint64_t output_bytes;
+	// input buffers overwritten because the client was too slow
+	uint64_t queue_overflows;
+	// cpu time of the dsp thread
+	uint64_t cpu_micros;
+	uint64_t latency_p99_micros;
+	// bitmask of the cpus the dsp thread is allowed to run on
+	uint64_t thread_cpus;
+	// might be less than configured queue_size if memory_budget_mb is set
+	uint32_t queue_size;
+	// approximate memory allocated for the client
+	uint64_t memory_bytes;
+} __attribute__((packed));
+
 #define RESPONSE_STATUS_SUCCESS 0
 #define RESPONSE_STATUS_FAILURE 1
 
 #define RESPONSE_DETAILS_INVALID_REQUEST 1
 #define RESPONSE_DETAILS_OUT_OF_BAND_FREQ 2
 #define RESPONSE_DETAILS_INTERNAL_ERROR 3
+// the client doesn't fit into memory_budget_mb. Try later or with less clients
+#define RESPONSE_DETAILS_OUT_OF_MEMORY 4
+// the client's dsp would overload the cpus. See cpu_budget_percent
+#define RESPONSE_DETAILS_OUT_OF_CPU 5
 
 struct response {
 	uint8_t status;
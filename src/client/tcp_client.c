@@ -82,6 +82,103 @@ int send_message(struct tcp_client *client, uint8_t protocol, uint8_t type, uint
 	return write_request(header, req, client);
 }
 
+int send_time_shift_message(struct tcp_client *client, uint32_t center_freq, uint32_t sampling_rate, uint32_t band_freq, uint8_t destination, uint32_t milliseconds) {
+	struct message_header header;
+	header.protocol_version = PROTOCOL_VERSION;
+	header.type = TYPE_REQUEST_TIME_SHIFT;
+	struct request req;
+	req.band_freq = band_freq;
+	req.center_freq = center_freq;
+	req.sampling_rate = sampling_rate;
+	req.destination = destination;
+	int code = write_request(header, req, client);
+	if (code != 0) {
+		return code;
+	}
+	struct time_shift_request time_shift;
+	time_shift.milliseconds = htonl(milliseconds);
+	return write_data(&time_shift, sizeof(struct time_shift_request), client);
+}
+
+int send_squelch_message(struct tcp_client *client, uint32_t center_freq, uint32_t sampling_rate, uint32_t band_freq, uint8_t destination, uint8_t threshold_db, uint32_t hang_ms, uint32_t preroll_ms) {
+	struct message_header header;
+	header.protocol_version = PROTOCOL_VERSION;
+	header.type = TYPE_REQUEST_SQUELCH;
+	struct request req;
+	req.band_freq = band_freq;
+	req.center_freq = center_freq;
+	req.sampling_rate = sampling_rate;
+	req.destination = destination;
+	int code = write_request(header, req, client);
+	if (code != 0) {
+		return code;
+	}
+	struct squelch_request squelch;
+	squelch.threshold_db = threshold_db;
+	squelch.hang_ms = htonl(hang_ms);
+	squelch.preroll_ms = htonl(preroll_ms);
+	return write_data(&squelch, sizeof(struct squelch_request), client);
+}
+
+int send_stats_message(struct tcp_client *client) {
+	struct message_header header;
+	header.protocol_version = PROTOCOL_VERSION;
+	header.type = TYPE_STATS;
+	return write_data(&header, sizeof(struct message_header), client);
+}
+
+// big-endian uint64 from the wire
+static uint64_t from_uint64_be(uint64_t value) {
+	uint8_t input[sizeof(uint64_t)];
+	memcpy(input, &value, sizeof(uint64_t));
+	uint64_t result = 0;
+	for (size_t i = 0; i < sizeof(uint64_t); i++) {
+		result = (result << 8) | input[i];
+	}
+	return result;
+}
+
+int read_stats(uint32_t number_of_clients, struct stats_device *device, struct stats_client **clients, struct tcp_client *tcp_client) {
+	int code = read_data(device, sizeof(struct stats_device), tcp_client);
+	if (code != 0) {
+		return code;
+	}
+	device->buffers = from_uint64_be(device->buffers);
+	device->samples = from_uint64_be(device->samples);
+	device->dropped_samples = from_uint64_be(device->dropped_samples);
+	device->lost_samples = from_uint64_be(device->lost_samples);
+	device->gaps = from_uint64_be(device->gaps);
+	device->observed_sampling_rate = ntohl(device->observed_sampling_rate);
+	device->thread_cpus = from_uint64_be(device->thread_cpus);
+	struct stats_client *result = malloc(sizeof(struct stats_client) * (number_of_clients > 0 ? number_of_clients : 1));
+	if (result == NULL) {
+		return -ENOMEM;
+	}
+	code = read_data(result, sizeof(struct stats_client) * number_of_clients, tcp_client);
+	if (code != 0) {
+		free(result);
+		return code;
+	}
+	for (uint32_t i = 0; i < number_of_clients; i++) {
+		struct stats_client *client = result + i;
+		client->id = ntohl(client->id);
+		client->center_freq = ntohl(client->center_freq);
+		client->sampling_rate = ntohl(client->sampling_rate);
+		client->band_freq = ntohl(client->band_freq);
+		client->queue_depth = ntohl(client->queue_depth);
+		client->input_samples = from_uint64_be(client->input_samples);
+		client->output_bytes = from_uint64_be(client->output_bytes);
+		client->queue_overflows = from_uint64_be(client->queue_overflows);
+		client->cpu_micros = from_uint64_be(client->cpu_micros);
+		client->latency_p99_micros = from_uint64_be(client->latency_p99_micros);
+		client->thread_cpus = from_uint64_be(client->thread_cpus);
+		client->queue_size = ntohl(client->queue_size);
+		client->memory_bytes = from_uint64_be(client->memory_bytes);
+	}
+	*clients = result;
+	return 0;
+}
+
 int read_data(void *result, size_t len, struct tcp_client *tcp_client) {
 	size_t left = len;
 	while (left > 0) {
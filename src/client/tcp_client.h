@@ -15,7 +15,12 @@ int read_data(void *buffer, size_t len, struct tcp_client *tcp_client);
 
 int write_request(struct message_header header, struct request req, struct tcp_client *tcp_client);
 int send_message(struct tcp_client *client, uint8_t protocol, uint8_t type, uint32_t center_freq, uint32_t sampling_rate, uint32_t band_freq, uint8_t destination);
+int send_time_shift_message(struct tcp_client *client, uint32_t center_freq, uint32_t sampling_rate, uint32_t band_freq, uint8_t destination, uint32_t milliseconds);
+int send_squelch_message(struct tcp_client *client, uint32_t center_freq, uint32_t sampling_rate, uint32_t band_freq, uint8_t destination, uint8_t threshold_db, uint32_t hang_ms, uint32_t preroll_ms);
 int read_response(struct message_header **header, struct response **resp, struct tcp_client *tcp_client);
+int send_stats_message(struct tcp_client *client);
+// should be called after read_response. number_of_clients is in the response details
+int read_stats(uint32_t number_of_clients, struct stats_device *device, struct stats_client **clients, struct tcp_client *tcp_client);
 
 void destroy_client(struct tcp_client *tcp_client);
 // this will wait until server release all resources, stop all threads and closes connection
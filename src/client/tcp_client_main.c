@@ -30,6 +30,7 @@ void usage() {
   printf("  -s <sampling_rate> sampling rate (default: 48000)\n");
   printf("  -f <center_freq> Center frequency. Frequency where signal of interest is\n");
   printf("  -b <band_freq> Band frequency. Multiple clients have to specify same frequency band\n");
+  printf("  -r receive raw device samples without any processing. Sampling rate should be equal to the server band sampling rate\n");
   printf("  <filename> Filename to output (a '-' dumps samples to stdout)\n");
 }
 
@@ -40,13 +41,17 @@ int main(int argc, char **argv) {
   uint32_t sampling_rate = 48000;
   char *filename = NULL;
   char *hostname = "127.0.0.1";
+  uint8_t destination = REQUEST_DESTINATION_SOCKET;
 
   int dopt;
-  while ((dopt = getopt(argc, argv, "hr:k:m:b:s:p:n:f:")) != EOF) {
+  while ((dopt = getopt(argc, argv, "hrk:m:b:s:p:n:f:")) != EOF) {
     switch (dopt) {
       case 'h':
         usage();
         return EXIT_SUCCESS;
+      case 'r':
+        destination = REQUEST_DESTINATION_SOCKET_RAW;
+        break;
       case 'k':
         hostname = optarg;
         break;
@@ -80,7 +85,7 @@ int main(int argc, char **argv) {
 
   struct tcp_client *client = NULL;
   ERROR_CHECK(create_client(hostname, port, &client));
-  ERROR_CHECK(send_message(client, PROTOCOL_VERSION, TYPE_REQUEST, center_freq, sampling_rate, band_freq, REQUEST_DESTINATION_SOCKET));
+  ERROR_CHECK(send_message(client, PROTOCOL_VERSION, TYPE_REQUEST, center_freq, sampling_rate, band_freq, destination));
   struct message_header *response_header = NULL;
   struct response *resp = NULL;
   ERROR_CHECK(read_response(&response_header, &resp, client));
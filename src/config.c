@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include <errno.h>
+#include <inttypes.h>
 #include <libconfig.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -78,9 +79,33 @@ uint32_t config_read_uint32_t(config_t *libconfig, const char *config_name, uint
   return result;
 }
 
+// array of cpu numbers into bitmask. 0 - not configured
+static int config_read_cpus(config_t *libconfig, const char *config_name, uint64_t *cpus) {
+  const config_setting_t *setting = config_lookup(libconfig, config_name);
+  uint64_t result = 0;
+  if (setting != NULL) {
+    if (!config_setting_is_array(setting)) {
+      fprintf(stderr, "<3>%s should be an array of cpu numbers\n", config_name);
+      return -1;
+    }
+    for (int i = 0; i < config_setting_length(setting); i++) {
+      int cpu = config_setting_get_int(config_setting_get_elem(setting, i));
+      if (cpu < 0 || cpu >= 64) {
+        fprintf(stderr, "<3>invalid cpu in %s: %d\n", config_name, cpu);
+        return -1;
+      }
+      result |= (uint64_t) 1 << cpu;
+    }
+  }
+  fprintf(stdout, "%s: 0x%" PRIx64 "\n", config_name, result);
+  *cpus = result;
+  return 0;
+}
+
 static cpu_optimization config_parse_cpu_optimization(const char *str) {
   if (strcmp(str, "NATIVE_CF32") == 0) return NATIVE_CF32;
   if (strcmp(str, "OPTIMIZED_CF32") == 0) return OPTIMIZED_CF32;
+  if (strcmp(str, "AUTO_CF32") == 0) return AUTO_CF32;
   return -1;
 }
 
@@ -90,6 +115,58 @@ static const char *config_format_cpu_optimization(cpu_optimization value) {
       return "NATIVE_CF32";
     case OPTIMIZED_CF32:
       return "OPTIMIZED_CF32";
+    case AUTO_CF32:
+      return "AUTO_CF32";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+static file_compression config_parse_compression(const char *str) {
+  if (strcmp(str, "none") == 0) return COMPRESSION_NONE;
+  if (strcmp(str, "gzip") == 0) return COMPRESSION_GZIP;
+  if (strcmp(str, "zstd") == 0) return COMPRESSION_ZSTD;
+  if (strcmp(str, "lz4") == 0) return COMPRESSION_LZ4;
+  return -1;
+}
+
+static const char *config_format_compression(file_compression value) {
+  switch (value) {
+    case COMPRESSION_NONE:
+      return "none";
+    case COMPRESSION_GZIP:
+      return "gzip";
+    case COMPRESSION_ZSTD:
+      return "zstd";
+    case COMPRESSION_LZ4:
+      return "lz4";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+static compression_filter config_parse_compression_filter(const char *str) {
+  if (strcmp(str, "none") == 0) return COMPRESSION_FILTER_NONE;
+  if (strcmp(str, "shuffle") == 0) return COMPRESSION_FILTER_SHUFFLE;
+  if (strcmp(str, "delta") == 0) return COMPRESSION_FILTER_DELTA;
+  return -1;
+}
+
+static sample_format_t config_parse_sample_format(const char *str) {
+  if (strcmp(str, "cu8") == 0) return SAMPLE_FORMAT_CU8;
+  if (strcmp(str, "cs8") == 0) return SAMPLE_FORMAT_CS8;
+  if (strcmp(str, "cs16") == 0) return SAMPLE_FORMAT_CS16;
+  return -1;
+}
+
+static const char *config_format_compression_filter(compression_filter value) {
+  switch (value) {
+    case COMPRESSION_FILTER_NONE:
+      return "none";
+    case COMPRESSION_FILTER_SHUFFLE:
+      return "shuffle";
+    case COMPRESSION_FILTER_DELTA:
+      return "delta";
     default:
       return "UNKNOWN";
   }
@@ -156,6 +233,13 @@ int create_server_config(struct server_config **config, const char *path) {
     free(result);
     return -1;
   }
+  result->airspy_sample_type = config_read_int(&libconfig, "airspy_sample_type", AIRSPY_SAMPLES_INT16_IQ);
+  if (result->airspy_sample_type > AIRSPY_SAMPLES_UINT16_REAL || result->airspy_sample_type < AIRSPY_SAMPLES_INT16_IQ) {
+    fprintf(stderr, "<3>invalid airspy_sample_type configuration\n");
+    config_destroy(&libconfig);
+    free(result);
+    return -1;
+  }
 
   result->hackrf_bias_t = (uint8_t) config_read_int(&libconfig, "hackrf_bias_t", 0);
   result->hackrf_amp = config_read_int(&libconfig, "hackrf_amp", 0);
@@ -187,6 +271,27 @@ int create_server_config(struct server_config **config, const char *path) {
     free(result);
     return -1;
   }
+  result->memory_budget_mb = config_read_int(&libconfig, "memory_budget_mb", 0);
+  if (result->memory_budget_mb < 0) {
+    fprintf(stderr, "<3>memory budget should not be negative: %d\n", result->memory_budget_mb);
+    config_destroy(&libconfig);
+    free(result);
+    return -1;
+  }
+  result->cpu_budget_percent = config_read_int(&libconfig, "cpu_budget_percent", 0);
+  if (result->cpu_budget_percent < 0 || result->cpu_budget_percent > 100) {
+    fprintf(stderr, "<3>cpu_budget_percent should be from 0 to 100: %d\n", result->cpu_budget_percent);
+    config_destroy(&libconfig);
+    free(result);
+    return -1;
+  }
+  result->min_queue_size = config_read_int(&libconfig, "min_queue_size", result->queue_size);
+  if (result->min_queue_size <= 0 || result->min_queue_size > result->queue_size) {
+    fprintf(stderr, "<3>min_queue_size should be from 1 to queue_size: %d\n", result->min_queue_size);
+    config_destroy(&libconfig);
+    free(result);
+    return -1;
+  }
 
   const config_setting_t *setting = config_lookup(&libconfig, "band_sampling_rate");
   if (setting == NULL) {
@@ -210,13 +315,21 @@ int create_server_config(struct server_config **config, const char *path) {
     result->buffer_size = AIRSPY_BUFFER_SIZE;
     fprintf(stdout, "force airspy buffer_size to: %d\n", result->buffer_size);
   }
+  result->rtlsdr_async_buffers = config_read_uint32_t(&libconfig, "rtlsdr_async_buffers", 15);
+  // librtlsdr silently uses its own transfer size otherwise
+  if (result->sdr_type == SDR_TYPE_RTL && result->rtlsdr_async_buffers > 0 && (result->buffer_size == 0 || result->buffer_size % 512 != 0)) {
+    fprintf(stderr, "<3>buffer_size should be multiple of 512 for rtl-sdr async reads: %u\n", result->buffer_size);
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
   result->lpf_cutoff_rate = config_read_int(&libconfig, "lpf_cutoff_rate", 5);
 
   setting = config_lookup(&libconfig, "bind_address");
   char *bind_address = read_and_copy_str(setting, "127.0.0.1");
   if (bind_address == NULL) {
     config_destroy(&libconfig);
-    free(result);
+    destroy_server_config(result);
     return -ENOMEM;
   }
   result->bind_address = bind_address;
@@ -237,17 +350,159 @@ int create_server_config(struct server_config **config, const char *path) {
     default_folder = "/tmp";
   }
 
+  // single path or the list of paths. recordings are spread across them
   setting = config_lookup(&libconfig, "base_path");
-  char *base_path = read_and_copy_str(setting, default_folder);
-  if (base_path == NULL) {
+  if (setting != NULL && config_setting_is_array(setting)) {
+    int base_paths_len = config_setting_length(setting);
+    if (base_paths_len <= 0) {
+      fprintf(stderr, "<3>base_path should not be empty\n");
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -1;
+    }
+    result->base_paths = malloc(sizeof(char *) * base_paths_len);
+    if (result->base_paths == NULL) {
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -ENOMEM;
+    }
+    for (int i = 0; i < base_paths_len; i++) {
+      char *base_path = read_and_copy_str(config_setting_get_elem(setting, i), default_folder);
+      if (base_path == NULL) {
+        config_destroy(&libconfig);
+        destroy_server_config(result);
+        return -ENOMEM;
+      }
+      result->base_paths[i] = base_path;
+      result->base_paths_len++;
+    }
+  } else {
+    char *base_path = read_and_copy_str(setting, default_folder);
+    if (base_path == NULL) {
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -ENOMEM;
+    }
+    result->base_paths = malloc(sizeof(char *));
+    if (result->base_paths == NULL) {
+      free(base_path);
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -ENOMEM;
+    }
+    result->base_paths[0] = base_path;
+    result->base_paths_len = 1;
+  }
+  result->base_path = result->base_paths[0];
+  for (size_t i = 0; i < result->base_paths_len; i++) {
+    fprintf(stdout, "base path for storing results: %s\n", result->base_paths[i]);
+  }
+
+  setting = config_lookup(&libconfig, "file_rotation_bytes");
+  long long file_rotation_bytes = 0;
+  if (setting != NULL) {
+    file_rotation_bytes = config_setting_get_int64(setting);
+  }
+  if (file_rotation_bytes < 0) {
+    fprintf(stderr, "<3>file_rotation_bytes should not be negative: %lld\n", file_rotation_bytes);
     config_destroy(&libconfig);
     destroy_server_config(result);
-    return -ENOMEM;
+    return -1;
+  }
+  result->file_rotation_bytes = (uint64_t) file_rotation_bytes;
+  result->file_rotation_seconds = config_read_int(&libconfig, "file_rotation_seconds", 0);
+  if (result->file_rotation_seconds < 0) {
+    fprintf(stderr, "<3>file_rotation_seconds should not be negative: %d\n", result->file_rotation_seconds);
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
   }
-  result->base_path = base_path;
-  fprintf(stdout, "base path for storing results: %s\n", result->base_path);
 
   result->use_gzip = config_read_bool(&libconfig, "use_gzip", true);
+  result->gzip_threads = config_read_int(&libconfig, "gzip_threads", 1);
+  if (result->gzip_threads <= 0) {
+    fprintf(stderr, "<3>gzip_threads should be positive: %d\n", result->gzip_threads);
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+
+  result->gzip_index_interval = config_read_uint32_t(&libconfig, "gzip_index_interval", 1048576);
+
+  // "compression" takes precedence over the legacy "use_gzip"
+  setting = config_lookup(&libconfig, "compression");
+  if (setting != NULL) {
+    const char *compression_str = config_setting_get_string(setting);
+    result->compression = config_parse_compression(compression_str);
+    if (result->compression == -1) {
+      fprintf(stderr, "<3>invalid compression: %s\n", compression_str);
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -1;
+    }
+    result->use_gzip = (result->compression == COMPRESSION_GZIP);
+  } else {
+    result->compression = result->use_gzip ? COMPRESSION_GZIP : COMPRESSION_NONE;
+  }
+  fprintf(stdout, "compression: %s\n", config_format_compression(result->compression));
+
+  int default_level;
+  int min_level;
+  int max_level;
+  switch (result->compression) {
+    case COMPRESSION_GZIP:
+      // Z_DEFAULT_COMPRESSION
+      default_level = -1;
+      min_level = -1;
+      max_level = 9;
+      break;
+    case COMPRESSION_ZSTD:
+      // ZSTD_CLEVEL_DEFAULT. negative levels are faster
+      default_level = 3;
+      min_level = -131072;
+      max_level = 22;
+      break;
+    case COMPRESSION_LZ4:
+      // 0 is fast mode, 3+ is high compression mode
+      default_level = 0;
+      min_level = 0;
+      max_level = 12;
+      break;
+    default:
+      default_level = 0;
+      min_level = 0;
+      max_level = 0;
+      break;
+  }
+  result->compression_level = config_read_int(&libconfig, "compression_level", default_level);
+  if (result->compression_level < min_level || result->compression_level > max_level) {
+    fprintf(stderr, "<3>invalid compression_level for %s: %d\n", config_format_compression(result->compression), result->compression_level);
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+
+  setting = config_lookup(&libconfig, "compression_filter");
+  if (setting != NULL) {
+    const char *filter_str = config_setting_get_string(setting);
+    result->compression_filter = config_parse_compression_filter(filter_str);
+    if (result->compression_filter == -1) {
+      fprintf(stderr, "<3>invalid compression_filter: %s\n", filter_str);
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -1;
+    }
+  } else {
+    result->compression_filter = COMPRESSION_FILTER_NONE;
+  }
+  // gzip and plain files should stay readable by other tools
+  if (result->compression_filter != COMPRESSION_FILTER_NONE && result->compression != COMPRESSION_ZSTD && result->compression != COMPRESSION_LZ4) {
+    fprintf(stderr, "<3>compression_filter is supported only for zstd and lz4\n");
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+  fprintf(stdout, "compression_filter: %s\n", config_format_compression_filter(result->compression_filter));
 
   setting = config_lookup(&libconfig, "cpu_optimization");
   if (setting != NULL) {
@@ -264,12 +519,143 @@ int create_server_config(struct server_config **config, const char *path) {
   }
   fprintf(stdout, "cpu_optimization: %s\n", config_format_cpu_optimization(result->optimization));
 
+  result->time_shift_seconds = config_read_int(&libconfig, "time_shift_seconds", 0);
+  if (result->time_shift_seconds < 0) {
+    fprintf(stderr, "<3>time_shift_seconds should not be negative: %d\n", result->time_shift_seconds);
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+  result->time_shift_file = read_and_copy_str(config_lookup(&libconfig, "time_shift_file"), NULL);
+  result->kernel_cache_file = read_and_copy_str(config_lookup(&libconfig, "kernel_cache_file"), NULL);
+  if (result->time_shift_seconds > 0) {
+    fprintf(stdout, "time shift: %d seconds\n", result->time_shift_seconds);
+  }
+
+  result->replay_file = read_and_copy_str(config_lookup(&libconfig, "replay_file"), NULL);
+  if (result->sdr_type == SDR_TYPE_FILE && result->replay_file == NULL) {
+    fprintf(stderr, "<3>missing required configuration: replay_file\n");
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+  setting = config_lookup(&libconfig, "replay_format");
+  if (setting != NULL) {
+    const char *replay_format_str = config_setting_get_string(setting);
+    result->replay_format = config_parse_sample_format(replay_format_str);
+    if (result->replay_format == -1) {
+      fprintf(stderr, "<3>invalid replay_format: %s\n", replay_format_str);
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -1;
+    }
+  } else {
+    result->replay_format = SAMPLE_FORMAT_CU8;
+  }
+  result->replay_realtime = config_read_bool(&libconfig, "replay_realtime", true);
+  result->replay_loop = config_read_bool(&libconfig, "replay_loop", false);
+  if (result->sdr_type == SDR_TYPE_FILE) {
+    fprintf(stdout, "replay: %s realtime: %d loop: %d\n", result->replay_file, result->replay_realtime, result->replay_loop);
+  }
+
+  setting = config_lookup(&libconfig, "generator_format");
+  if (setting != NULL) {
+    const char *generator_format_str = config_setting_get_string(setting);
+    result->generator_format = config_parse_sample_format(generator_format_str);
+    if (result->generator_format == -1) {
+      fprintf(stderr, "<3>invalid generator_format: %s\n", generator_format_str);
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -1;
+    }
+  } else {
+    result->generator_format = SAMPLE_FORMAT_CU8;
+  }
+  setting = config_lookup(&libconfig, "generator_tones");
+  if (setting != NULL && config_setting_is_array(setting) && config_setting_length(setting) > 0) {
+    int generator_tones_len = config_setting_length(setting);
+    result->generator_tones = malloc(sizeof(int32_t) * generator_tones_len);
+    if (result->generator_tones == NULL) {
+      config_destroy(&libconfig);
+      destroy_server_config(result);
+      return -ENOMEM;
+    }
+    for (int i = 0; i < generator_tones_len; i++) {
+      int32_t tone = config_setting_get_int(config_setting_get_elem(setting, i));
+      if ((uint32_t)abs(tone) > result->band_sampling_rate / 2) {
+        fprintf(stderr, "<3>generator tone is outside of the band: %d\n", tone);
+        config_destroy(&libconfig);
+        destroy_server_config(result);
+        return -1;
+      }
+      result->generator_tones[i] = tone;
+      result->generator_tones_len++;
+    }
+  }
+  result->generator_tone_amplitude = config_read_float(&libconfig, "generator_tone_amplitude", 0.5f);
+  result->generator_noise_amplitude = config_read_float(&libconfig, "generator_noise_amplitude", 0.01f);
+  result->generator_burst_ms = config_read_uint32_t(&libconfig, "generator_burst_ms", 0);
+  result->generator_burst_period_ms = config_read_uint32_t(&libconfig, "generator_burst_period_ms", 1000);
+  if (result->generator_burst_ms > result->generator_burst_period_ms) {
+    fprintf(stderr, "<3>generator_burst_ms should not be greater than generator_burst_period_ms\n");
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+  result->generator_realtime = config_read_bool(&libconfig, "generator_realtime", true);
+
+  result->stage_stats = config_read_bool(&libconfig, "stage_stats", false);
+  result->metrics_port = config_read_int(&libconfig, "metrics_port", 0);
+  if (result->metrics_port < 0 || result->metrics_port > 65535) {
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    fprintf(stderr, "<3>invalid metrics_port: %d\n", result->metrics_port);
+    return -1;
+  }
+  result->log_summary_seconds = config_read_int(&libconfig, "log_summary_seconds", 10);
+  if (result->log_summary_seconds < 0) {
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    fprintf(stderr, "<3>log_summary_seconds should not be negative: %d\n", result->log_summary_seconds);
+    return -1;
+  }
+  if (config_read_cpus(&libconfig, "device_cpus", &result->device_cpus) != 0 || config_read_cpus(&libconfig, "dsp_cpus", &result->dsp_cpus) != 0 || config_read_cpus(&libconfig, "io_cpus", &result->io_cpus) != 0) {
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -1;
+  }
+  result->device_priority = config_read_int(&libconfig, "device_priority", 0);
+  if (result->device_priority < 0 || result->device_priority > 99) {
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    fprintf(stderr, "<3>device_priority should be from 0 to 99: %d\n", result->device_priority);
+    return -1;
+  }
+  result->sample_memory_hugepages = config_read_bool(&libconfig, "sample_memory_hugepages", false);
+  result->sample_memory_prefault = config_read_bool(&libconfig, "sample_memory_prefault", false);
+  result->sample_memory_lock = config_read_bool(&libconfig, "sample_memory_lock", false);
+  setting = config_lookup(&libconfig, "metrics_bind_address");
+  result->metrics_bind_address = read_and_copy_str(setting, "127.0.0.1");
+  if (result->metrics_bind_address == NULL) {
+    config_destroy(&libconfig);
+    destroy_server_config(result);
+    return -ENOMEM;
+  }
+
   config_destroy(&libconfig);
 
   *config = result;
   return 0;
 }
 
+file_compression config_get_compression(struct server_config *config) {
+  // both are consistent after parsing, but use_gzip might be set directly
+  if (config->compression == COMPRESSION_NONE && config->use_gzip) {
+    return COMPRESSION_GZIP;
+  }
+  return config->compression;
+}
+
 void destroy_server_config(struct server_config *config) {
   if (config == NULL) {
     return;
@@ -277,11 +663,29 @@ void destroy_server_config(struct server_config *config) {
   if (config->bind_address != NULL) {
     free(config->bind_address);
   }
-  if (config->base_path != NULL) {
-    free(config->base_path);
+  if (config->metrics_bind_address != NULL) {
+    free(config->metrics_bind_address);
+  }
+  if (config->base_paths != NULL) {
+    for (size_t i = 0; i < config->base_paths_len; i++) {
+      free(config->base_paths[i]);
+    }
+    free(config->base_paths);
   }
   if (config->device_serial != NULL) {
     free(config->device_serial);
   }
+  if (config->time_shift_file != NULL) {
+    free(config->time_shift_file);
+  }
+  if (config->kernel_cache_file != NULL) {
+    free(config->kernel_cache_file);
+  }
+  if (config->replay_file != NULL) {
+    free(config->replay_file);
+  }
+  if (config->generator_tones != NULL) {
+    free(config->generator_tones);
+  }
   free(config);
 }
@@ -2,14 +2,24 @@
 #define CONFIG_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef enum {
   SDR_TYPE_RTL = 0,
   SDR_TYPE_AIRSPY = 1,
-  SDR_TYPE_HACKRF = 2
+  SDR_TYPE_HACKRF = 2,
+  SDR_TYPE_FILE = 3,
+  SDR_TYPE_GENERATOR = 4
 } sdr_type_t;
 
+// format of the samples produced by the device
+typedef enum {
+  SAMPLE_FORMAT_CU8 = 0,
+  SAMPLE_FORMAT_CS8 = 1,
+  SAMPLE_FORMAT_CS16 = 2
+} sample_format_t;
+
 typedef enum {
   AIRSPY_GAIN_AUTO = 0,
   AIRSPY_GAIN_SENSITIVITY = 1,
@@ -17,11 +27,32 @@ typedef enum {
   AIRSPY_GAIN_MANUAL = 3
 } airspy_gain_mode_t;
 
+typedef enum {
+  AIRSPY_SAMPLES_INT16_IQ = 0,
+  AIRSPY_SAMPLES_INT16_REAL = 1,
+  AIRSPY_SAMPLES_UINT16_REAL = 2
+} airspy_samples_t;
+
 typedef enum {
   NATIVE_CF32,
-  OPTIMIZED_CF32
+  OPTIMIZED_CF32,
+  // the fastest of the above for every filter. See kernel_tuner
+  AUTO_CF32
 } cpu_optimization;
 
+typedef enum {
+  COMPRESSION_NONE = 0,
+  COMPRESSION_GZIP = 1,
+  COMPRESSION_ZSTD = 2,
+  COMPRESSION_LZ4 = 3
+} file_compression;
+
+typedef enum {
+  COMPRESSION_FILTER_NONE = 0,
+  COMPRESSION_FILTER_SHUFFLE = 1,
+  COMPRESSION_FILTER_DELTA = 2
+} compression_filter;
+
 struct server_config {
   // socket settings
   char *bind_address;
@@ -29,6 +60,8 @@ struct server_config {
   int read_timeout_seconds;
   char *device_serial;
   cpu_optimization optimization;
+  // AUTO_CF32 results. NULL - not saved
+  char *kernel_cache_file;
 
   sdr_type_t sdr_type;
 
@@ -38,10 +71,18 @@ struct server_config {
   int gain;
   int ppm;
   int bias_t;
+  // number of usb transfers in flight. 0 - read synchronously
+  uint32_t rtlsdr_async_buffers;
   uint32_t buffer_size;
   // 4GHz max
   uint32_t band_sampling_rate;
   int queue_size;
+  // server-wide limit for the client queues and filters. 0 - unlimited
+  int memory_budget_mb;
+  // clients over the budget get smaller queue, but not less than this
+  int min_queue_size;
+  // percent of the dsp cpus the clients can load. 0 - unlimited
+  int cpu_budget_percent;
   int lpf_cutoff_rate;
 
   // airspy settings
@@ -51,6 +92,7 @@ struct server_config {
   int airspy_lna_gain;
   int airspy_linearity_gain;
   int airspy_sensitivity_gain;
+  airspy_samples_t airspy_sample_type;
 
   // hackrf settings
   uint8_t hackrf_bias_t;
@@ -59,12 +101,70 @@ struct server_config {
   int hackrf_vga_gain;
 
   // output settings
+  // the first of base_paths
   char *base_path;
+  char **base_paths;
+  size_t base_paths_len;
+  // legacy flag. See config_get_compression
   bool use_gzip;
+  int gzip_threads;
+  uint32_t gzip_index_interval;
+  uint64_t file_rotation_bytes;
+  int file_rotation_seconds;
+  file_compression compression;
+  int compression_level;
+  compression_filter compression_filter;
+
+  // time shift settings
+  int time_shift_seconds;
+  char *time_shift_file;
+
+  // replay settings
+  char *replay_file;
+  sample_format_t replay_format;
+  // false - as fast as possible
+  bool replay_realtime;
+  bool replay_loop;
+
+  // generator settings
+  sample_format_t generator_format;
+  // offsets from the band_freq in Hz
+  int32_t *generator_tones;
+  size_t generator_tones_len;
+  float generator_tone_amplitude;
+  float generator_noise_amplitude;
+  uint32_t generator_burst_ms;
+  uint32_t generator_burst_period_ms;
+  bool generator_realtime;
+
+  // monitoring settings
+  // latency histogram for every stage of the buffer processing
+  bool stage_stats;
+  // 0 - disabled
+  int metrics_port;
+  char *metrics_bind_address;
+  // thread settings
+  // bitmask of cpus. 0 - not pinned
+  uint64_t device_cpus;
+  uint64_t dsp_cpus;
+  // tcp workers and metrics threads
+  uint64_t io_cpus;
+  // SCHED_FIFO priority of the device thread. 0 - default scheduling
+  int device_priority;
+  // queues and filter buffers
+  bool sample_memory_hugepages;
+  bool sample_memory_prefault;
+  bool sample_memory_lock;
+
+  // hot path events are counted and logged at most once per this interval. 0 - never
+  int log_summary_seconds;
 };
 
 int create_server_config(struct server_config **config, const char *path);
 
+// compression of the output files. use_gzip still turns none into gzip
+file_compression config_get_compression(struct server_config *config);
+
 void destroy_server_config(struct server_config *config);
 
 #endif /* CONFIG_H_ */
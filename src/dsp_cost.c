@@ -0,0 +1,158 @@
+#include "dsp_cost.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "api.h"
+#include "lpf.h"
+#include "sdr_device.h"
+#include "xlating.h"
+
+#define DSP_COST_DECIMATION 8
+#define DSP_COST_SHORT_TAPS 32
+#define DSP_COST_LONG_TAPS 256
+#define DSP_COST_MIN_NANOS 20000000
+
+static uint64_t get_monotonic_nanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static void process(const uint8_t *input, size_t input_len, sample_format_t format, cpu_optimization optimization, xlating *filter) {
+  float complex *output = NULL;
+  size_t output_len = 0;
+  // the same kernels as dsp_worker
+  switch (format) {
+    case SAMPLE_FORMAT_CS8:
+      if (optimization == OPTIMIZED_CF32) {
+        process_optimized_cs8_cf32((const int8_t *) input, input_len, &output, &output_len, filter);
+      } else {
+        process_native_cs8_cf32((const int8_t *) input, input_len, &output, &output_len, filter);
+      }
+      break;
+    case SAMPLE_FORMAT_CS16:
+      if (optimization == OPTIMIZED_CF32) {
+        process_optimized_cs16_cf32((const int16_t *) input, input_len / sizeof(int16_t), &output, &output_len, filter);
+      } else {
+        process_native_cs16_cf32((const int16_t *) input, input_len / sizeof(int16_t), &output, &output_len, filter);
+      }
+      break;
+    default:
+      if (optimization == OPTIMIZED_CF32) {
+        process_optimized_cu8_cf32(input, input_len, &output, &output_len, filter);
+      } else {
+        process_native_cu8_cf32(input, input_len, &output, &output_len, filter);
+      }
+      break;
+  }
+}
+
+uint8_t *dsp_cost_create_input(uint32_t len) {
+  uint8_t *result = malloc(len);
+  if (result == NULL) {
+    return NULL;
+  }
+  // noise-like data. Zeros might hit faster paths
+  unsigned int seed = 1;
+  for (uint32_t i = 0; i < len; i++) {
+    result[i] = (uint8_t) rand_r(&seed);
+  }
+  return result;
+}
+
+int dsp_cost_measure(float *taps, size_t taps_len, uint32_t decimation, cpu_optimization optimization, const uint8_t *input, struct server_config *server_config, double *nanos) {
+  xlating *filter = NULL;
+  int code = create_frequency_xlating_filter(decimation, taps, taps_len, (int32_t) (server_config->band_sampling_rate / 10), server_config->band_sampling_rate, server_config->buffer_size, &filter);
+  // taps are owned by the filter even if it failed
+  if (code != 0) {
+    return code;
+  }
+  sample_format_t format = sdr_device_get_sample_format(server_config);
+  // warm up the caches and the branch predictor
+  process(input, server_config->buffer_size, format, optimization, filter);
+  uint64_t iterations = 0;
+  uint64_t start = get_monotonic_nanos();
+  uint64_t elapsed = 0;
+  while (elapsed < DSP_COST_MIN_NANOS) {
+    process(input, server_config->buffer_size, format, optimization, filter);
+    iterations++;
+    elapsed = get_monotonic_nanos() - start;
+  }
+  destroy_xlating(filter);
+  *nanos = (double) elapsed / (double) iterations;
+  return 0;
+}
+
+static int measure_synthetic(size_t taps_len, const uint8_t *input, struct server_config *server_config, double *nanos) {
+  float *taps = malloc(sizeof(float) * taps_len);
+  if (taps == NULL) {
+    return -ENOMEM;
+  }
+  for (size_t i = 0; i < taps_len; i++) {
+    taps[i] = 1.0F / (float) taps_len;
+  }
+  // AUTO picks the fastest kernel, so the native one gives the upper bound
+  cpu_optimization optimization = (server_config->optimization == OPTIMIZED_CF32) ? OPTIMIZED_CF32 : NATIVE_CF32;
+  return dsp_cost_measure(taps, taps_len, DSP_COST_DECIMATION, optimization, input, server_config, nanos);
+}
+
+int dsp_cost_calibrate(struct server_config *server_config, dsp_cost_model *model) {
+  uint8_t *input = dsp_cost_create_input(server_config->buffer_size);
+  if (input == NULL) {
+    return -ENOMEM;
+  }
+  double short_nanos = 0.0;
+  double long_nanos = 0.0;
+  int code = measure_synthetic(DSP_COST_SHORT_TAPS, input, server_config, &short_nanos);
+  if (code == 0) {
+    code = measure_synthetic(DSP_COST_LONG_TAPS, input, server_config, &long_nanos);
+  }
+  free(input);
+  if (code != 0) {
+    return code;
+  }
+  double input_samples = (double) server_config->buffer_size / (double) sdr_device_get_sample_size(sdr_device_get_sample_format(server_config));
+  double output_samples = input_samples / DSP_COST_DECIMATION;
+  model->nanos_per_tap = (long_nanos - short_nanos) / (output_samples * (DSP_COST_LONG_TAPS - DSP_COST_SHORT_TAPS));
+  if (model->nanos_per_tap < 0.0) {
+    model->nanos_per_tap = 0.0;
+  }
+  model->nanos_per_sample = (short_nanos - output_samples * DSP_COST_SHORT_TAPS * model->nanos_per_tap) / input_samples;
+  if (model->nanos_per_sample < 0.0) {
+    model->nanos_per_sample = 0.0;
+  }
+  return 0;
+}
+
+uint64_t dsp_cost_estimate(client_config *config, struct server_config *server_config, dsp_cost_model *model) {
+  // memcpy and write only. Limited by the network or disk, not by the cpu
+  if (config->destination == REQUEST_DESTINATION_FILE_RAW || config->destination == REQUEST_DESTINATION_SOCKET_RAW) {
+    return 0;
+  }
+  // the same filter as dsp_worker creates
+  float *taps = NULL;
+  size_t taps_len = 0;
+  if (create_low_pass_filter(1.0F, server_config->band_sampling_rate, config->sampling_rate / 2, config->sampling_rate / server_config->lpf_cutoff_rate, &taps, &taps_len) != 0) {
+    return 0;
+  }
+  free(taps);
+  double decimation = (double) (server_config->band_sampling_rate / config->sampling_rate);
+  double nanos_per_second = (double) server_config->band_sampling_rate * (model->nanos_per_sample + (double) taps_len / decimation * model->nanos_per_tap);
+  // nanoseconds of cpu per second of the data
+  return (uint64_t) (nanos_per_second / 1000000.0);
+}
+
+uint32_t dsp_cost_get_cpus(struct server_config *server_config) {
+  if (server_config->dsp_cpus != 0) {
+    return (uint32_t) __builtin_popcountll(server_config->dsp_cpus);
+  }
+  long result = sysconf(_SC_NPROCESSORS_ONLN);
+  if (result <= 0) {
+    return 1;
+  }
+  return (uint32_t) result;
+}
@@ -0,0 +1,35 @@
+#ifndef DSP_COST_H_
+#define DSP_COST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "dsp_worker.h"
+
+// cost = band_sampling_rate * (nanos_per_sample + taps / decimation * nanos_per_tap)
+typedef struct {
+  // conversion of the input, phase rotation and history copying
+  double nanos_per_sample;
+  // multiply-accumulate of one tap for one output sample
+  double nanos_per_tap;
+} dsp_cost_model;
+
+// runs the configured kernel on the synthetic data
+// takes few tens of milliseconds
+int dsp_cost_calibrate(struct server_config *server_config, dsp_cost_model *model);
+
+// buffer of len bytes with the noise-like data
+uint8_t *dsp_cost_create_input(uint32_t len);
+
+// average nanoseconds to filter one buffer of buffer_size bytes with the given kernel
+// taps are owned by the filter
+int dsp_cost_measure(float *taps, size_t taps_len, uint32_t decimation, cpu_optimization optimization, const uint8_t *input, struct server_config *server_config, double *nanos);
+
+// estimated load of the client's dsp thread in millicores. 1000 - one cpu fully loaded
+uint64_t dsp_cost_estimate(client_config *config, struct server_config *server_config, dsp_cost_model *model);
+
+// number of cpus the dsp threads can run on: dsp_cpus or all online cpus
+uint32_t dsp_cost_get_cpus(struct server_config *server_config);
+
+#endif /* DSP_COST_H_ */
@@ -1,150 +1,423 @@
 #include "dsp_worker.h"
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "api.h"
 #include "lpf.h"
+#include "sdr_device.h"
+#include "thread_scheduling.h"
 
-static int write_to_file(dsp_worker *config, const float complex *filter_output, size_t filter_output_len) {
-  size_t n_written;
-  if (config->file != NULL) {
-    n_written = fwrite(filter_output, sizeof(float complex), filter_output_len, config->file);
-  } else if (config->gz != NULL) {
-    n_written = gzwrite(config->gz, filter_output, sizeof(float complex) * filter_output_len);
-  } else {
+static bool is_passthrough(client_config *config) {
+  return config->destination == REQUEST_DESTINATION_FILE_RAW || config->destination == REQUEST_DESTINATION_SOCKET_RAW;
+}
+
+static uint64_t get_nanos(const struct timespec *value) {
+  return (uint64_t) value->tv_sec * 1000000000ULL + (uint64_t) value->tv_nsec;
+}
+
+static uint64_t get_monotonic_nanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return get_nanos(&now);
+}
+
+static int write_to_file(dsp_worker *worker, const void *output, size_t output_len) {
+  if (worker->file == NULL) {
     fprintf(stderr, "<3>unknown file output\n");
     return -1;
   }
-  // if disk is full, then terminate the client
-  if (n_written < filter_output_len) {
-    return -1;
-  } else {
-    return 0;
+  if (!worker->start_time_set) {
+    recording_set_start_time(&worker->start_realtime, &worker->start_monotonic, worker->file);
+    worker->start_time_set = true;
   }
+  uint64_t dropped = worker->pending_dropped;
+  worker->pending_dropped = 0;
+  worker->output_bytes += output_len;
+  if (worker->stages == NULL) {
+    // if disk is full, then terminate the client
+    return recording_write(output, output_len, dropped, worker->file);
+  }
+  uint64_t start = get_monotonic_nanos();
+  int code = recording_write(output, output_len, dropped, worker->file);
+  worker->write_nanos += get_monotonic_nanos() - start;
+  return code;
 }
 
-static int write_to_socket(int client_socket, const float complex *filter_output, size_t filter_output_len) {
-  size_t total_len = filter_output_len * sizeof(float complex);
+static void subtract_nanos(struct timespec *value, uint64_t nanos) {
+  int64_t result = (int64_t) value->tv_sec * 1000000000LL + value->tv_nsec - (int64_t) nanos;
+  value->tv_sec = (time_t) (result / 1000000000LL);
+  value->tv_nsec = (long) (result % 1000000000LL);
+}
+
+static int write_to_socket(dsp_worker *worker, const void *output, size_t total_len) {
+  uint64_t start = (worker->stages != NULL ? get_monotonic_nanos() : 0);
   size_t left = total_len;
   while (left > 0) {
-    ssize_t written = write(client_socket, (char *) filter_output + (total_len - left), left);
+    ssize_t written = write(worker->config->client_socket, (const char *) output + (total_len - left), left);
     if (written < 0) {
       return -1;
     }
     left -= written;
   }
+  worker->output_bytes += total_len;
+  if (worker->stages != NULL) {
+    worker->write_nanos += get_monotonic_nanos() - start;
+  }
   return 0;
 }
 
+static void write_uint32_be(uint32_t value, uint8_t *output) {
+  output[0] = (uint8_t) (value >> 24);
+  output[1] = (uint8_t) (value >> 16);
+  output[2] = (uint8_t) (value >> 8);
+  output[3] = (uint8_t) value;
+}
+
+static int write_squelch_output(const float complex *output, size_t output_len, uint64_t sample_offset, void *ctx) {
+  dsp_worker *worker = (dsp_worker *) ctx;
+  client_config *config = worker->config;
+  if (config->destination == REQUEST_DESTINATION_FILE) {
+    // squelched samples start new capture in the recording
+    int code = recording_skip(sample_offset - worker->squelch_expected_offset, worker->file);
+    if (code != 0) {
+      return code;
+    }
+    worker->squelch_expected_offset = sample_offset + output_len;
+    return write_to_file(worker, output, sizeof(float complex) * output_len);
+  }
+  // dropped samples are not visible to the squelch, but still shift the stream
+  uint64_t offset = sample_offset + worker->total_dropped;
+  uint8_t frame[sizeof(struct squelch_frame)];
+  write_uint32_be((uint32_t) (offset >> 32), frame);
+  write_uint32_be((uint32_t) offset, frame + 4);
+  write_uint32_be((uint32_t) output_len, frame + 8);
+  int code = write_to_socket(worker, frame, sizeof(frame));
+  if (code != 0) {
+    return code;
+  }
+  return write_to_socket(worker, output, sizeof(float complex) * output_len);
+}
+
+// dropped_bytes - number of input bytes lost right before the input
+static int process_and_write(dsp_worker *worker, uint8_t *input, size_t input_len, size_t dropped_bytes) {
+  client_config *config = worker->config;
+  // convert dropped input bytes into the output samples
+  uint64_t dropped = dropped_bytes / sdr_device_get_sample_size(config->sample_format) / (worker->band_sampling_rate / config->sampling_rate);
+  worker->pending_dropped += dropped;
+  worker->total_dropped += dropped;
+  // device samples are written as is
+  if (config->destination == REQUEST_DESTINATION_FILE_RAW) {
+    return write_to_file(worker, input, input_len);
+  }
+  if (config->destination == REQUEST_DESTINATION_SOCKET_RAW) {
+    return write_to_socket(worker, input, input_len);
+  }
+  float complex *filter_output = NULL;
+  size_t filter_output_len = 0;
+  switch (config->sample_format) {
+    case SAMPLE_FORMAT_CS8: {
+      worker->xlating_process_cs8((const int8_t *) input, input_len, &filter_output, &filter_output_len, worker->filter);
+      break;
+    }
+    case SAMPLE_FORMAT_CU8: {
+      worker->xlating_process_cu8(input, input_len, &filter_output, &filter_output_len, worker->filter);
+      break;
+    }
+    case SAMPLE_FORMAT_CS16: {
+      worker->xlating_process_cs16((const int16_t *) input, input_len / sizeof(int16_t), &filter_output, &filter_output_len, worker->filter);
+      break;
+    }
+    default: {
+      fprintf(stderr, "<3>unsupported sample format: %d\n", config->sample_format);
+      break;
+    }
+  }
+  if (worker->squelch != NULL) {
+    return squelch_process(filter_output, filter_output_len, write_squelch_output, worker, worker->squelch);
+  }
+  if (config->destination == REQUEST_DESTINATION_FILE) {
+    return write_to_file(worker, filter_output, sizeof(float complex) * filter_output_len);
+  }
+  if (config->destination == REQUEST_DESTINATION_SOCKET) {
+    return write_to_socket(worker, filter_output, sizeof(float complex) * filter_output_len);
+  }
+  fprintf(stderr, "<3>unknown destination: %d\n", config->destination);
+  return -1;
+}
+
+// catch up through the time shift ring as fast as possible
+static int process_backlog(dsp_worker *worker) {
+  while (worker->backlog_position < worker->backlog_end) {
+    uint64_t expected_position = worker->backlog_position;
+    size_t len = worker->buffer_size;
+    if (worker->backlog_end - worker->backlog_position < len) {
+      len = (size_t) (worker->backlog_end - worker->backlog_position);
+    }
+    size_t read = time_shift_read(&worker->backlog_position, worker->backlog_buffer, len, worker->time_shift);
+    if (read == 0) {
+      break;
+    }
+    // catching up is slower than the device and the ring was overwritten
+    size_t dropped = (size_t) (worker->backlog_position - read - expected_position);
+    int code = process_and_write(worker, worker->backlog_buffer, read, dropped);
+    if (code != 0) {
+      return code;
+    }
+  }
+  return 0;
+}
+
+static void report_metrics(dsp_worker *worker, size_t input_len, uint64_t latency_micros, size_t dropped_bytes) {
+  server_metrics *metrics = worker->metrics;
+  metrics->buffers++;
+  metrics->input_bytes += input_len;
+  uint64_t output_bytes = worker->output_bytes;
+  metrics->output_bytes += output_bytes - worker->reported_output_bytes;
+  worker->reported_output_bytes = output_bytes;
+  uint64_t cpu_nanos = worker->cpu_nanos;
+  metrics->dsp_cpu_nanos += cpu_nanos - worker->reported_cpu_nanos;
+  worker->reported_cpu_nanos = cpu_nanos;
+  histogram_record(latency_micros, &metrics->latency);
+  // every overflow ends up as dropped bytes before the next buffer
+  if (dropped_bytes > 0) {
+    queue_stats queue_stats;
+    queue_get_stats(worker->queue, &queue_stats);
+    metrics->queue_overflows += queue_stats.overflows - worker->reported_overflows;
+    worker->reported_overflows = queue_stats.overflows;
+  }
+}
+
+static void log_summary(dsp_worker *worker, uint64_t now) {
+  queue_stats queue_stats;
+  queue_get_stats(worker->queue, &queue_stats);
+  uint64_t write_failures = worker->write_failures;
+  uint64_t overflows = queue_stats.overflows - worker->summary_overflows;
+  uint64_t failures = write_failures - worker->summary_write_failures;
+  if (overflows > 0 || failures > 0) {
+    fprintf(stderr, "<3>[%d] last %.1f seconds: queue overflows %" PRIu64 " write failures %" PRIu64 "\n", worker->config->id, (double) (now - worker->last_summary) / 1000000000.0, overflows, failures);
+  }
+  worker->summary_overflows = queue_stats.overflows;
+  worker->summary_write_failures = write_failures;
+  worker->last_summary = now;
+}
+
 static void *callback(void *arg) {
   dsp_worker *worker = (dsp_worker *) arg;
   client_config *config = worker->config;
-  fprintf(stdout, "[%d] dsp_worker started\n", config->id);
+  thread_scheduling_apply("dsp", worker->dsp_cpus, 0);
+  worker->thread_cpus = thread_scheduling_get_cpus();
+  fprintf(stdout, "[%d] dsp_worker started. cpus: 0x%" PRIx64 "\n", config->id, (uint64_t) worker->thread_cpus);
+  worker->last_summary = get_monotonic_nanos();
   uint8_t *input = NULL;
   size_t input_len = 0;
-  float complex *filter_output = NULL;
-  size_t filter_output_len = 0;
   while (true) {
     take_buffer_for_processing(&input, &input_len, worker->queue);
     // poison pill received
     if (input == NULL) {
       break;
     }
-    switch (config->sdr_type) {
-      case SDR_TYPE_HACKRF: {
-        worker->xlating_process_cs8((const int8_t *) input, input_len, &filter_output, &filter_output_len, worker->filter);
-        break;
-      }
-      case SDR_TYPE_RTL: {
-        worker->xlating_process_cu8(input, input_len, &filter_output, &filter_output_len, worker->filter);
-        break;
-      }
-      case SDR_TYPE_AIRSPY: {
-        worker->xlating_process_cs16((const int16_t *) input, input_len / sizeof(int16_t), &filter_output, &filter_output_len, worker->filter);
-        break;
-      }
-      default: {
-        fprintf(stderr, "<3>unsupported sdr type: %d\n", config->sdr_type);
-        break;
-      }
+    struct timespec put_time;
+    get_put_time_of_buffer(&put_time, worker->queue);
+    uint64_t taken = 0;
+    if (worker->stages != NULL) {
+      taken = get_monotonic_nanos();
+      histogram_record(taken - get_nanos(&put_time), worker->stages + DSP_STAGE_QUEUE_DWELL);
+      worker->write_nanos = 0;
+    }
+    int code = 0;
+    if (worker->backlog_position < worker->backlog_end) {
+      fprintf(stdout, "[%d] processing %" PRIu64 " bytes from the past\n", config->id, worker->backlog_end - worker->backlog_position);
+      code = process_backlog(worker);
+      worker->backlog_position = worker->backlog_end;
     }
-    int code;
-    if (config->destination == REQUEST_DESTINATION_FILE) {
-      code = write_to_file(worker, filter_output, filter_output_len);
-    } else if (config->destination == REQUEST_DESTINATION_SOCKET) {
-      code = write_to_socket(config->client_socket, filter_output, filter_output_len);
-    } else {
-      fprintf(stderr, "<3>unknown destination: %d\n", config->destination);
-      code = -1;
+    size_t dropped_bytes = get_dropped_before_buffer(worker->queue);
+    if (code == 0) {
+      code = process_and_write(worker, input, input_len, dropped_bytes);
     }
     complete_buffer_processing(worker->queue);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (worker->stages != NULL) {
+      uint64_t processing = get_nanos(&now) - taken;
+      histogram_record(worker->write_nanos, worker->stages + DSP_STAGE_WRITE);
+      histogram_record(processing > worker->write_nanos ? processing - worker->write_nanos : 0, worker->stages + DSP_STAGE_FILTER);
+    }
+    uint64_t finished = get_nanos(&now);
+    uint64_t latency_micros = (finished - get_nanos(&put_time)) / 1000;
+    histogram_record(latency_micros, &worker->latency);
+    worker->buffers++;
+    worker->input_bytes += input_len;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    worker->cpu_nanos = get_nanos(&now);
     if (code != 0) {
+      worker->write_failures++;
+      if (worker->metrics != NULL) {
+        worker->metrics->write_failures++;
+      }
       close(config->client_socket);
     }
+    if (worker->metrics != NULL) {
+      report_metrics(worker, input_len, latency_micros, dropped_bytes);
+    }
+    if (worker->log_summary_nanos > 0 && finished - worker->last_summary >= worker->log_summary_nanos) {
+      log_summary(worker, finished);
+    }
+  }
+  if (worker->log_summary_nanos > 0) {
+    log_summary(worker, get_monotonic_nanos());
   }
   return (void *) 0;
 }
 
-int dsp_worker_start(client_config *config, struct server_config *server_config, dsp_worker **worker) {
-  dsp_worker *result = malloc(sizeof(dsp_worker));
-  *result = (dsp_worker) {0};
-  result->config = config;
-
+static int create_filter(client_config *config, struct server_config *server_config, dsp_worker *worker) {
   // setup taps
   float *taps = NULL;
   size_t len;
   int code = create_low_pass_filter(1.0F, server_config->band_sampling_rate, config->sampling_rate / 2, config->sampling_rate / server_config->lpf_cutoff_rate, &taps, &len);
   if (code != 0) {
-    dsp_worker_destroy(result);
     return code;
   }
   // setup xlating frequency filter
-  code = create_frequency_xlating_filter(server_config->band_sampling_rate / config->sampling_rate, taps, len, (int64_t) config->center_freq - (int64_t) config->band_freq, server_config->band_sampling_rate, server_config->buffer_size, &result->filter);
+  code = create_frequency_xlating_filter(server_config->band_sampling_rate / config->sampling_rate, taps, len, (int64_t) config->center_freq - (int64_t) config->band_freq, server_config->band_sampling_rate, server_config->buffer_size, &worker->filter);
   if (code != 0) {
-    dsp_worker_destroy(result);
     return code;
   }
 
-  switch (server_config->optimization) {
+  switch (config->optimization) {
     case NATIVE_CF32:
-      result->xlating_process_cu8 = process_native_cu8_cf32;
-      result->xlating_process_cs8 = process_native_cs8_cf32;
-      result->xlating_process_cs16 = process_native_cs16_cf32;
+      worker->xlating_process_cu8 = process_native_cu8_cf32;
+      worker->xlating_process_cs8 = process_native_cs8_cf32;
+      worker->xlating_process_cs16 = process_native_cs16_cf32;
+      worker->kernel = STATS_KERNEL_NATIVE_CF32;
       break;
     case OPTIMIZED_CF32:
-      result->xlating_process_cu8 = process_optimized_cu8_cf32;
-      result->xlating_process_cs8 = process_optimized_cs8_cf32;
-      result->xlating_process_cs16 = process_optimized_cs16_cf32;
+      worker->xlating_process_cu8 = process_optimized_cu8_cf32;
+      worker->xlating_process_cs8 = process_optimized_cs8_cf32;
+      worker->xlating_process_cs16 = process_optimized_cs16_cf32;
+      worker->kernel = STATS_KERNEL_OPTIMIZED_CF32;
       break;
     default:
-      dsp_worker_destroy(result);
       return -1;
   }
+  return 0;
+}
+
+static int create_recording(client_config *config, struct server_config *server_config, dsp_worker *worker) {
+  recording_config recording_config = {
+      .id = config->id,
+      .datatype = "cf32_le",
+      .extension = "cf32",
+      .lane_size = sizeof(float),
+      .sample_rate = config->sampling_rate,
+      .center_freq = config->center_freq};
+  if (config->destination == REQUEST_DESTINATION_FILE_RAW) {
+    switch (config->sample_format) {
+      case SAMPLE_FORMAT_CU8:
+        recording_config.datatype = "cu8";
+        recording_config.extension = "cu8";
+        recording_config.lane_size = sizeof(uint8_t);
+        break;
+      case SAMPLE_FORMAT_CS8:
+        recording_config.datatype = "ci8";
+        recording_config.extension = "cs8";
+        recording_config.lane_size = sizeof(int8_t);
+        break;
+      case SAMPLE_FORMAT_CS16:
+        recording_config.datatype = "ci16_le";
+        recording_config.extension = "cs16";
+        recording_config.lane_size = sizeof(int16_t);
+        break;
+      default:
+        fprintf(stderr, "<3>unsupported sample format: %d\n", config->sample_format);
+        return -1;
+    }
+  }
+  return recording_create(&recording_config, server_config, &worker->file);
+}
+
+size_t dsp_worker_get_memory_overhead(client_config *config, struct server_config *server_config) {
+  size_t result = sizeof(dsp_worker);
+  if (server_config->stage_stats) {
+    result += sizeof(histogram) * DSP_STAGE_COUNT;
+  }
+  if (config->time_shift_millis > 0) {
+    result += server_config->buffer_size;
+  }
+  if (!is_passthrough(config)) {
+    // working and output buffers of the xlating filter in both cf32 and cs16
+    // taps and history are small compared to them
+    size_t max_samples = server_config->buffer_size / 2;
+    size_t sample_bytes = sizeof(float complex) + 2 * sizeof(int16_t);
+    uint32_t decimation = server_config->band_sampling_rate / config->sampling_rate;
+    result += max_samples * sample_bytes;
+    result += (max_samples / decimation + 1) * sample_bytes;
+  }
+  return result;
+}
 
-  if (server_config->use_gzip) {
-    char file_path[4096];
-    snprintf(file_path, sizeof(file_path), "%s/%d.cf32.gz", server_config->base_path, config->id);
-    result->gz = gzopen(file_path, "wb");
-    if (result->gz == NULL) {
-      fprintf(stderr, "<3>unable to open gz file for output: %s\n", file_path);
+int dsp_worker_start(client_config *config, struct server_config *server_config, time_shift *time_shift, server_metrics *metrics, dsp_worker **worker) {
+  dsp_worker *result = malloc(sizeof(dsp_worker));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  *result = (dsp_worker) {0};
+  result->config = config;
+  result->band_sampling_rate = server_config->band_sampling_rate;
+  result->buffer_size = server_config->buffer_size;
+  result->metrics = metrics;
+  result->log_summary_nanos = (uint64_t) server_config->log_summary_seconds * 1000000000ULL;
+  result->dsp_cpus = server_config->dsp_cpus;
+  if (server_config->stage_stats) {
+    result->stages = malloc(sizeof(histogram) * DSP_STAGE_COUNT);
+    if (result->stages == NULL) {
       dsp_worker_destroy(result);
-      return -1;
+      return -ENOMEM;
     }
-  } else {
-    char file_path[4096];
-    snprintf(file_path, sizeof(file_path), "%s/%d.cf32", server_config->base_path, config->id);
-    result->file = fopen(file_path, "wb");
-    if (result->file == NULL) {
-      fprintf(stderr, "<3>unable to open file for output: %s\n", file_path);
+    for (int i = 0; i < DSP_STAGE_COUNT; i++) {
+      histogram_reset(result->stages + i);
+    }
+  }
+  if (config->time_shift_millis > 0 && time_shift != NULL) {
+    result->time_shift = time_shift;
+    result->backlog_buffer = malloc(server_config->buffer_size);
+    if (result->backlog_buffer == NULL) {
+      dsp_worker_destroy(result);
+      return -ENOMEM;
+    }
+  }
+
+  int code;
+  // passthrough doesn't need any dsp
+  if (!is_passthrough(config)) {
+    code = create_filter(config, server_config, result);
+    if (code != 0) {
+      dsp_worker_destroy(result);
+      return code;
+    }
+  }
+
+  if (config->squelch) {
+    code = squelch_create(config->sampling_rate, config->squelch_threshold_db, config->squelch_hang_ms, config->squelch_preroll_ms, &result->squelch);
+    if (code != 0) {
+      dsp_worker_destroy(result);
+      return code;
+    }
+  }
+
+  if (config->destination == REQUEST_DESTINATION_FILE || config->destination == REQUEST_DESTINATION_FILE_RAW) {
+    code = create_recording(config, server_config, result);
+    if (code != 0) {
       dsp_worker_destroy(result);
       return -1;
     }
   }
 
   // setup queue
-  code = create_queue(server_config->buffer_size, server_config->queue_size, &result->queue);
+  code = create_queue(server_config->buffer_size, config->queue_size, &result->queue);
   if (code != 0) {
     dsp_worker_destroy(result);
     return -1;
@@ -165,10 +438,60 @@ int dsp_worker_start(client_config *config, struct server_config *server_config,
     return -1;
   }
   result->dsp_thread = dsp_thread;
+  result->memory_bytes = dsp_worker_get_memory_overhead(config, server_config) + (size_t) config->queue_size * server_config->buffer_size;
+  if (metrics != NULL) {
+    metrics->clients++;
+    metrics->memory_bytes += result->memory_bytes;
+    metrics->dsp_load_millicores += config->cpu_cost_millicores;
+  }
   *worker = result;
   return 0;
 }
 
+void dsp_worker_get_stats(dsp_worker *worker, dsp_worker_stats *stats) {
+  stats->buffers = worker->buffers;
+  stats->input_bytes = worker->input_bytes;
+  stats->output_bytes = worker->output_bytes;
+  queue_stats queue_stats;
+  queue_get_stats(worker->queue, &queue_stats);
+  stats->queue_overflows = queue_stats.overflows;
+  stats->queue_depth = queue_stats.depth;
+  stats->write_failures = worker->write_failures;
+  stats->kernel = worker->kernel;
+  stats->cpu_nanos = worker->cpu_nanos;
+  stats->thread_cpus = worker->thread_cpus;
+  stats->memory_bytes = worker->memory_bytes;
+  stats->latency_p50_micros = histogram_percentile(50.0, &worker->latency);
+  stats->latency_p99_micros = histogram_percentile(99.0, &worker->latency);
+  stats->latency_max_micros = worker->latency.max;
+  for (int i = 0; i < DSP_STAGE_COUNT; i++) {
+    if (worker->stages == NULL) {
+      stats->stage_p50_nanos[i] = 0;
+      stats->stage_p99_nanos[i] = 0;
+      stats->stage_max_nanos[i] = 0;
+      continue;
+    }
+    stats->stage_p50_nanos[i] = histogram_percentile(50.0, worker->stages + i);
+    stats->stage_p99_nanos[i] = histogram_percentile(99.0, worker->stages + i);
+    stats->stage_max_nanos[i] = worker->stages[i].max;
+  }
+}
+
+const char *dsp_worker_get_stage_name(dsp_stage stage) {
+  switch (stage) {
+    case DSP_STAGE_QUEUE_PUT:
+      return "queue_put";
+    case DSP_STAGE_QUEUE_DWELL:
+      return "queue_dwell";
+    case DSP_STAGE_FILTER:
+      return "filter";
+    case DSP_STAGE_WRITE:
+      return "write";
+    default:
+      return "unknown";
+  }
+}
+
 void dsp_worker_destroy(dsp_worker *node) {
   if (node == NULL) {
     return;
@@ -181,24 +504,61 @@ void dsp_worker_destroy(dsp_worker *node) {
   if (node->dsp_thread != NULL) {
     pthread_join(*node->dsp_thread, NULL);
     free(node->dsp_thread);
+    if (node->metrics != NULL) {
+      node->metrics->clients--;
+      node->metrics->memory_bytes -= node->memory_bytes;
+      node->metrics->dsp_load_millicores -= node->config->cpu_cost_millicores;
+    }
   }
   // cleanup everything only when thread terminates
   if (node->queue != NULL) {
     destroy_queue(node->queue);
   }
   if (node->file != NULL) {
-    fclose(node->file);
-  }
-  if (node->gz != NULL) {
-    gzclose(node->gz);
+    recording_destroy(node->file);
   }
   if (node->filter != NULL) {
     destroy_xlating(node->filter);
   }
+  if (node->backlog_buffer != NULL) {
+    free(node->backlog_buffer);
+  }
+  if (node->squelch != NULL) {
+    squelch_destroy(node->squelch);
+  }
+  if (node->stages != NULL) {
+    free(node->stages);
+  }
   printf("[%d] dsp_worker stopped\n", node->config->id);
   free(node);
 }
 
-void dsp_worker_process(uint8_t *buf, uint32_t buf_len, dsp_worker *config) {
-  queue_put(buf, buf_len, config->queue);
+void dsp_worker_process(uint8_t *buf, uint32_t buf_len, size_t lost_bytes, dsp_worker *config) {
+  if (!config->start_time_received) {
+    // samples lost before the very first buffer don't matter
+    lost_bytes = 0;
+    size_t sample_size = sdr_device_get_sample_size(config->config->sample_format);
+    // the buffer has just been received. the first sample is older
+    uint64_t buffer_ns = (uint64_t) buf_len / sample_size * 1000000000ULL / config->band_sampling_rate;
+    if (config->time_shift != NULL) {
+      // the buffer is not in the ring yet, so the backlog ends right before it
+      config->backlog_end = time_shift_get_position(config->time_shift);
+      uint64_t requested = (uint64_t) config->config->time_shift_millis * config->band_sampling_rate / 1000 * sample_size;
+      uint64_t oldest = time_shift_get_oldest(config->time_shift);
+      config->backlog_position = (config->backlog_end - oldest > requested ? config->backlog_end - requested : oldest);
+      buffer_ns += (config->backlog_end - config->backlog_position) / sample_size * 1000000000ULL / config->band_sampling_rate;
+    }
+    clock_gettime(CLOCK_REALTIME, &config->start_realtime);
+    clock_gettime(CLOCK_MONOTONIC, &config->start_monotonic);
+    subtract_nanos(&config->start_realtime, buffer_ns);
+    subtract_nanos(&config->start_monotonic, buffer_ns);
+    config->start_time_received = true;
+  }
+  if (config->stages == NULL) {
+    queue_put_after_gap(buf, buf_len, lost_bytes, config->queue);
+    return;
+  }
+  uint64_t start = get_monotonic_nanos();
+  queue_put_after_gap(buf, buf_len, lost_bytes, config->queue);
+  histogram_record(get_monotonic_nanos() - start, config->stages + DSP_STAGE_QUEUE_PUT);
 }
\ No newline at end of file
@@ -4,11 +4,15 @@
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdint.h>
-#include <stdio.h>
-#include <zlib.h>
+#include <time.h>
 
 #include "config.h"
+#include "histogram.h"
+#include "metrics.h"
 #include "queue.h"
+#include "recording.h"
+#include "squelch.h"
+#include "time_shift.h"
 #include "xlating.h"
 
 typedef struct {
@@ -18,10 +22,66 @@ typedef struct {
   uint8_t destination;
   int client_socket;
   uint32_t id;
-  sdr_type_t sdr_type;
+  sample_format_t sample_format;
+  // start the stream in the past
+  uint32_t time_shift_millis;
+  // send or record only when signal is present
+  bool squelch;
+  uint8_t squelch_threshold_db;
+  uint32_t squelch_hang_ms;
+  uint32_t squelch_preroll_ms;
+  // number of buffers in the queue. Might be less than server's queue_size if memory_budget_mb is set
+  int queue_size;
+  // estimated at admission. 0 if cpu_budget_percent is not set
+  uint64_t cpu_cost_millicores;
+  // resolved by the server. Never AUTO_CF32
+  cpu_optimization optimization;
   bool is_running;
 } client_config;
 
+// enabled by stage_stats
+typedef enum {
+  // device thread copies the buffer into the client's queue
+  DSP_STAGE_QUEUE_PUT = 0,
+  // from queue_put until dsp thread took the buffer
+  DSP_STAGE_QUEUE_DWELL = 1,
+  // xlating filter and squelch
+  DSP_STAGE_FILTER = 2,
+  // write_to_socket or write_to_file
+  DSP_STAGE_WRITE = 3,
+  DSP_STAGE_COUNT = 4
+} dsp_stage;
+
+// counters since the client was started
+typedef struct {
+  uint64_t buffers;
+  uint64_t input_bytes;
+  // written to the socket or to the file
+  uint64_t output_bytes;
+  // input buffers overwritten because dsp thread was too slow
+  uint64_t queue_overflows;
+  // unable to write to the socket or to the file
+  uint64_t write_failures;
+  // buffers waiting in the queue
+  uint32_t queue_depth;
+  // one of STATS_KERNEL_*
+  uint8_t kernel;
+  // cpu time of the dsp thread
+  uint64_t cpu_nanos;
+  // cpus the dsp thread is allowed to run on
+  uint64_t thread_cpus;
+  // approximate memory allocated for the client
+  uint64_t memory_bytes;
+  // from queue_put until the buffer was processed and written
+  uint64_t latency_p50_micros;
+  uint64_t latency_p99_micros;
+  uint64_t latency_max_micros;
+  // 0 if stage_stats disabled
+  uint64_t stage_p50_nanos[DSP_STAGE_COUNT];
+  uint64_t stage_p99_nanos[DSP_STAGE_COUNT];
+  uint64_t stage_max_nanos[DSP_STAGE_COUNT];
+} dsp_worker_stats;
+
 typedef struct {
   client_config *config;
 
@@ -33,14 +93,76 @@ typedef struct {
 
   queue *queue;
   xlating *filter;
+  // one of STATS_KERNEL_*
+  uint8_t kernel;
   pthread_t *dsp_thread;
-  FILE *file;
-  gzFile gz;
+  recording *file;
+
+  uint32_t band_sampling_rate;
+  // written by the sdr thread before the first buffer is queued
+  bool start_time_received;
+  struct timespec start_realtime;
+  struct timespec start_monotonic;
+  // accessed by the dsp thread only
+  bool start_time_set;
+
+  // backlog is the data from the time shift ring between backlog_position and backlog_end
+  // it is processed before the first buffer from the queue
+  time_shift *time_shift;
+  uint64_t backlog_position;
+  uint64_t backlog_end;
+  uint8_t *backlog_buffer;
+  uint32_t buffer_size;
+
+  squelch *squelch;
+  // output samples dropped, but not reported yet
+  uint64_t pending_dropped;
+  uint64_t total_dropped;
+  // the next sample offset expected from the squelch
+  uint64_t squelch_expected_offset;
+
+  // written by the dsp thread only
+  atomic_uint_fast64_t buffers;
+  atomic_uint_fast64_t input_bytes;
+  atomic_uint_fast64_t output_bytes;
+  atomic_uint_fast64_t cpu_nanos;
+  atomic_uint_fast64_t write_failures;
+  atomic_uint_fast64_t thread_cpus;
+  histogram latency;
+  // NULL if stage_stats disabled. Each stage is written by one thread
+  histogram *stages;
+  // time spent writing the current buffer
+  uint64_t write_nanos;
+  // server-wide totals. Updated by the dsp thread after every buffer
+  server_metrics *metrics;
+  uint64_t reported_output_bytes;
+  uint64_t reported_cpu_nanos;
+  uint64_t reported_overflows;
+  // periodic log of the hot path counters
+  uint64_t log_summary_nanos;
+  uint64_t dsp_cpus;
+  uint64_t last_summary;
+  uint64_t summary_overflows;
+  uint64_t summary_write_failures;
+  // accounted in metrics->memory_bytes
+  size_t memory_bytes;
 } dsp_worker;
 
-int dsp_worker_start(client_config *config, struct server_config *server_config, dsp_worker **worker);
+// time_shift - optional. ring with the recent data from the device
+// metrics - optional. server-wide totals
+int dsp_worker_start(client_config *config, struct server_config *server_config, time_shift *time_shift, server_metrics *metrics, dsp_worker **worker);
+
+// approximate memory of the client except the queue: filter buffers, backlog and histograms
+// queue takes config->queue_size * buffer_size on top
+size_t dsp_worker_get_memory_overhead(client_config *config, struct server_config *server_config);
+
+// lost_bytes - number of bytes the device lost right before the buffer
+void dsp_worker_process(uint8_t *buf, uint32_t buf_len, size_t lost_bytes, dsp_worker *worker);
+
+// can be called from any thread while the worker is running
+void dsp_worker_get_stats(dsp_worker *worker, dsp_worker_stats *stats);
 
-void dsp_worker_process(uint8_t *buf, uint32_t buf_len, dsp_worker *worker);
+const char *dsp_worker_get_stage_name(dsp_stage stage);
 
 void dsp_worker_destroy(dsp_worker *worker);
 
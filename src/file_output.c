@@ -0,0 +1,320 @@
+#include "file_output.h"
+
+#include <errno.h>
+#include <lz4frame.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include "parallel_gzip.h"
+#include "sample_filter.h"
+
+struct file_output_t {
+  file_compression compression;
+  FILE *file;
+  gzFile gz;
+  parallel_gzip *parallel_gz;
+  ZSTD_CCtx *zstd;
+  LZ4F_cctx *lz4;
+  gzip_index *index;
+
+  // zstd and lz4 only
+  sample_filter_header header;
+  uint8_t *block;
+  size_t block_len;
+  uint8_t *filtered;
+  uint8_t *compressed;
+  size_t compressed_capacity;
+  uint64_t total_len;
+  bool started;
+};
+
+static int write_bytes(const void *buffer, size_t len, file_output *output) {
+  if (fwrite(buffer, sizeof(uint8_t), len, output->file) != len) {
+    return -1;
+  }
+  return 0;
+}
+
+// full flush resets the dictionary, so the next block can be inflated from this point
+static int add_gzip_index(file_output *output) {
+  if (gzflush(output->gz, Z_FULL_FLUSH) != Z_OK) {
+    return -1;
+  }
+  z_off_t compressed = gzoffset(output->gz);
+  if (compressed < 0) {
+    return -1;
+  }
+  return gzip_index_add(output->total_len, (uint64_t)compressed, output->index);
+}
+
+static int compress_zstd(const uint8_t *input, size_t len, ZSTD_EndDirective mode, file_output *output) {
+  ZSTD_inBuffer in = {input, len, 0};
+  while (true) {
+    ZSTD_outBuffer out = {output->compressed, output->compressed_capacity, 0};
+    size_t remaining = ZSTD_compressStream2(output->zstd, &out, &in, mode);
+    if (ZSTD_isError(remaining)) {
+      return -1;
+    }
+    if (write_bytes(output->compressed, out.pos, output) != 0) {
+      return -1;
+    }
+    if (mode == ZSTD_e_end && remaining == 0) {
+      return 0;
+    }
+    if (mode != ZSTD_e_end && in.pos == in.size) {
+      return 0;
+    }
+  }
+}
+
+static int compress_block(file_output *output) {
+  if (output->block_len == 0) {
+    return 0;
+  }
+  sample_filter_encode(output->block, output->block_len, &output->header, output->filtered);
+  int code;
+  if (output->compression == COMPRESSION_ZSTD) {
+    code = compress_zstd(output->filtered, output->block_len, ZSTD_e_continue, output);
+  } else {
+    size_t written = LZ4F_compressUpdate(output->lz4, output->compressed, output->compressed_capacity, output->filtered, output->block_len, NULL);
+    if (LZ4F_isError(written)) {
+      code = -1;
+    } else {
+      code = write_bytes(output->compressed, written, output);
+    }
+  }
+  output->total_len += output->block_len;
+  output->block_len = 0;
+  return code;
+}
+
+static int file_output_finish(file_output *output) {
+  if (compress_block(output) != 0) {
+    return -1;
+  }
+  if (output->compression == COMPRESSION_ZSTD) {
+    if (compress_zstd(NULL, 0, ZSTD_e_end, output) != 0) {
+      return -1;
+    }
+  } else {
+    size_t written = LZ4F_compressEnd(output->lz4, output->compressed, output->compressed_capacity, NULL);
+    if (LZ4F_isError(written) || write_bytes(output->compressed, written, output) != 0) {
+      return -1;
+    }
+  }
+  uint8_t trailer[SAMPLE_FILTER_TRAILER_SIZE];
+  sample_filter_format_trailer(output->total_len, trailer);
+  return write_bytes(trailer, sizeof(trailer), output);
+}
+
+static int file_output_create_compressed(struct server_config *server_config, file_output *result) {
+  result->block = malloc(sizeof(uint8_t) * SAMPLE_FILTER_BLOCK_SIZE);
+  result->filtered = malloc(sizeof(uint8_t) * SAMPLE_FILTER_BLOCK_SIZE);
+  if (result->block == NULL || result->filtered == NULL) {
+    return -ENOMEM;
+  }
+  LZ4F_preferences_t preferences = {0};
+  if (result->compression == COMPRESSION_ZSTD) {
+    result->zstd = ZSTD_createCCtx();
+    if (result->zstd == NULL) {
+      return -ENOMEM;
+    }
+    if (ZSTD_isError(ZSTD_CCtx_setParameter(result->zstd, ZSTD_c_compressionLevel, server_config->compression_level))) {
+      return -1;
+    }
+    result->compressed_capacity = ZSTD_CStreamOutSize();
+  } else {
+    if (LZ4F_isError(LZ4F_createCompressionContext(&result->lz4, LZ4F_VERSION))) {
+      return -1;
+    }
+    preferences.compressionLevel = server_config->compression_level;
+    preferences.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    // should fit the frame header, the biggest block and the frame end
+    result->compressed_capacity = LZ4F_compressBound(SAMPLE_FILTER_BLOCK_SIZE, &preferences) + LZ4F_HEADER_SIZE_MAX;
+  }
+  result->compressed = malloc(sizeof(uint8_t) * result->compressed_capacity);
+  if (result->compressed == NULL) {
+    return -ENOMEM;
+  }
+  // the header goes before the compressed frame so that the reader knows how to unfilter the data
+  uint8_t header[SAMPLE_FILTER_HEADER_SIZE];
+  sample_filter_format_header(&result->header, header);
+  if (write_bytes(header, sizeof(header), result) != 0) {
+    return -1;
+  }
+  if (result->lz4 != NULL) {
+    size_t written = LZ4F_compressBegin(result->lz4, result->compressed, result->compressed_capacity, &preferences);
+    if (LZ4F_isError(written) || write_bytes(result->compressed, written, result) != 0) {
+      return -1;
+    }
+  }
+  result->started = true;
+  return 0;
+}
+
+const char *file_output_get_extension(file_compression compression) {
+  switch (compression) {
+    case COMPRESSION_GZIP:
+      return ".gz";
+    case COMPRESSION_ZSTD:
+      return ".zst";
+    case COMPRESSION_LZ4:
+      return ".lz4";
+    default:
+      return "";
+  }
+}
+
+int file_output_create(const char *file_path, uint8_t lane_size, struct server_config *server_config, file_output **output) {
+  struct file_output_t *result = malloc(sizeof(struct file_output_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *result = (struct file_output_t){0};
+  result->compression = config_get_compression(server_config);
+  result->header.filter = server_config->compression_filter;
+  result->header.lane_size = lane_size;
+  result->header.block_size = SAMPLE_FILTER_BLOCK_SIZE;
+
+  char full_path[4096];
+  snprintf(full_path, sizeof(full_path), "%s%s", file_path, file_output_get_extension(result->compression));
+  // compression_level was validated for another compression
+  int level = (result->compression == server_config->compression) ? server_config->compression_level : Z_DEFAULT_COMPRESSION;
+  int code = 0;
+  switch (result->compression) {
+    case COMPRESSION_NONE:
+      result->file = fopen(full_path, "wb");
+      if (result->file == NULL) {
+        code = -1;
+      }
+      break;
+    case COMPRESSION_GZIP:
+      if (server_config->gzip_index_interval > 0) {
+        code = gzip_index_create(full_path, server_config->gzip_index_interval, &result->index);
+        if (code != 0) {
+          break;
+        }
+      }
+      if (server_config->gzip_threads > 1) {
+        code = parallel_gzip_create(full_path, level, server_config->gzip_threads, result->index, &result->parallel_gz);
+      } else {
+        char mode[4] = "wb";
+        if (level >= 0) {
+          snprintf(mode, sizeof(mode), "wb%d", level);
+        }
+        result->gz = gzopen(full_path, mode);
+        if (result->gz == NULL) {
+          code = -1;
+        } else if (result->index != NULL) {
+          code = add_gzip_index(result);
+        }
+      }
+      break;
+    case COMPRESSION_ZSTD:
+    case COMPRESSION_LZ4:
+      result->file = fopen(full_path, "wb");
+      if (result->file == NULL) {
+        code = -1;
+      } else {
+        code = file_output_create_compressed(server_config, result);
+      }
+      break;
+    default:
+      code = -1;
+      break;
+  }
+  if (code != 0) {
+    fprintf(stderr, "<3>unable to open file for output: %s\n", full_path);
+    file_output_destroy(result);
+    return code;
+  }
+  *output = result;
+  return 0;
+}
+
+int file_output_write(const void *buffer, size_t len, file_output *output) {
+  switch (output->compression) {
+    case COMPRESSION_NONE:
+      return write_bytes(buffer, len, output);
+    case COMPRESSION_GZIP:
+      output->total_len += len;
+      if (output->parallel_gz != NULL) {
+        return parallel_gzip_write(buffer, len, output->parallel_gz);
+      }
+      if (gzwrite(output->gz, buffer, (unsigned int)len) != (int)len) {
+        return -1;
+      }
+      if (output->index != NULL && gzip_index_is_due(output->total_len, output->index)) {
+        return add_gzip_index(output);
+      }
+      return 0;
+    case COMPRESSION_ZSTD:
+    case COMPRESSION_LZ4: {
+      // filter works on the full blocks, so that reader can unfilter block by block
+      const uint8_t *input = (const uint8_t *)buffer;
+      while (len > 0) {
+        size_t to_copy = SAMPLE_FILTER_BLOCK_SIZE - output->block_len;
+        if (to_copy > len) {
+          to_copy = len;
+        }
+        memcpy(output->block + output->block_len, input, to_copy);
+        output->block_len += to_copy;
+        input += to_copy;
+        len -= to_copy;
+        if (output->block_len == SAMPLE_FILTER_BLOCK_SIZE && compress_block(output) != 0) {
+          return -1;
+        }
+      }
+      return 0;
+    }
+    default:
+      return -1;
+  }
+}
+
+void file_output_destroy(file_output *output) {
+  if (output == NULL) {
+    return;
+  }
+  if (output->started && file_output_finish(output) != 0) {
+    fprintf(stderr, "<3>unable to complete the file\n");
+  }
+  if (output->file != NULL) {
+    fclose(output->file);
+  }
+  int gz_code = 0;
+  if (output->gz != NULL) {
+    gz_code = gzclose(output->gz);
+  }
+  if (output->parallel_gz != NULL) {
+    gz_code = parallel_gzip_destroy(output->parallel_gz);
+  }
+  if (output->index != NULL) {
+    // incomplete index is ignored by readers
+    if (gz_code == Z_OK && gzip_index_finish(output->total_len, output->index) != 0) {
+      fprintf(stderr, "<3>unable to complete the gzip index\n");
+    }
+    gzip_index_destroy(output->index);
+  }
+  if (output->zstd != NULL) {
+    ZSTD_freeCCtx(output->zstd);
+  }
+  if (output->lz4 != NULL) {
+    LZ4F_freeCompressionContext(output->lz4);
+  }
+  if (output->block != NULL) {
+    free(output->block);
+  }
+  if (output->filtered != NULL) {
+    free(output->filtered);
+  }
+  if (output->compressed != NULL) {
+    free(output->compressed);
+  }
+  free(output);
+}
@@ -0,0 +1,22 @@
+#ifndef FILE_OUTPUT_H_
+#define FILE_OUTPUT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+typedef struct file_output_t file_output;
+
+// file_path is without compression extension. it will be added based on config_get_compression
+// lane_size is the size of a single I or Q value. used by the compression_filter
+int file_output_create(const char *file_path, uint8_t lane_size, struct server_config *server_config, file_output **output);
+
+int file_output_write(const void *buffer, size_t len, file_output *output);
+
+void file_output_destroy(file_output *output);
+
+// extension added to the file_path. empty string for uncompressed files
+const char *file_output_get_extension(file_compression compression);
+
+#endif /* FILE_OUTPUT_H_ */
@@ -0,0 +1,145 @@
+#include "gzip_index.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_MAGIC "SDRGZIX1"
+#define INDEX_MAGIC_SIZE 8
+#define ENTRY_SIZE 16
+// the last entry has this compressed offset
+#define INDEX_COMPLETE UINT64_MAX
+
+struct gzip_index_t {
+  FILE *file;
+  uint32_t interval;
+  uint64_t next;
+};
+
+static void write_uint64(uint64_t value, uint8_t *output) {
+  for (int i = 0; i < 8; i++) {
+    output[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint64_t read_uint64(const uint8_t *input) {
+  uint64_t result = 0;
+  for (int i = 0; i < 8; i++) {
+    result |= ((uint64_t)input[i]) << (8 * i);
+  }
+  return result;
+}
+
+static int write_entry(uint64_t uncompressed, uint64_t compressed, gzip_index *index) {
+  uint8_t buffer[ENTRY_SIZE];
+  write_uint64(uncompressed, buffer);
+  write_uint64(compressed, buffer + 8);
+  if (fwrite(buffer, sizeof(uint8_t), sizeof(buffer), index->file) != sizeof(buffer)) {
+    return -1;
+  }
+  return 0;
+}
+
+int gzip_index_create(const char *gz_file_path, uint32_t interval, gzip_index **index) {
+  if (interval == 0) {
+    return -1;
+  }
+  struct gzip_index_t *result = malloc(sizeof(struct gzip_index_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  *result = (struct gzip_index_t){0};
+  result->interval = interval;
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s%s", gz_file_path, GZIP_INDEX_EXTENSION);
+  result->file = fopen(file_path, "wb");
+  if (result->file == NULL) {
+    gzip_index_destroy(result);
+    return -1;
+  }
+  if (fwrite(INDEX_MAGIC, sizeof(uint8_t), INDEX_MAGIC_SIZE, result->file) != INDEX_MAGIC_SIZE) {
+    gzip_index_destroy(result);
+    return -1;
+  }
+  *index = result;
+  return 0;
+}
+
+bool gzip_index_is_due(uint64_t uncompressed, gzip_index *index) {
+  return uncompressed >= index->next;
+}
+
+int gzip_index_add(uint64_t uncompressed, uint64_t compressed, gzip_index *index) {
+  index->next = uncompressed + index->interval;
+  return write_entry(uncompressed, compressed, index);
+}
+
+int gzip_index_finish(uint64_t total_uncompressed, gzip_index *index) {
+  return write_entry(total_uncompressed, INDEX_COMPLETE, index);
+}
+
+void gzip_index_destroy(gzip_index *index) {
+  if (index == NULL) {
+    return;
+  }
+  if (index->file != NULL) {
+    fclose(index->file);
+  }
+  free(index);
+}
+
+int gzip_index_load(const char *gz_file_path, gzip_index_entry **entries, size_t *entries_len) {
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s%s", gz_file_path, GZIP_INDEX_EXTENSION);
+  FILE *fp = fopen(file_path, "rb");
+  if (fp == NULL) {
+    return -1;
+  }
+  uint8_t magic[INDEX_MAGIC_SIZE];
+  if (fread(magic, sizeof(uint8_t), sizeof(magic), fp) != sizeof(magic) || memcmp(magic, INDEX_MAGIC, INDEX_MAGIC_SIZE) != 0) {
+    fclose(fp);
+    return -1;
+  }
+  if (fseek(fp, 0L, SEEK_END) != 0) {
+    fclose(fp);
+    return -1;
+  }
+  long file_size = ftell(fp);
+  if (file_size < 0 || (file_size - INDEX_MAGIC_SIZE) % ENTRY_SIZE != 0 || file_size - INDEX_MAGIC_SIZE < 2 * ENTRY_SIZE) {
+    fclose(fp);
+    return -1;
+  }
+  size_t result_len = (size_t)(file_size - INDEX_MAGIC_SIZE) / ENTRY_SIZE;
+  gzip_index_entry *result = malloc(sizeof(gzip_index_entry) * result_len);
+  if (result == NULL) {
+    fclose(fp);
+    return -ENOMEM;
+  }
+  fseek(fp, INDEX_MAGIC_SIZE, SEEK_SET);
+  uint8_t buffer[ENTRY_SIZE];
+  for (size_t i = 0; i < result_len; i++) {
+    if (fread(buffer, sizeof(uint8_t), sizeof(buffer), fp) != sizeof(buffer)) {
+      free(result);
+      fclose(fp);
+      return -1;
+    }
+    result[i].uncompressed = read_uint64(buffer);
+    result[i].compressed = read_uint64(buffer + 8);
+    // offsets should always increase
+    if (i > 0 && (result[i].uncompressed < result[i - 1].uncompressed || result[i].compressed <= result[i - 1].compressed)) {
+      free(result);
+      fclose(fp);
+      return -1;
+    }
+  }
+  fclose(fp);
+  // server might crash before the file is completed
+  if (result[0].uncompressed != 0 || result[result_len - 1].compressed != INDEX_COMPLETE) {
+    free(result);
+    return -1;
+  }
+  *entries = result;
+  *entries_len = result_len;
+  return 0;
+}
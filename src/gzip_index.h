@@ -0,0 +1,36 @@
+#ifndef GZIP_INDEX_H_
+#define GZIP_INDEX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// index is stored next to the .gz file
+#define GZIP_INDEX_EXTENSION ".idx"
+
+// compressed offset points to the beginning of a raw deflate block.
+// it doesn't depend on the previous data and can be inflated on its own
+typedef struct {
+  uint64_t uncompressed;
+  uint64_t compressed;
+} gzip_index_entry;
+
+typedef struct gzip_index_t gzip_index;
+
+int gzip_index_create(const char *gz_file_path, uint32_t interval, gzip_index **index);
+
+// true if the next flush point should be added
+bool gzip_index_is_due(uint64_t uncompressed, gzip_index *index);
+
+int gzip_index_add(uint64_t uncompressed, uint64_t compressed, gzip_index *index);
+
+// total length is not limited by 4Gb as ISIZE in the gzip trailer
+int gzip_index_finish(uint64_t total_uncompressed, gzip_index *index);
+
+void gzip_index_destroy(gzip_index *index);
+
+// returns non-zero if index doesn't exist or not complete
+// the last entry contains total uncompressed length
+int gzip_index_load(const char *gz_file_path, gzip_index_entry **entries, size_t *entries_len);
+
+#endif /* GZIP_INDEX_H_ */
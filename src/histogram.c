@@ -0,0 +1,76 @@
+#include "histogram.h"
+
+static int get_bucket(uint64_t value) {
+  if (value < HISTOGRAM_SUB_BUCKETS) {
+    return (int)value;
+  }
+  int msb = 63 - __builtin_clzll(value);
+  // 3 is log2 of HISTOGRAM_SUB_BUCKETS
+  int shift = msb - 3;
+  int index = (shift + 1) * HISTOGRAM_SUB_BUCKETS + (int)((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+  if (index >= HISTOGRAM_BUCKETS) {
+    return HISTOGRAM_BUCKETS - 1;
+  }
+  return index;
+}
+
+uint64_t histogram_get_upper_bound(int index) {
+  if (index < HISTOGRAM_SUB_BUCKETS) {
+    return (uint64_t)index;
+  }
+  int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+  uint64_t lower = (uint64_t)(HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << shift;
+  return lower + ((uint64_t)1 << shift) - 1;
+}
+
+void histogram_reset(histogram *histogram) {
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    histogram->counts[i] = 0;
+  }
+  histogram->count = 0;
+  histogram->sum = 0;
+  histogram->max = 0;
+}
+
+void histogram_record(uint64_t value, histogram *histogram) {
+  histogram->counts[get_bucket(value)]++;
+  histogram->count++;
+  histogram->sum += value;
+  uint_fast64_t max = histogram->max;
+  while (value > max && !atomic_compare_exchange_weak(&histogram->max, &max, value)) {
+  }
+}
+
+uint64_t histogram_percentile(double percentile, histogram *histogram) {
+  uint64_t total = 0;
+  uint64_t counts[HISTOGRAM_BUCKETS];
+  // writer might update buckets in the meantime. Use the consistent total
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    counts[i] = histogram->counts[i];
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+  if (rank == 0) {
+    rank = 1;
+  }
+  if (rank > total) {
+    rank = total;
+  }
+  uint64_t max = histogram->max;
+  uint64_t seen = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      uint64_t result = histogram_get_upper_bound(i);
+      // the last bucket is open-ended
+      if (result > max || i == HISTOGRAM_BUCKETS - 1) {
+        return max;
+      }
+      return result;
+    }
+  }
+  return max;
+}
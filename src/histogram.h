@@ -0,0 +1,30 @@
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// log-linear buckets: every power of 2 is split into 8 buckets, so the error is within 12.5%
+// values above 2^32 go into the last bucket
+#define HISTOGRAM_SUB_BUCKETS 8
+#define HISTOGRAM_BUCKETS (30 * HISTOGRAM_SUB_BUCKETS)
+
+// fixed size and no locks. Can be embedded and updated from several threads while read from others
+typedef struct {
+  atomic_uint_fast64_t counts[HISTOGRAM_BUCKETS];
+  atomic_uint_fast64_t count;
+  atomic_uint_fast64_t sum;
+  atomic_uint_fast64_t max;
+} histogram;
+
+void histogram_reset(histogram *histogram);
+
+void histogram_record(uint64_t value, histogram *histogram);
+
+// percentile - from 0.0 to 100.0. Returns the upper bound of the bucket or 0 if nothing recorded
+uint64_t histogram_percentile(double percentile, histogram *histogram);
+
+// the biggest value that goes into the bucket
+uint64_t histogram_get_upper_bound(int index);
+
+#endif /* HISTOGRAM_H_ */
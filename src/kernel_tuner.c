@@ -0,0 +1,295 @@
+#include "kernel_tuner.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+#include "api.h"
+#include "dsp_cost.h"
+#include "lpf.h"
+#include "sdr_device.h"
+
+// hash of the kernel sources, compiler and flags. See CMakeLists.txt
+#ifdef KERNEL_BUILD_ID
+#define KERNEL_TUNER_BUILD KERNEL_BUILD_ID
+#else
+#ifndef CMAKE_C_FLAGS
+#define CMAKE_C_FLAGS ""
+#endif
+#ifdef NO_MANUAL_SIMD
+#define KERNEL_TUNER_SIMD "NO_MANUAL_SIMD"
+#else
+#define KERNEL_TUNER_SIMD "MANUAL_SIMD"
+#endif
+#define KERNEL_TUNER_BUILD __VERSION__ " " CMAKE_C_FLAGS " " KERNEL_TUNER_SIMD
+#endif
+
+#define KERNEL_TUNER_MAX_ENTRIES 64
+#define KERNEL_TUNER_MAX_LINE 1024
+// the kernels are timed in turns, so that cpu frequency changes affect both of them
+#define KERNEL_TUNER_ROUNDS 3
+// smaller difference is within the measurement noise
+#define KERNEL_TUNER_TIE_PERCENT 5
+
+typedef struct {
+  sample_format_t format;
+  uint32_t taps_len;
+  uint32_t decimation;
+  uint32_t buffer_size;
+  cpu_optimization optimization;
+  // near ties are timed again after restart
+  bool persistent;
+} kernel_tuner_entry;
+
+struct kernel_tuner_t {
+  // NULL - results are not saved
+  char *cache_file;
+  char cpu[KERNEL_TUNER_MAX_LINE];
+  kernel_tuner_entry entries[KERNEL_TUNER_MAX_ENTRIES];
+  size_t entries_len;
+  pthread_mutex_t mutex;
+};
+
+static const char *format_kernel(cpu_optimization value) {
+  return (value == OPTIMIZED_CF32) ? "OPTIMIZED_CF32" : "NATIVE_CF32";
+}
+
+static void read_cpu_model(char *output, size_t output_len) {
+  snprintf(output, output_len, "unknown");
+#ifdef __APPLE__
+  size_t len = output_len;
+  if (sysctlbyname("machdep.cpu.brand_string", output, &len, NULL, 0) != 0) {
+    snprintf(output, output_len, "unknown");
+  }
+#else
+  FILE *fp = fopen("/proc/cpuinfo", "r");
+  if (fp == NULL) {
+    return;
+  }
+  char line[KERNEL_TUNER_MAX_LINE];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    // x86 and raspberry pi
+    if (strncmp(line, "model name", strlen("model name")) != 0 && strncmp(line, "Model", strlen("Model")) != 0 && strncmp(line, "CPU part", strlen("CPU part")) != 0) {
+      continue;
+    }
+    char *value = strchr(line, ':');
+    if (value == NULL) {
+      continue;
+    }
+    value++;
+    while (*value == ' ' || *value == '\t') {
+      value++;
+    }
+    value[strcspn(value, "\n")] = '\0';
+    snprintf(output, output_len, "%s", value);
+    break;
+  }
+  fclose(fp);
+#endif
+}
+
+static bool header_matches(FILE *fp, const char *name, const char *expected) {
+  char line[KERNEL_TUNER_MAX_LINE];
+  if (fgets(line, sizeof(line), fp) == NULL) {
+    return false;
+  }
+  line[strcspn(line, "\n")] = '\0';
+  size_t name_len = strlen(name);
+  return strncmp(line, name, name_len) == 0 && strcmp(line + name_len, expected) == 0;
+}
+
+static void save_cache(kernel_tuner *tuner) {
+  char temp_file[KERNEL_TUNER_MAX_LINE];
+  snprintf(temp_file, sizeof(temp_file), "%s.tmp", tuner->cache_file);
+  FILE *fp = fopen(temp_file, "w");
+  if (fp == NULL) {
+    perror("unable to save kernel cache");
+    return;
+  }
+  fprintf(fp, "cpu=%s\nbuild=%s\n", tuner->cpu, KERNEL_TUNER_BUILD);
+  for (size_t i = 0; i < tuner->entries_len; i++) {
+    kernel_tuner_entry *entry = tuner->entries + i;
+    if (!entry->persistent) {
+      continue;
+    }
+    fprintf(fp, "%u %u %u %u %s\n", (unsigned int) entry->format, entry->taps_len, entry->decimation, entry->buffer_size, format_kernel(entry->optimization));
+  }
+  if (fclose(fp) != 0) {
+    perror("unable to save kernel cache");
+    remove(temp_file);
+    return;
+  }
+  // readers never see partially written file
+  if (rename(temp_file, tuner->cache_file) != 0) {
+    perror("unable to save kernel cache");
+    remove(temp_file);
+  }
+}
+
+static void load_cache(kernel_tuner *tuner) {
+  FILE *fp = fopen(tuner->cache_file, "r");
+  if (fp == NULL) {
+    return;
+  }
+  // results from another cpu or build are dropped
+  if (!header_matches(fp, "cpu=", tuner->cpu) || !header_matches(fp, "build=", KERNEL_TUNER_BUILD)) {
+    fprintf(stdout, "kernel cache %s is outdated\n", tuner->cache_file);
+    fclose(fp);
+    save_cache(tuner);
+    return;
+  }
+  char line[KERNEL_TUNER_MAX_LINE];
+  while (tuner->entries_len < KERNEL_TUNER_MAX_ENTRIES && fgets(line, sizeof(line), fp) != NULL) {
+    unsigned int format;
+    kernel_tuner_entry *entry = tuner->entries + tuner->entries_len;
+    char kernel[32];
+    if (sscanf(line, "%u %u %u %u %31s", &format, &entry->taps_len, &entry->decimation, &entry->buffer_size, kernel) != 5) {
+      continue;
+    }
+    if (strcmp(kernel, "NATIVE_CF32") == 0) {
+      entry->optimization = NATIVE_CF32;
+    } else if (strcmp(kernel, "OPTIMIZED_CF32") == 0) {
+      entry->optimization = OPTIMIZED_CF32;
+    } else {
+      continue;
+    }
+    entry->format = (sample_format_t) format;
+    entry->persistent = true;
+    tuner->entries_len++;
+  }
+  fclose(fp);
+  fprintf(stdout, "loaded %zu kernels from %s\n", tuner->entries_len, tuner->cache_file);
+}
+
+int kernel_tuner_create(const char *cache_file, kernel_tuner **tuner) {
+  struct kernel_tuner_t *result = malloc(sizeof(struct kernel_tuner_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *result = (struct kernel_tuner_t) {0};
+  result->mutex = (pthread_mutex_t) PTHREAD_MUTEX_INITIALIZER;
+  read_cpu_model(result->cpu, sizeof(result->cpu));
+  if (cache_file != NULL) {
+    result->cache_file = strdup(cache_file);
+    if (result->cache_file == NULL) {
+      kernel_tuner_destroy(result);
+      return -ENOMEM;
+    }
+    load_cache(result);
+  }
+  *tuner = result;
+  return 0;
+}
+
+static int time_kernel(const float *taps, size_t taps_len, uint32_t decimation, cpu_optimization optimization, const uint8_t *input, struct server_config *server_config, double *nanos) {
+  float *copy = malloc(sizeof(float) * taps_len);
+  if (copy == NULL) {
+    return -ENOMEM;
+  }
+  memcpy(copy, taps, sizeof(float) * taps_len);
+  return dsp_cost_measure(copy, taps_len, decimation, optimization, input, server_config, nanos);
+}
+
+static int time_kernels(const float *taps, size_t taps_len, uint32_t decimation, struct server_config *server_config, cpu_optimization *result, bool *tie) {
+  uint8_t *input = dsp_cost_create_input(server_config->buffer_size);
+  if (input == NULL) {
+    return -ENOMEM;
+  }
+  // the minimum is the least affected by the other threads
+  double native_nanos = 0.0;
+  double optimized_nanos = 0.0;
+  int code = 0;
+  for (int i = 0; i < KERNEL_TUNER_ROUNDS && code == 0; i++) {
+    double nanos = 0.0;
+    code = time_kernel(taps, taps_len, decimation, NATIVE_CF32, input, server_config, &nanos);
+    if (code == 0 && (i == 0 || nanos < native_nanos)) {
+      native_nanos = nanos;
+    }
+    if (code == 0) {
+      code = time_kernel(taps, taps_len, decimation, OPTIMIZED_CF32, input, server_config, &nanos);
+    }
+    if (code == 0 && (i == 0 || nanos < optimized_nanos)) {
+      optimized_nanos = nanos;
+    }
+  }
+  free(input);
+  if (code != 0) {
+    return code;
+  }
+  double fastest;
+  double slowest;
+  if (optimized_nanos < native_nanos) {
+    *result = OPTIMIZED_CF32;
+    fastest = optimized_nanos;
+    slowest = native_nanos;
+  } else {
+    *result = NATIVE_CF32;
+    fastest = native_nanos;
+    slowest = optimized_nanos;
+  }
+  *tie = (slowest - fastest) * 100.0 < fastest * KERNEL_TUNER_TIE_PERCENT;
+  fprintf(stdout, "kernel for %zu taps and decimation %u: %s%s. NATIVE_CF32 %.0f ns, OPTIMIZED_CF32 %.0f ns per buffer\n", taps_len, decimation, format_kernel(*result), (*tie ? " (near tie, not cached)" : ""), native_nanos, optimized_nanos);
+  return 0;
+}
+
+int kernel_tuner_select(client_config *config, struct server_config *server_config, kernel_tuner *tuner, cpu_optimization *result) {
+  // no filter
+  if (config->destination == REQUEST_DESTINATION_FILE_RAW || config->destination == REQUEST_DESTINATION_SOCKET_RAW) {
+    *result = NATIVE_CF32;
+    return 0;
+  }
+  // the same filter as dsp_worker creates
+  float *taps = NULL;
+  size_t taps_len = 0;
+  int code = create_low_pass_filter(1.0F, server_config->band_sampling_rate, config->sampling_rate / 2, config->sampling_rate / server_config->lpf_cutoff_rate, &taps, &taps_len);
+  if (code != 0) {
+    return code;
+  }
+  uint32_t decimation = server_config->band_sampling_rate / config->sampling_rate;
+  sample_format_t format = sdr_device_get_sample_format(server_config);
+  pthread_mutex_lock(&tuner->mutex);
+  for (size_t i = 0; i < tuner->entries_len; i++) {
+    kernel_tuner_entry *entry = tuner->entries + i;
+    if (entry->format == format && entry->taps_len == taps_len && entry->decimation == decimation && entry->buffer_size == server_config->buffer_size) {
+      *result = entry->optimization;
+      pthread_mutex_unlock(&tuner->mutex);
+      free(taps);
+      return 0;
+    }
+  }
+  bool tie = false;
+  code = time_kernels(taps, taps_len, decimation, server_config, result, &tie);
+  // the oldest results are kept. New filters are timed every time
+  if (code == 0 && tuner->entries_len < KERNEL_TUNER_MAX_ENTRIES) {
+    kernel_tuner_entry *entry = tuner->entries + tuner->entries_len;
+    entry->format = format;
+    entry->taps_len = (uint32_t) taps_len;
+    entry->decimation = decimation;
+    entry->buffer_size = server_config->buffer_size;
+    entry->optimization = *result;
+    entry->persistent = !tie;
+    tuner->entries_len++;
+    if (tuner->cache_file != NULL && entry->persistent) {
+      save_cache(tuner);
+    }
+  }
+  pthread_mutex_unlock(&tuner->mutex);
+  free(taps);
+  return code;
+}
+
+void kernel_tuner_destroy(kernel_tuner *tuner) {
+  if (tuner == NULL) {
+    return;
+  }
+  if (tuner->cache_file != NULL) {
+    free(tuner->cache_file);
+  }
+  free(tuner);
+}
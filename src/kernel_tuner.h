@@ -0,0 +1,18 @@
+#ifndef KERNEL_TUNER_H_
+#define KERNEL_TUNER_H_
+
+#include "config.h"
+#include "dsp_worker.h"
+
+typedef struct kernel_tuner_t kernel_tuner;
+
+// cache_file - optional. Results from the previous runs on the same cpu and build
+int kernel_tuner_create(const char *cache_file, kernel_tuner **tuner);
+
+// the fastest kernel for the client's filter. The kernels are timed on the first use of the filter geometry
+// near ties are kept in memory only
+int kernel_tuner_select(client_config *config, struct server_config *server_config, kernel_tuner *tuner, cpu_optimization *result);
+
+void kernel_tuner_destroy(kernel_tuner *tuner);
+
+#endif /* KERNEL_TUNER_H_ */
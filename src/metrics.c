@@ -0,0 +1,263 @@
+#include "metrics.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "sdr_device.h"
+#include "socket_util.h"
+#include "thread_scheduling.h"
+
+#define METRICS_MAX_REQUEST 1024
+#define METRICS_MAX_RESPONSE 16384
+
+struct metrics_server_t {
+  int server_socket;
+  volatile sig_atomic_t is_running;
+  pthread_t thread;
+  server_metrics *metrics;
+  sdr_device *device;
+  char *output;
+  uint64_t cpus;
+};
+
+void metrics_reset(server_metrics *metrics) {
+  metrics->clients = 0;
+  metrics->buffers = 0;
+  metrics->input_bytes = 0;
+  metrics->output_bytes = 0;
+  metrics->queue_overflows = 0;
+  metrics->write_failures = 0;
+  metrics->dsp_cpu_nanos = 0;
+  metrics->memory_bytes = 0;
+  metrics->memory_budget_bytes = 0;
+  metrics->dsp_load_millicores = 0;
+  metrics->dsp_capacity_millicores = 0;
+  histogram_reset(&metrics->latency);
+}
+
+static int append(char *output, size_t output_len, size_t *offset, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(output + *offset, output_len - *offset, format, args);
+  va_end(args);
+  if (written < 0 || (size_t) written >= output_len - *offset) {
+    return -1;
+  }
+  *offset += written;
+  return 0;
+}
+
+static int append_counter(char *output, size_t output_len, size_t *offset, const char *name, const char *help, uint64_t value) {
+  return append(output, output_len, offset, "# HELP %s %s\n# TYPE %s counter\n%s %" PRIu64 "\n", name, help, name, name, value);
+}
+
+static int append_gauge(char *output, size_t output_len, size_t *offset, const char *name, const char *help, uint64_t value) {
+  return append(output, output_len, offset, "# HELP %s %s\n# TYPE %s gauge\n%s %" PRIu64 "\n", name, help, name, name, value);
+}
+
+// only the power of 2 boundaries. Prometheus doesn't need 240 buckets
+static int append_histogram_seconds(char *output, size_t output_len, size_t *offset, const char *name, const char *help, histogram *histogram) {
+  if (append(output, output_len, offset, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name) != 0) {
+    return -1;
+  }
+  uint64_t total = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS - 1; i++) {
+    total += histogram->counts[i];
+    if ((i + 1) % HISTOGRAM_SUB_BUCKETS != 0) {
+      continue;
+    }
+    double le = (double) (histogram_get_upper_bound(i) + 1) / 1000000.0;
+    if (append(output, output_len, offset, "%s_bucket{le=\"%g\"} %" PRIu64 "\n", name, le, total) != 0) {
+      return -1;
+    }
+  }
+  total += histogram->counts[HISTOGRAM_BUCKETS - 1];
+  // count is taken from the buckets so that +Inf is consistent with them
+  return append(output, output_len, offset, "%s_bucket{le=\"+Inf\"} %" PRIu64 "\n%s_sum %g\n%s_count %" PRIu64 "\n", name, total, name, (double) histogram->sum / 1000000.0, name, total);
+}
+
+int metrics_format(server_metrics *metrics, struct sdr_device_t *device, char *output, size_t output_len) {
+  size_t offset = 0;
+  int code = 0;
+  if (device != NULL) {
+    sdr_device_stats stats;
+    sdr_device_get_stats(device, &stats);
+    code |= append_counter(output, output_len, &offset, "sdr_server_device_buffers_total", "Buffers received from the device", stats.buffers);
+    code |= append_counter(output, output_len, &offset, "sdr_server_device_samples_total", "Samples received from the device", stats.samples);
+    code |= append_counter(output, output_len, &offset, "sdr_server_device_dropped_samples_total", "Samples dropped by the driver", stats.dropped_samples);
+    code |= append_counter(output, output_len, &offset, "sdr_server_device_lost_samples_total", "Samples the device fell behind the monotonic clock. Diagnostic only", stats.lost_samples);
+    code |= append_gauge(output, output_len, &offset, "sdr_server_device_observed_sampling_rate", "Samples per second since the device was started", stats.observed_sampling_rate);
+  }
+  code |= append_gauge(output, output_len, &offset, "sdr_server_clients", "Running clients", metrics->clients);
+  code |= append_gauge(output, output_len, &offset, "sdr_server_memory_bytes", "Memory allocated by the running clients", metrics->memory_bytes);
+  code |= append_gauge(output, output_len, &offset, "sdr_server_memory_budget_bytes", "Configured memory budget. 0 - unlimited", metrics->memory_budget_bytes);
+  code |= append_gauge(output, output_len, &offset, "sdr_server_dsp_load_millicores", "Estimated dsp load of the running clients. 1000 - one cpu", metrics->dsp_load_millicores);
+  code |= append_gauge(output, output_len, &offset, "sdr_server_dsp_capacity_millicores", "Clients are refused above this load. 0 - unlimited", metrics->dsp_capacity_millicores);
+  code |= append_counter(output, output_len, &offset, "sdr_server_client_buffers_total", "Buffers processed by all clients", metrics->buffers);
+  code |= append_counter(output, output_len, &offset, "sdr_server_client_input_bytes_total", "Bytes processed by all clients", metrics->input_bytes);
+  code |= append_counter(output, output_len, &offset, "sdr_server_client_output_bytes_total", "Bytes written to the sockets and files", metrics->output_bytes);
+  code |= append_counter(output, output_len, &offset, "sdr_server_client_queue_overflows_total", "Buffers overwritten because the clients were too slow", metrics->queue_overflows);
+  code |= append_counter(output, output_len, &offset, "sdr_server_client_write_failures_total", "Unable to write to the sockets or files", metrics->write_failures);
+  code |= append(output, output_len, &offset, "# HELP sdr_server_client_dsp_cpu_seconds_total CPU time of the dsp threads\n# TYPE sdr_server_client_dsp_cpu_seconds_total counter\nsdr_server_client_dsp_cpu_seconds_total %.6f\n", (double) metrics->dsp_cpu_nanos / 1000000000.0);
+  code |= append_histogram_seconds(output, output_len, &offset, "sdr_server_client_latency_seconds", "From the device callback until the buffer was processed and written", &metrics->latency);
+  if (code != 0) {
+    return -1;
+  }
+  return (int) offset;
+}
+
+static int read_request_line(int socket, char *request, size_t request_len) {
+  size_t received = 0;
+  while (received < request_len - 1) {
+    ssize_t current = recv(socket, request + received, request_len - 1 - received, 0);
+    if (current < 0 && errno == EINTR) {
+      continue;
+    }
+    if (current <= 0) {
+      return -1;
+    }
+    received += current;
+    request[received] = '\0';
+    // the rest of the request is not needed
+    if (strstr(request, "\r\n") != NULL) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static void handle_request(int client_socket, metrics_server *server) {
+  char request[METRICS_MAX_REQUEST];
+  if (read_request_line(client_socket, request, sizeof(request)) != 0) {
+    return;
+  }
+  char header[256];
+  if (strncmp(request, "GET /metrics ", strlen("GET /metrics ")) != 0) {
+    const char *not_found = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    write_fully(client_socket, not_found, strlen(not_found));
+    return;
+  }
+  int body_len = metrics_format(server->metrics, server->device, server->output, METRICS_MAX_RESPONSE);
+  if (body_len < 0) {
+    const char *error = "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    write_fully(client_socket, error, strlen(error));
+    return;
+  }
+  int header_len = snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", body_len);
+  if (write_fully(client_socket, header, header_len) != 0) {
+    return;
+  }
+  write_fully(client_socket, server->output, body_len);
+}
+
+static void *metrics_worker(void *arg) {
+  metrics_server *server = (metrics_server *) arg;
+  thread_scheduling_apply("metrics", server->cpus, 0);
+  while (server->is_running) {
+    int client_socket = accept(server->server_socket, NULL, NULL);
+    if (client_socket < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    // slow scrapers should not block the next ones
+    struct timeval tv;
+    tv.tv_sec = 5;
+    tv.tv_usec = 0;
+    setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *) &tv, sizeof tv);
+    setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (const char *) &tv, sizeof tv);
+    handle_request(client_socket, server);
+    close(client_socket);
+  }
+  return (void *) 0;
+}
+
+int metrics_server_start(const char *bind_address, int port, uint64_t cpus, server_metrics *metrics, struct sdr_device_t *device, metrics_server **server) {
+  struct metrics_server_t *result = malloc(sizeof(struct metrics_server_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *result = (struct metrics_server_t) {0};
+  result->server_socket = -1;
+  result->metrics = metrics;
+  result->device = device;
+  result->cpus = cpus;
+  result->output = malloc(METRICS_MAX_RESPONSE);
+  if (result->output == NULL) {
+    metrics_server_destroy(result);
+    return -ENOMEM;
+  }
+  result->server_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (result->server_socket < 0) {
+    perror("metrics socket creation failed");
+    metrics_server_destroy(result);
+    return -1;
+  }
+  int opt = 1;
+  if (setsockopt(result->server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
+    perror("metrics setsockopt - SO_REUSEADDR");
+    metrics_server_destroy(result);
+    return -1;
+  }
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  if (inet_pton(AF_INET, bind_address, &address.sin_addr) <= 0) {
+    fprintf(stderr, "<3>invalid metrics address: %s\n", bind_address);
+    metrics_server_destroy(result);
+    return -1;
+  }
+  address.sin_port = htons(port);
+  if (bind(result->server_socket, (struct sockaddr *) &address, sizeof(address)) < 0) {
+    perror("metrics bind failed");
+    metrics_server_destroy(result);
+    return -1;
+  }
+  if (listen(result->server_socket, 3) < 0) {
+    perror("metrics listen failed");
+    metrics_server_destroy(result);
+    return -1;
+  }
+  result->is_running = true;
+  if (pthread_create(&result->thread, NULL, &metrics_worker, result) != 0) {
+    result->is_running = false;
+    metrics_server_destroy(result);
+    return -1;
+  }
+  fprintf(stdout, "metrics are available at http://%s:%d/metrics\n", bind_address, port);
+  *server = result;
+  return 0;
+}
+
+void metrics_server_destroy(metrics_server *server) {
+  if (server == NULL) {
+    return;
+  }
+  if (server->is_running) {
+    server->is_running = false;
+    // close is not enough to exit from the blocking "accept" method
+    shutdown(server->server_socket, SHUT_RDWR);
+    pthread_join(server->thread, NULL);
+  }
+  if (server->server_socket >= 0) {
+    close(server->server_socket);
+  }
+  if (server->output != NULL) {
+    free(server->output);
+  }
+  free(server);
+}
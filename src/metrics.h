@@ -0,0 +1,50 @@
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+// server-wide counters. dsp threads add to them after every buffer,
+// so they can be read without server->mutex
+typedef struct {
+  // running dsp workers
+  atomic_uint_fast64_t clients;
+  atomic_uint_fast64_t buffers;
+  atomic_uint_fast64_t input_bytes;
+  atomic_uint_fast64_t output_bytes;
+  atomic_uint_fast64_t queue_overflows;
+  atomic_uint_fast64_t write_failures;
+  atomic_uint_fast64_t dsp_cpu_nanos;
+  // allocated by the running clients. Approximate
+  atomic_uint_fast64_t memory_bytes;
+  // 0 - unlimited
+  uint64_t memory_budget_bytes;
+  // estimated load of the running clients. 1000 - one cpu
+  atomic_uint_fast64_t dsp_load_millicores;
+  // 0 - unlimited
+  uint64_t dsp_capacity_millicores;
+  // from queue_put until the buffer was processed and written. Microseconds
+  histogram latency;
+} server_metrics;
+
+typedef struct metrics_server_t metrics_server;
+
+// sdr_device.h includes this file through dsp_worker.h
+struct sdr_device_t;
+
+void metrics_reset(server_metrics *metrics);
+
+// Prometheus text exposition format. device is optional
+// returns the number of bytes written or -1 if output is too small
+int metrics_format(server_metrics *metrics, struct sdr_device_t *device, char *output, size_t output_len);
+
+// serves GET /metrics over HTTP
+// cpus - bitmask of cpus for the http thread. 0 - not pinned
+int metrics_server_start(const char *bind_address, int port, uint64_t cpus, server_metrics *metrics, struct sdr_device_t *device, metrics_server **server);
+
+void metrics_server_destroy(metrics_server *server);
+
+#endif /* METRICS_H_ */
@@ -0,0 +1,334 @@
+#include "parallel_gzip.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+// same block size as pigz
+#define BLOCK_SIZE (128 * 1024)
+
+typedef enum {
+  BLOCK_FREE,
+  BLOCK_PENDING,
+  BLOCK_COMPRESSING,
+  BLOCK_DONE
+} block_state;
+
+struct gzip_block {
+  uint8_t *input;
+  size_t input_len;
+  uint8_t *output;
+  size_t output_len;
+  size_t output_capacity;
+  uLong crc;
+  int code;
+  block_state state;
+};
+
+struct compress_worker {
+  parallel_gzip *gz;
+  z_stream strm;
+  bool strm_initialized;
+  pthread_t thread;
+  bool thread_started;
+};
+
+struct parallel_gzip_t {
+  FILE *file;
+  gzip_index *index;
+
+  struct gzip_block *blocks;
+  size_t number_of_blocks;
+  // the following indexes and counters are accessed by the writer thread only
+  size_t fill_index;
+  size_t write_index;
+  size_t submitted;
+  uLong crc;
+  uint64_t total_len;
+  uint64_t compressed_len;
+
+  struct compress_worker *workers;
+  int number_of_workers;
+  // guarded by mutex
+  size_t compress_index;
+  bool shutdown;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t block_pending;
+  pthread_cond_t block_done;
+};
+
+static void compress_block(struct gzip_block *block, z_stream *strm) {
+  deflateReset(strm);
+  strm->next_in = block->input;
+  strm->avail_in = (uInt)block->input_len;
+  strm->next_out = block->output;
+  strm->avail_out = (uInt)block->output_capacity;
+  // sync flush aligns the block to the byte boundary
+  // blocks don't share the dictionary, so they can be simply concatenated
+  int code = deflate(strm, Z_SYNC_FLUSH);
+  if (code != Z_OK || strm->avail_in != 0 || strm->avail_out == 0) {
+    block->code = -1;
+    return;
+  }
+  block->output_len = block->output_capacity - strm->avail_out;
+  block->crc = crc32(crc32(0L, Z_NULL, 0), block->input, (uInt)block->input_len);
+  block->code = 0;
+}
+
+static void *compress_callback(void *arg) {
+  struct compress_worker *worker = (struct compress_worker *)arg;
+  parallel_gzip *gz = worker->gz;
+  pthread_mutex_lock(&gz->mutex);
+  while (true) {
+    struct gzip_block *block = &gz->blocks[gz->compress_index];
+    if (block->state != BLOCK_PENDING) {
+      if (gz->shutdown) {
+        break;
+      }
+      pthread_cond_wait(&gz->block_pending, &gz->mutex);
+      continue;
+    }
+    block->state = BLOCK_COMPRESSING;
+    gz->compress_index = (gz->compress_index + 1) % gz->number_of_blocks;
+    pthread_mutex_unlock(&gz->mutex);
+
+    compress_block(block, &worker->strm);
+
+    pthread_mutex_lock(&gz->mutex);
+    block->state = BLOCK_DONE;
+    pthread_cond_broadcast(&gz->block_done);
+  }
+  pthread_mutex_unlock(&gz->mutex);
+  return (void *)0;
+}
+
+static int write_bytes(const void *buffer, size_t len, parallel_gzip *gz) {
+  if (fwrite(buffer, sizeof(uint8_t), len, gz->file) != len) {
+    return -1;
+  }
+  gz->compressed_len += len;
+  return 0;
+}
+
+// blocks are written in the same order as submitted
+static int write_next_block(parallel_gzip *gz) {
+  struct gzip_block *block = &gz->blocks[gz->write_index];
+  pthread_mutex_lock(&gz->mutex);
+  while (block->state != BLOCK_DONE) {
+    pthread_cond_wait(&gz->block_done, &gz->mutex);
+  }
+  pthread_mutex_unlock(&gz->mutex);
+
+  int code = block->code;
+  // every block is independent, so it can be a seek point
+  if (code == 0 && gz->index != NULL && gzip_index_is_due(gz->total_len, gz->index)) {
+    code = gzip_index_add(gz->total_len, gz->compressed_len, gz->index);
+  }
+  if (code == 0) {
+    code = write_bytes(block->output, block->output_len, gz);
+  }
+  if (code == 0) {
+    gz->crc = crc32_combine(gz->crc, block->crc, (z_off_t)block->input_len);
+    gz->total_len += block->input_len;
+  }
+  // workers check the state of the blocks under the mutex
+  pthread_mutex_lock(&gz->mutex);
+  block->input_len = 0;
+  block->output_len = 0;
+  block->state = BLOCK_FREE;
+  gz->write_index = (gz->write_index + 1) % gz->number_of_blocks;
+  gz->submitted--;
+  pthread_mutex_unlock(&gz->mutex);
+  return code;
+}
+
+static int submit_block(parallel_gzip *gz) {
+  pthread_mutex_lock(&gz->mutex);
+  gz->blocks[gz->fill_index].state = BLOCK_PENDING;
+  pthread_cond_broadcast(&gz->block_pending);
+  pthread_mutex_unlock(&gz->mutex);
+  gz->submitted++;
+  gz->fill_index = (gz->fill_index + 1) % gz->number_of_blocks;
+  // all blocks are busy. wait for the oldest one
+  if (gz->submitted == gz->number_of_blocks) {
+    return write_next_block(gz);
+  }
+  return 0;
+}
+
+int parallel_gzip_create(const char *file_path, int level, int threads, gzip_index *index, parallel_gzip **gz) {
+  if (threads <= 0) {
+    return -1;
+  }
+  struct parallel_gzip_t *result = malloc(sizeof(struct parallel_gzip_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *result = (struct parallel_gzip_t){0};
+  result->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+  result->block_pending = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+  result->block_done = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+  result->crc = crc32(0L, Z_NULL, 0);
+  result->index = index;
+
+  // two blocks per thread: one is compressing, another is filling
+  result->number_of_blocks = (size_t)threads * 2;
+  result->blocks = malloc(sizeof(struct gzip_block) * result->number_of_blocks);
+  if (result->blocks == NULL) {
+    parallel_gzip_destroy(result);
+    return -ENOMEM;
+  }
+  for (size_t i = 0; i < result->number_of_blocks; i++) {
+    result->blocks[i] = (struct gzip_block){0};
+  }
+  result->workers = malloc(sizeof(struct compress_worker) * threads);
+  if (result->workers == NULL) {
+    parallel_gzip_destroy(result);
+    return -ENOMEM;
+  }
+  result->number_of_workers = threads;
+  for (int i = 0; i < threads; i++) {
+    result->workers[i] = (struct compress_worker){0};
+    result->workers[i].gz = result;
+  }
+  for (int i = 0; i < threads; i++) {
+    // raw deflate. gzip header and trailer are written separately
+    if (deflateInit2(&result->workers[i].strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      parallel_gzip_destroy(result);
+      return -1;
+    }
+    result->workers[i].strm_initialized = true;
+  }
+  // deflateBound assumes Z_FINISH. sync flush might add few more bytes
+  size_t output_capacity = deflateBound(&result->workers[0].strm, BLOCK_SIZE) + 64;
+  for (size_t i = 0; i < result->number_of_blocks; i++) {
+    result->blocks[i].input = malloc(sizeof(uint8_t) * BLOCK_SIZE);
+    result->blocks[i].output = malloc(sizeof(uint8_t) * output_capacity);
+    result->blocks[i].output_capacity = output_capacity;
+    if (result->blocks[i].input == NULL || result->blocks[i].output == NULL) {
+      parallel_gzip_destroy(result);
+      return -ENOMEM;
+    }
+  }
+
+  result->file = fopen(file_path, "wb");
+  if (result->file == NULL) {
+    parallel_gzip_destroy(result);
+    return -1;
+  }
+  // deflate, no flags, no mtime, no extra flags, unix
+  const uint8_t header[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03};
+  if (write_bytes(header, sizeof(header), result) != 0) {
+    parallel_gzip_destroy(result);
+    return -1;
+  }
+
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&result->workers[i].thread, NULL, &compress_callback, &result->workers[i]) != 0) {
+      parallel_gzip_destroy(result);
+      return -1;
+    }
+    result->workers[i].thread_started = true;
+  }
+
+  *gz = result;
+  return 0;
+}
+
+int parallel_gzip_write(const void *buffer, size_t len, parallel_gzip *gz) {
+  const uint8_t *input = (const uint8_t *)buffer;
+  while (len > 0) {
+    struct gzip_block *block = &gz->blocks[gz->fill_index];
+    size_t to_copy = BLOCK_SIZE - block->input_len;
+    if (to_copy > len) {
+      to_copy = len;
+    }
+    memcpy(block->input + block->input_len, input, to_copy);
+    block->input_len += to_copy;
+    input += to_copy;
+    len -= to_copy;
+    if (block->input_len == BLOCK_SIZE && submit_block(gz) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int parallel_gzip_finish(parallel_gzip *gz) {
+  int code = 0;
+  if (gz->blocks[gz->fill_index].input_len > 0) {
+    code = submit_block(gz);
+  }
+  while (gz->submitted > 0) {
+    if (write_next_block(gz) != 0) {
+      code = -1;
+    }
+  }
+  if (code != 0) {
+    return code;
+  }
+  // empty final block terminates the deflate stream
+  const uint8_t last_block[] = {0x03, 0x00};
+  uint8_t trailer[8];
+  for (int i = 0; i < 4; i++) {
+    trailer[i] = (uint8_t)(gz->crc >> (8 * i));
+    // ISIZE is modulo 2^32
+    trailer[4 + i] = (uint8_t)(gz->total_len >> (8 * i));
+  }
+  if (write_bytes(last_block, sizeof(last_block), gz) != 0 || write_bytes(trailer, sizeof(trailer), gz) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int parallel_gzip_destroy(parallel_gzip *gz) {
+  if (gz == NULL) {
+    return 0;
+  }
+  int code = -1;
+  if (gz->file != NULL) {
+    if (gz->workers != NULL && gz->workers[gz->number_of_workers - 1].thread_started) {
+      code = parallel_gzip_finish(gz);
+      if (code != 0) {
+        fprintf(stderr, "<3>unable to complete gz file\n");
+      }
+    }
+    if (fclose(gz->file) != 0) {
+      code = -1;
+    }
+  }
+  pthread_mutex_lock(&gz->mutex);
+  gz->shutdown = true;
+  pthread_cond_broadcast(&gz->block_pending);
+  pthread_mutex_unlock(&gz->mutex);
+  if (gz->workers != NULL) {
+    for (int i = 0; i < gz->number_of_workers; i++) {
+      if (gz->workers[i].thread_started) {
+        pthread_join(gz->workers[i].thread, NULL);
+      }
+      if (gz->workers[i].strm_initialized) {
+        deflateEnd(&gz->workers[i].strm);
+      }
+    }
+    free(gz->workers);
+  }
+  if (gz->blocks != NULL) {
+    for (size_t i = 0; i < gz->number_of_blocks; i++) {
+      if (gz->blocks[i].input != NULL) {
+        free(gz->blocks[i].input);
+      }
+      if (gz->blocks[i].output != NULL) {
+        free(gz->blocks[i].output);
+      }
+    }
+    free(gz->blocks);
+  }
+  free(gz);
+  return code;
+}
@@ -0,0 +1,21 @@
+#ifndef PARALLEL_GZIP_H_
+#define PARALLEL_GZIP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gzip_index.h"
+
+typedef struct parallel_gzip_t parallel_gzip;
+
+// the output is a single gzip member made of independently deflated blocks.
+// it can be decoded by any gzip reader
+// index is optional. block boundaries are added into it
+int parallel_gzip_create(const char *file_path, int level, int threads, gzip_index *index, parallel_gzip **gz);
+
+int parallel_gzip_write(const void *buffer, size_t len, parallel_gzip *gz);
+
+// completes the gzip member. Returns non-zero if the file is incomplete
+int parallel_gzip_destroy(parallel_gzip *gz);
+
+#endif /* PARALLEL_GZIP_H_ */
@@ -2,13 +2,18 @@
 #include <errno.h>
 #include <pthread.h>
 #include <string.h>
-#include <stdio.h>
+#include <time.h>
 
 #include "queue.h"
+#include "sample_memory.h"
 
 struct queue_node {
     uint8_t *buffer;
     size_t len;
+    // overwritten data
+    size_t dropped;
+    // monotonic clock when the buffer was put into the queue
+    struct timespec put_time;
     struct queue_node *next;
 };
 
@@ -21,19 +26,24 @@ struct queue_t {
 
     struct queue_node *detached_node;
 
+    // buffers of all nodes. One allocation keeps them close and makes hugepages worth it
+    uint8_t *buffers_memory;
+
     pthread_mutex_t mutex;
     pthread_cond_t condition;
 
     int poison_pill;
+    uint64_t buffers;
+    // number of buffers overwritten because consumer was too slow
+    uint64_t overflows;
+    // consumer woke up from waiting the data
+    uint64_t wakeups;
 };
 
 void destroy_nodes(struct queue_node *nodes) {
     struct queue_node *cur_node = nodes;
     while (cur_node != NULL) {
         struct queue_node *next = cur_node->next;
-        if (cur_node->buffer != NULL) {
-            free(cur_node->buffer);
-        }
         free(cur_node);
         cur_node = next;
     }
@@ -44,6 +54,11 @@ int create_queue(uint32_t buffer_size, int queue_size, queue **queue) {
     if (result == NULL) {
         return -ENOMEM;
     }
+    uint8_t *buffers_memory = sample_memory_alloc(sizeof(uint8_t) * buffer_size * (size_t) queue_size);
+    if (buffers_memory == NULL) {
+        free(result);
+        return -ENOMEM;
+    }
 
     struct queue_node *first_node = NULL;
     struct queue_node *last_node = NULL;
@@ -51,18 +66,14 @@ int create_queue(uint32_t buffer_size, int queue_size, queue **queue) {
         struct queue_node *cur = malloc(sizeof(struct queue_node));
         if (cur == NULL) {
             destroy_nodes(first_node);
+            sample_memory_free(buffers_memory);
             free(result);
             return -ENOMEM;
         }
-        cur->buffer = malloc(sizeof(uint8_t) * buffer_size);
+        cur->buffer = buffers_memory + (size_t) i * buffer_size;
         cur->next = NULL;
         cur->len = 0;
-        if (cur->buffer == NULL) {
-            destroy_nodes(first_node);
-            free(cur);
-            free(result);
-            return -ENOMEM;
-        }
+        cur->dropped = 0;
         if (last_node == NULL) {
             first_node = cur;
         } else {
@@ -76,27 +87,40 @@ int create_queue(uint32_t buffer_size, int queue_size, queue **queue) {
     result->first_filled_node = NULL;
     result->last_filled_node = NULL;
     result->detached_node = NULL;
+    result->buffers_memory = buffers_memory;
     result->condition = (pthread_cond_t) PTHREAD_COND_INITIALIZER;
     result->mutex = (pthread_mutex_t) PTHREAD_MUTEX_INITIALIZER;
     result->poison_pill = 0;
+    result->buffers = 0;
+    result->overflows = 0;
+    result->wakeups = 0;
 
     *queue = result;
     return 0;
 }
 
 void queue_put(const uint8_t *buffer, const size_t len, queue *queue) {
+    queue_put_after_gap(buffer, len, 0, queue);
+}
+
+void queue_put_after_gap(const uint8_t *buffer, const size_t len, size_t dropped, queue *queue) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
     pthread_mutex_lock(&queue->mutex);
     struct queue_node *to_fill;
     if (queue->first_free_node == NULL) {
         // queue is full
         // overwrite last node
         to_fill = queue->last_filled_node;
-        fprintf(stderr, "<3>queue is full\n");
+        to_fill->dropped += to_fill->len + dropped;
+        // reported by the consumer. Logging here would slow down the producer even more
+        queue->overflows++;
     } else {
         // remove from free nodes pool
         to_fill = queue->first_free_node;
         queue->first_free_node = queue->first_free_node->next;
         to_fill->next = NULL;
+        to_fill->dropped = dropped;
         if (queue->first_free_node == NULL) {
             queue->last_free_node = NULL;
         }
@@ -112,7 +136,9 @@ void queue_put(const uint8_t *buffer, const size_t len, queue *queue) {
     }
 
     memcpy(to_fill->buffer, buffer, sizeof(uint8_t) * len);
+    queue->buffers++;
     to_fill->len = len;
+    to_fill->put_time = now;
     pthread_cond_broadcast(&queue->condition);
 
     pthread_mutex_unlock(&queue->mutex);
@@ -123,10 +149,10 @@ void destroy_queue(queue *queue) {
     destroy_nodes(queue->first_free_node);
     destroy_nodes(queue->first_filled_node);
     if (queue->detached_node != NULL) {
-        free(queue->detached_node->buffer);
         free(queue->detached_node);
     }
     pthread_mutex_unlock(&queue->mutex);
+    sample_memory_free(queue->buffers_memory);
     free(queue);
 }
 
@@ -140,6 +166,7 @@ void take_buffer_for_processing(uint8_t **buffer, size_t *len, queue *queue) {
     // "while" loop is for spurious wakeups
     while (queue->first_filled_node == NULL) {
         pthread_cond_wait(&queue->condition, &queue->mutex);
+        queue->wakeups++;
         // destroy all queue data
         // and return NULL buffer
         if (queue->poison_pill == 1 && queue->first_filled_node == NULL) {
@@ -176,6 +203,36 @@ void complete_buffer_processing(queue *queue) {
     pthread_mutex_unlock(&queue->mutex);
 }
 
+size_t get_dropped_before_buffer(queue *queue) {
+    // detached node can be accessed without the lock
+    if (queue->detached_node == NULL) {
+        return 0;
+    }
+    return queue->detached_node->dropped;
+}
+
+void get_put_time_of_buffer(struct timespec *put_time, queue *queue) {
+    // detached node can be accessed without the lock
+    if (queue->detached_node == NULL) {
+        return;
+    }
+    *put_time = queue->detached_node->put_time;
+}
+
+void queue_get_stats(queue *queue, queue_stats *stats) {
+    pthread_mutex_lock(&queue->mutex);
+    stats->buffers = queue->buffers;
+    stats->overflows = queue->overflows;
+    stats->wakeups = queue->wakeups;
+    stats->depth = 0;
+    struct queue_node *cur_node = queue->first_filled_node;
+    while (cur_node != NULL) {
+        stats->depth++;
+        cur_node = cur_node->next;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+}
+
 void interrupt_waiting_the_data(queue *queue) {
     if (queue == NULL) {
         return;
@@ -1,15 +1,35 @@
 #ifndef QUEUE_H_
 #define QUEUE_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 typedef struct queue_t queue;
 
+typedef struct {
+    // number of buffers put into the queue
+    uint64_t buffers;
+    // number of buffers overwritten because the consumer was too slow
+    uint64_t overflows;
+    // number of times the consumer woke up waiting for the data. Includes spurious wakeups
+    uint64_t wakeups;
+    // buffers waiting for processing
+    uint32_t depth;
+} queue_stats;
+
 int create_queue(uint32_t buffer_size, int queue_size, queue **queue);
 
 void queue_put(const uint8_t *buffer, size_t buffer_len, queue *queue);
+// dropped - number of bytes lost by the producer right before the buffer
+void queue_put_after_gap(const uint8_t *buffer, size_t buffer_len, size_t dropped, queue *queue);
 void take_buffer_for_processing(uint8_t **buffer, size_t *buffer_len, queue *queue);
 void complete_buffer_processing(queue *queue);
+// number of bytes dropped right before the buffer taken for processing
+size_t get_dropped_before_buffer(queue *queue);
+// monotonic clock when the buffer taken for processing was put into the queue
+void get_put_time_of_buffer(struct timespec *put_time, queue *queue);
+void queue_get_stats(queue *queue, queue_stats *stats);
 
 void interrupt_waiting_the_data(queue *queue);
 void destroy_queue(queue *queue);
@@ -0,0 +1,170 @@
+#include "real_to_iq.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// half-band filter has 25 non-zero taps: 24 odd taps and the center one
+// so only odd samples are filtered and even samples are just delayed
+#define HALF_BAND_LEN 49
+#define ODD_TAPS_LEN ((HALF_BAND_LEN - 1) / 2)
+#define EVEN_DELAY (ODD_TAPS_LEN / 2)
+// the same one-pole dc blocker as libairspy. ADC offset would become a tone at the edge of the band
+#define DC_BLOCKER_ALPHA 0.01f
+
+struct real_to_iq_t {
+  float taps[ODD_TAPS_LEN];
+
+  // history is kept at the beginning of each buffer
+  float *even;
+  float *odd;
+  float *quadrature;
+  int16_t *output;
+  size_t max_output_len;
+
+  // sign of the next output sample. Fs/4 shift is multiplication by 1, j, -1, -j
+  float sign;
+  // running dc estimate of the real input
+  float dc;
+};
+
+int real_to_iq_create(size_t max_input_len, real_to_iq **result) {
+  if (max_input_len < 2) {
+    return -1;
+  }
+  struct real_to_iq_t *converter = malloc(sizeof(struct real_to_iq_t));
+  if (converter == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *converter = (struct real_to_iq_t){0};
+  converter->sign = 1.0f;
+  converter->max_output_len = max_input_len / 2;
+
+  // windowed sinc with the cutoff at Fs/4. Normalized so that I and Q have the same gain
+  int center = (HALF_BAND_LEN - 1) / 2;
+  float sum = 0.0f;
+  for (int i = 0; i < ODD_TAPS_LEN; i++) {
+    int index = 2 * i + 1;
+    double x = M_PI * (index - center) / 2.0;
+    double window = 0.42 - 0.5 * cos(2.0 * M_PI * index / (HALF_BAND_LEN - 1)) + 0.08 * cos(4.0 * M_PI * index / (HALF_BAND_LEN - 1));
+    converter->taps[i] = (float) (sin(x) / x * window);
+    sum += converter->taps[i];
+  }
+  for (int i = 0; i < ODD_TAPS_LEN; i++) {
+    converter->taps[i] /= sum;
+  }
+
+  converter->even = calloc(EVEN_DELAY + converter->max_output_len, sizeof(float));
+  converter->odd = calloc(ODD_TAPS_LEN + converter->max_output_len, sizeof(float));
+  converter->quadrature = malloc(sizeof(float) * converter->max_output_len);
+  converter->output = malloc(sizeof(int16_t) * 2 * converter->max_output_len);
+  if (converter->even == NULL || converter->odd == NULL || converter->quadrature == NULL || converter->output == NULL) {
+    real_to_iq_destroy(converter);
+    return -ENOMEM;
+  }
+  *result = converter;
+  return 0;
+}
+
+static inline float remove_dc(float value, real_to_iq *converter) {
+  float result = value - converter->dc;
+  converter->dc += DC_BLOCKER_ALPHA * result;
+  return result;
+}
+
+static inline int16_t saturate_to_int16(float value) {
+  float result = (value > INT16_MAX) ? INT16_MAX : value;
+  result = (result < INT16_MIN) ? INT16_MIN : result;
+  return (int16_t) result;
+}
+
+// even and odd streams are already shifted by Fs/4 and stored after the history
+static void process_split(size_t len, int16_t **output, size_t *output_len, real_to_iq *converter) {
+  float *even = converter->even;
+  float *odd = converter->odd;
+  float *quadrature = converter->quadrature;
+
+  // tap by tap so that inner loop is vectorized by the compiler
+  memset(quadrature, 0, sizeof(float) * len);
+  for (size_t i = 0; i < ODD_TAPS_LEN; i++) {
+    float tap = converter->taps[i];
+    const float *buf = odd + ODD_TAPS_LEN - 1 - i;
+    for (size_t j = 0; j < len; j++) {
+      quadrature[j] += tap * buf[j];
+    }
+  }
+
+  int16_t *result = converter->output;
+  for (size_t j = 0; j < len; j++) {
+    result[2 * j] = saturate_to_int16(even[j]);
+    result[2 * j + 1] = saturate_to_int16(quadrature[j]);
+  }
+
+  // preserve history for the next execution
+  memmove(even, even + len, sizeof(float) * EVEN_DELAY);
+  memmove(odd, odd + len, sizeof(float) * ODD_TAPS_LEN);
+  if (len % 2 != 0) {
+    converter->sign = -converter->sign;
+  }
+
+  *output = result;
+  *output_len = len;
+}
+
+void real_to_iq_process_int16(const int16_t *input, size_t input_len, int16_t **output, size_t *output_len, real_to_iq *converter) {
+  size_t len = input_len / 2;
+  if (len > converter->max_output_len) {
+    len = converter->max_output_len;
+  }
+  float *even = converter->even + EVEN_DELAY;
+  float *odd = converter->odd + ODD_TAPS_LEN;
+  float sign = converter->sign;
+  for (size_t j = 0; j < len; j++) {
+    float current = (j % 2 == 0) ? sign : -sign;
+    even[j] = current * remove_dc(input[2 * j], converter);
+    odd[j] = current * remove_dc(input[2 * j + 1], converter);
+  }
+  process_split(len, output, output_len, converter);
+}
+
+void real_to_iq_process_uint16(const uint16_t *input, size_t input_len, int16_t **output, size_t *output_len, real_to_iq *converter) {
+  size_t len = input_len / 2;
+  if (len > converter->max_output_len) {
+    len = converter->max_output_len;
+  }
+  float *even = converter->even + EVEN_DELAY;
+  float *odd = converter->odd + ODD_TAPS_LEN;
+  float sign = converter->sign;
+  for (size_t j = 0; j < len; j++) {
+    float current = (j % 2 == 0) ? sign : -sign;
+    // same scale as libairspy int16 samples
+    even[j] = current * remove_dc((float) (((int32_t) input[2 * j] - 2048) * 16), converter);
+    odd[j] = current * remove_dc((float) (((int32_t) input[2 * j + 1] - 2048) * 16), converter);
+  }
+  process_split(len, output, output_len, converter);
+}
+
+void real_to_iq_destroy(real_to_iq *converter) {
+  if (converter == NULL) {
+    return;
+  }
+  if (converter->even != NULL) {
+    free(converter->even);
+  }
+  if (converter->odd != NULL) {
+    free(converter->odd);
+  }
+  if (converter->quadrature != NULL) {
+    free(converter->quadrature);
+  }
+  if (converter->output != NULL) {
+    free(converter->output);
+  }
+  free(converter);
+}
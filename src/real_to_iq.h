@@ -0,0 +1,22 @@
+#ifndef REAL_TO_IQ_H_
+#define REAL_TO_IQ_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct real_to_iq_t real_to_iq;
+
+// converts real samples at 2 * Fs into cs16 complex samples at Fs
+// Fs/4 shift and half-band decimation are done in a single pass. ADC dc offset is removed before the shift
+// max_input_len - max number of real samples in one call
+int real_to_iq_create(size_t max_input_len, real_to_iq **result);
+
+// input_len should be even. output_len - number of complex samples
+void real_to_iq_process_int16(const int16_t *input, size_t input_len, int16_t **output, size_t *output_len, real_to_iq *converter);
+
+// raw 12bit unsigned ADC samples
+void real_to_iq_process_uint16(const uint16_t *input, size_t input_len, int16_t **output, size_t *output_len, real_to_iq *converter);
+
+void real_to_iq_destroy(real_to_iq *converter);
+
+#endif /* REAL_TO_IQ_H_ */
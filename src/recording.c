@@ -0,0 +1,201 @@
+#include "recording.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_output.h"
+#include "sigmf.h"
+
+struct recording_t {
+  recording_config config;
+  char datatype[16];
+  char extension[16];
+  struct server_config *server_config;
+  bool rotation_enabled;
+
+  struct timespec start_realtime;
+  struct timespec start_monotonic;
+  // across all segments
+  uint64_t total_samples;
+  uint64_t total_dropped;
+  uint64_t total_skipped;
+
+  file_output *output;
+  sigmf *meta;
+  char meta_path[4096];
+  char dataset[256];
+  uint32_t segment;
+  uint64_t segment_bytes;
+  struct timespec segment_start;
+};
+
+static void add_samples(const struct timespec *start, uint64_t samples, uint32_t sample_rate, struct timespec *result) {
+  // avoid overflow on very long recordings
+  uint64_t seconds = samples / sample_rate;
+  uint64_t nanos = (samples % sample_rate) * 1000000000ULL / sample_rate + (uint64_t) start->tv_nsec;
+  result->tv_sec = start->tv_sec + (time_t) seconds + (time_t) (nanos / 1000000000ULL);
+  result->tv_nsec = (long) (nanos % 1000000000ULL);
+}
+
+// captures are not aligned with the segment samples when something was dropped
+static int recording_add_capture(uint64_t dropped_samples, recording *recording) {
+  uint64_t samples_since_start = recording->total_samples + recording->total_dropped + recording->total_skipped;
+  struct timespec realtime;
+  struct timespec monotonic;
+  add_samples(&recording->start_realtime, samples_since_start, recording->config.sample_rate, &realtime);
+  add_samples(&recording->start_monotonic, samples_since_start, recording->config.sample_rate, &monotonic);
+  uint64_t sample_size = 2 * recording->config.lane_size;
+  return sigmf_add_capture(recording->segment_bytes / sample_size, &realtime, &monotonic, dropped_samples, recording->meta);
+}
+
+static void recording_close_segment(recording *recording) {
+  if (recording->output != NULL) {
+    file_output_destroy(recording->output);
+    recording->output = NULL;
+  }
+  if (recording->meta != NULL) {
+    if (sigmf_write(recording->meta_path, recording->dataset, recording->meta) != 0) {
+      fprintf(stderr, "<3>unable to write metadata: %s\n", recording->meta_path);
+    }
+    sigmf_destroy(recording->meta);
+    recording->meta = NULL;
+  }
+}
+
+static bool fits(int written, size_t output_len) {
+  return written >= 0 && (size_t) written < output_len;
+}
+
+static int recording_open_segment(recording *recording) {
+  struct server_config *server_config = recording->server_config;
+  // start from the different paths, so that several clients are spread across disks too
+  size_t index = (recording->config.id + recording->segment) % server_config->base_paths_len;
+  char file_prefix[4096];
+  char file_name[128];
+  if (recording->rotation_enabled) {
+    snprintf(file_name, sizeof(file_name), "%d.%d", recording->config.id, recording->segment);
+  } else {
+    snprintf(file_name, sizeof(file_name), "%d", recording->config.id);
+  }
+  char file_path[4096];
+  // truncated paths would send the data and the metadata into different files
+  if (!fits(snprintf(file_prefix, sizeof(file_prefix), "%s/%s", server_config->base_paths[index], file_name), sizeof(file_prefix)) ||
+      !fits(snprintf(recording->meta_path, sizeof(recording->meta_path), "%s%s", file_prefix, SIGMF_META_EXTENSION), sizeof(recording->meta_path)) ||
+      !fits(snprintf(recording->dataset, sizeof(recording->dataset), "%s.%s%s", file_name, recording->config.extension, file_output_get_extension(config_get_compression(server_config))), sizeof(recording->dataset)) ||
+      !fits(snprintf(file_path, sizeof(file_path), "%s.%s", file_prefix, recording->config.extension), sizeof(file_path))) {
+    fprintf(stderr, "<3>[%d] file path is too long\n", recording->config.id);
+    return -1;
+  }
+  int code = file_output_create(file_path, recording->config.lane_size, server_config, &recording->output);
+  if (code != 0) {
+    recording->output = NULL;
+    return code;
+  }
+  code = sigmf_create(recording->datatype, recording->config.sample_rate, recording->config.center_freq, &recording->meta);
+  if (code != 0) {
+    return code;
+  }
+  recording->segment_bytes = 0;
+  clock_gettime(CLOCK_MONOTONIC, &recording->segment_start);
+  return recording_add_capture(0, recording);
+}
+
+static bool recording_is_segment_complete(recording *recording) {
+  struct server_config *server_config = recording->server_config;
+  if (server_config->file_rotation_bytes > 0 && recording->segment_bytes >= server_config->file_rotation_bytes) {
+    return true;
+  }
+  if (server_config->file_rotation_seconds > 0) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    // whole seconds only would rotate up to a second earlier
+    int64_t elapsed_nanos = (int64_t) (now.tv_sec - recording->segment_start.tv_sec) * 1000000000 + (now.tv_nsec - recording->segment_start.tv_nsec);
+    if (elapsed_nanos >= (int64_t) server_config->file_rotation_seconds * 1000000000) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int recording_create(const recording_config *config, struct server_config *server_config, recording **result) {
+  if (server_config->base_paths_len == 0 || config->sample_rate == 0 || config->lane_size == 0) {
+    return -1;
+  }
+  struct recording_t *rec = malloc(sizeof(struct recording_t));
+  if (rec == NULL) {
+    return -ENOMEM;
+  }
+  *rec = (struct recording_t) {0};
+  rec->config = *config;
+  // keep a copy. config might be allocated on the stack
+  snprintf(rec->datatype, sizeof(rec->datatype), "%s", config->datatype);
+  rec->config.datatype = rec->datatype;
+  snprintf(rec->extension, sizeof(rec->extension), "%s", config->extension);
+  rec->config.extension = rec->extension;
+  rec->server_config = server_config;
+  rec->rotation_enabled = (server_config->file_rotation_bytes > 0 || server_config->file_rotation_seconds > 0);
+  clock_gettime(CLOCK_REALTIME, &rec->start_realtime);
+  clock_gettime(CLOCK_MONOTONIC, &rec->start_monotonic);
+  int code = recording_open_segment(rec);
+  if (code != 0) {
+    recording_destroy(rec);
+    return code;
+  }
+  *result = rec;
+  return 0;
+}
+
+void recording_set_start_time(const struct timespec *realtime, const struct timespec *monotonic, recording *recording) {
+  recording->start_realtime = *realtime;
+  recording->start_monotonic = *monotonic;
+  // update the first capture
+  if (recording->total_samples == 0 && recording->total_dropped == 0 && recording->total_skipped == 0 && recording->meta != NULL) {
+    recording_add_capture(0, recording);
+  }
+}
+
+int recording_write(const void *buffer, size_t len, uint64_t dropped_samples, recording *recording) {
+  // segment is completed before the write, so that a buffer is never split between files
+  if (recording->rotation_enabled && recording->segment_bytes > 0 && recording_is_segment_complete(recording)) {
+    recording_close_segment(recording);
+    recording->segment++;
+    int code = recording_open_segment(recording);
+    if (code != 0) {
+      return code;
+    }
+  }
+  if (dropped_samples > 0) {
+    recording->total_dropped += dropped_samples;
+    // the next sample starts new capture segment
+    int code = recording_add_capture(dropped_samples, recording);
+    if (code != 0) {
+      return code;
+    }
+  }
+  int code = file_output_write(buffer, len, recording->output);
+  if (code != 0) {
+    return code;
+  }
+  recording->segment_bytes += len;
+  recording->total_samples += len / (2 * recording->config.lane_size);
+  return 0;
+}
+
+int recording_skip(uint64_t samples, recording *recording) {
+  if (samples == 0) {
+    return 0;
+  }
+  recording->total_skipped += samples;
+  return recording_add_capture(0, recording);
+}
+
+void recording_destroy(recording *recording) {
+  if (recording == NULL) {
+    return;
+  }
+  recording_close_segment(recording);
+  free(recording);
+}
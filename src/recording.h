@@ -0,0 +1,41 @@
+#ifndef RECORDING_H_
+#define RECORDING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "config.h"
+
+typedef struct {
+  uint32_t id;
+  // SigMF datatype. For example, cf32_le
+  const char *datatype;
+  // file extension without the compression suffix. For example, cf32
+  const char *extension;
+  // size of a single I or Q value
+  uint8_t lane_size;
+  uint32_t sample_rate;
+  uint32_t center_freq;
+} recording_config;
+
+typedef struct recording_t recording;
+
+// recording is split into segments by size or duration (if configured)
+// segments are spread round-robin across all base paths
+// each segment has SigMF metadata file
+int recording_create(const recording_config *config, struct server_config *server_config, recording **result);
+
+// timestamps of the first sample. creation time is used by default
+void recording_set_start_time(const struct timespec *realtime, const struct timespec *monotonic, recording *recording);
+
+// dropped_samples - number of samples lost right before this buffer
+int recording_write(const void *buffer, size_t len, uint64_t dropped_samples, recording *recording);
+
+// samples which were intentionally not written. For example, by the squelch
+// the next write starts new capture
+int recording_skip(uint64_t samples, recording *recording);
+
+void recording_destroy(recording *recording);
+
+#endif /* RECORDING_H_ */
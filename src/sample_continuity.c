@@ -0,0 +1,146 @@
+#include "sample_continuity.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+struct sample_continuity_t {
+  uint32_t sampling_rate;
+  size_t sample_size;
+  uint32_t buffer_size;
+  uint64_t tolerance_samples;
+
+  struct timespec started;
+  struct timespec stopped;
+  atomic_bool running;
+  // the clock is anchored to the first buffer. Device setup doesn't count
+  bool anchored;
+
+  // written by the device thread
+  atomic_uint_fast64_t buffers;
+  atomic_uint_fast64_t bytes;
+  atomic_uint_fast64_t short_buffers;
+  atomic_uint_fast64_t samples;
+  atomic_uint_fast64_t dropped_samples;
+  atomic_uint_fast64_t lost_samples;
+  atomic_uint_fast64_t gaps;
+  // index of the next sample including dropped
+  uint64_t position;
+  // clock deficit already counted in lost_samples
+  uint64_t deficit;
+};
+
+int sample_continuity_create(uint32_t sampling_rate, size_t sample_size, uint32_t buffer_size, uint64_t tolerance_samples, sample_continuity **result) {
+  if (sampling_rate == 0 || sample_size == 0) {
+    return -1;
+  }
+  struct sample_continuity_t *continuity = malloc(sizeof(struct sample_continuity_t));
+  if (continuity == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *continuity = (struct sample_continuity_t){0};
+  continuity->sampling_rate = sampling_rate;
+  continuity->sample_size = sample_size;
+  continuity->buffer_size = buffer_size;
+  continuity->tolerance_samples = tolerance_samples;
+  *result = continuity;
+  return 0;
+}
+
+void sample_continuity_start(const struct timespec *now, sample_continuity *continuity) {
+  continuity->started = *now;
+  continuity->buffers = 0;
+  continuity->bytes = 0;
+  continuity->short_buffers = 0;
+  continuity->samples = 0;
+  continuity->dropped_samples = 0;
+  continuity->lost_samples = 0;
+  continuity->gaps = 0;
+  continuity->position = 0;
+  continuity->deficit = 0;
+  continuity->anchored = false;
+  continuity->running = true;
+}
+
+void sample_continuity_stop(const struct timespec *now, sample_continuity *continuity) {
+  continuity->stopped = *now;
+  continuity->running = false;
+}
+
+static uint64_t get_elapsed_ns(const struct timespec *now, sample_continuity *continuity) {
+  int64_t result = ((int64_t) now->tv_sec - (int64_t) continuity->started.tv_sec) * 1000000000LL + ((int64_t) now->tv_nsec - (int64_t) continuity->started.tv_nsec);
+  return (result > 0 ? (uint64_t) result : 0);
+}
+
+// number of samples the device should have produced by now
+static uint64_t get_expected_samples(const struct timespec *now, sample_continuity *continuity) {
+  uint64_t elapsed_ns = get_elapsed_ns(now, continuity);
+  return elapsed_ns / 1000000000ULL * continuity->sampling_rate + elapsed_ns % 1000000000ULL * continuity->sampling_rate / 1000000000ULL;
+}
+
+static void anchor(uint64_t buffer_samples, const struct timespec *now, sample_continuity *continuity) {
+  // the buffer is received only after all its samples were produced
+  uint64_t buffer_ns = buffer_samples * 1000000000ULL / continuity->sampling_rate;
+  int64_t started_ns = (int64_t) now->tv_sec * 1000000000LL + (int64_t) now->tv_nsec - (int64_t) buffer_ns;
+  continuity->started.tv_sec = (time_t) (started_ns / 1000000000LL);
+  continuity->started.tv_nsec = (long) (started_ns % 1000000000LL);
+  continuity->anchored = true;
+}
+
+void sample_continuity_update(uint32_t len, uint64_t dropped_samples, const struct timespec *now, sdr_buffer_info *info, sample_continuity *continuity) {
+  uint64_t buffer_samples = len / continuity->sample_size;
+  if (!continuity->anchored) {
+    anchor(buffer_samples, now, continuity);
+  }
+  // only the driver knows for sure that the samples were dropped
+  continuity->dropped_samples += dropped_samples;
+  continuity->position += dropped_samples;
+  if (dropped_samples > 0) {
+    continuity->gaps++;
+  }
+  // diagnostic only. Slow crystal or clock slew looks the same as the lost samples
+  uint64_t expected = get_expected_samples(now, continuity);
+  uint64_t received = continuity->position + buffer_samples + continuity->tolerance_samples + continuity->deficit;
+  if (expected > received) {
+    // only the lower bound. Some of the samples might be still in flight
+    uint64_t gap = expected - received;
+    continuity->lost_samples += gap;
+    continuity->deficit += gap;
+  }
+  continuity->buffers++;
+  continuity->bytes += len;
+  if (len < continuity->buffer_size) {
+    continuity->short_buffers++;
+  }
+  continuity->samples += buffer_samples;
+
+  info->received = *now;
+  info->sample_index = continuity->position;
+  info->lost_samples = dropped_samples;
+  continuity->position += buffer_samples;
+}
+
+void sample_continuity_get_stats(const struct timespec *now, sdr_device_stats *stats, sample_continuity *continuity) {
+  stats->buffers = continuity->buffers;
+  stats->bytes = continuity->bytes;
+  stats->short_buffers = continuity->short_buffers;
+  stats->samples = continuity->samples;
+  stats->dropped_samples = continuity->dropped_samples;
+  stats->lost_samples = continuity->lost_samples;
+  stats->gaps = continuity->gaps;
+  stats->observed_sampling_rate = 0;
+  const struct timespec *end = (continuity->running ? now : &continuity->stopped);
+  uint64_t elapsed_ns = get_elapsed_ns(end, continuity);
+  if (elapsed_ns > 0) {
+    stats->observed_sampling_rate = (uint32_t) ((double) stats->samples * 1000000000.0 / (double) elapsed_ns);
+  }
+}
+
+void sample_continuity_destroy(sample_continuity *continuity) {
+  if (continuity == NULL) {
+    return;
+  }
+  free(continuity);
+}
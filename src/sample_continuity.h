@@ -0,0 +1,29 @@
+#ifndef SAMPLE_CONTINUITY_H_
+#define SAMPLE_CONTINUITY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sdr_device_stats.h"
+
+typedef struct sample_continuity_t sample_continuity;
+
+// tolerance_samples - samples which can be legitimately delayed. For example, in the queued usb transfers
+int sample_continuity_create(uint32_t sampling_rate, size_t sample_size, uint32_t buffer_size, uint64_t tolerance_samples, sample_continuity **result);
+
+// reset all counters
+void sample_continuity_start(const struct timespec *now, sample_continuity *continuity);
+
+void sample_continuity_stop(const struct timespec *now, sample_continuity *continuity);
+
+// called from the device thread for every buffer
+// dropped_samples - samples the driver reported as dropped right before the buffer
+void sample_continuity_update(uint32_t len, uint64_t dropped_samples, const struct timespec *now, sdr_buffer_info *info, sample_continuity *continuity);
+
+// can be called from any thread
+void sample_continuity_get_stats(const struct timespec *now, sdr_device_stats *stats, sample_continuity *continuity);
+
+void sample_continuity_destroy(sample_continuity *continuity);
+
+#endif /* SAMPLE_CONTINUITY_H_ */
@@ -0,0 +1,154 @@
+#include "sample_filter.h"
+
+#include <string.h>
+
+// any value from 0x184D2A50 to 0x184D2A5F is skippable by both zstd and lz4
+#define HEADER_MAGIC 0x184D2A50
+#define TRAILER_MAGIC 0x184D2A51
+#define PAYLOAD_SIZE 12
+#define FORMAT_VERSION 1
+
+static void write_uint32(uint32_t value, uint8_t *output) {
+  for (int i = 0; i < 4; i++) {
+    output[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static uint32_t read_uint32(const uint8_t *input) {
+  return (uint32_t)input[0] | ((uint32_t)input[1] << 8) | ((uint32_t)input[2] << 16) | ((uint32_t)input[3] << 24);
+}
+
+// lanes are stored in the host byte order
+static uint32_t read_lane(const uint8_t *input, uint8_t lane_size) {
+  switch (lane_size) {
+    case 2: {
+      uint16_t value;
+      memcpy(&value, input, sizeof(value));
+      return value;
+    }
+    case 4: {
+      uint32_t value;
+      memcpy(&value, input, sizeof(value));
+      return value;
+    }
+    default:
+      return input[0];
+  }
+}
+
+static void write_lane(uint32_t value, uint8_t lane_size, uint8_t *output) {
+  switch (lane_size) {
+    case 2: {
+      uint16_t lane = (uint16_t)value;
+      memcpy(output, &lane, sizeof(lane));
+      break;
+    }
+    case 4: {
+      memcpy(output, &value, sizeof(value));
+      break;
+    }
+    default:
+      output[0] = (uint8_t)value;
+      break;
+  }
+}
+
+void sample_filter_encode(const uint8_t *input, size_t len, const sample_filter_header *header, uint8_t *output) {
+  if (header->filter == COMPRESSION_FILTER_NONE) {
+    memcpy(output, input, len);
+    return;
+  }
+  uint8_t lane_size = header->lane_size;
+  size_t lanes = len / lane_size;
+  uint8_t bytes[4];
+  for (size_t i = 0; i < lanes; i++) {
+    uint32_t value = read_lane(input + i * lane_size, lane_size);
+    // I is subtracted from the previous I, Q from the previous Q
+    if (header->filter == COMPRESSION_FILTER_DELTA && i >= 2) {
+      value -= read_lane(input + (i - 2) * lane_size, lane_size);
+    }
+    write_lane(value, lane_size, bytes);
+    // group the same bytes of all lanes together
+    for (uint8_t b = 0; b < lane_size; b++) {
+      output[b * lanes + i] = bytes[b];
+    }
+  }
+  // incomplete lane is stored as is
+  memcpy(output + lanes * lane_size, input + lanes * lane_size, len - lanes * lane_size);
+}
+
+void sample_filter_decode(const uint8_t *input, size_t len, const sample_filter_header *header, uint8_t *output) {
+  if (header->filter == COMPRESSION_FILTER_NONE) {
+    memcpy(output, input, len);
+    return;
+  }
+  uint8_t lane_size = header->lane_size;
+  size_t lanes = len / lane_size;
+  uint8_t bytes[4];
+  for (size_t i = 0; i < lanes; i++) {
+    for (uint8_t b = 0; b < lane_size; b++) {
+      bytes[b] = input[b * lanes + i];
+    }
+    uint32_t value = read_lane(bytes, lane_size);
+    if (header->filter == COMPRESSION_FILTER_DELTA && i >= 2) {
+      value += read_lane(output + (i - 2) * lane_size, lane_size);
+    }
+    write_lane(value, lane_size, output + i * lane_size);
+  }
+  memcpy(output + lanes * lane_size, input + lanes * lane_size, len - lanes * lane_size);
+}
+
+void sample_filter_format_header(const sample_filter_header *header, uint8_t output[SAMPLE_FILTER_HEADER_SIZE]) {
+  write_uint32(HEADER_MAGIC, output);
+  write_uint32(PAYLOAD_SIZE, output + 4);
+  memcpy(output + 8, "SDRF", 4);
+  output[12] = FORMAT_VERSION;
+  output[13] = (uint8_t)header->filter;
+  output[14] = header->lane_size;
+  output[15] = 0;
+  write_uint32(header->block_size, output + 16);
+}
+
+int sample_filter_parse_header(const uint8_t *input, size_t len, sample_filter_header *header) {
+  if (len < SAMPLE_FILTER_HEADER_SIZE) {
+    return -1;
+  }
+  if (read_uint32(input) != HEADER_MAGIC || read_uint32(input + 4) != PAYLOAD_SIZE || memcmp(input + 8, "SDRF", 4) != 0) {
+    return -1;
+  }
+  if (input[12] != FORMAT_VERSION) {
+    return -1;
+  }
+  if (input[13] != COMPRESSION_FILTER_NONE && input[13] != COMPRESSION_FILTER_SHUFFLE && input[13] != COMPRESSION_FILTER_DELTA) {
+    return -1;
+  }
+  if (input[14] != 1 && input[14] != 2 && input[14] != 4) {
+    return -1;
+  }
+  header->filter = (compression_filter)input[13];
+  header->lane_size = input[14];
+  header->block_size = read_uint32(input + 16);
+  if (header->block_size == 0) {
+    return -1;
+  }
+  return 0;
+}
+
+void sample_filter_format_trailer(uint64_t total_len, uint8_t output[SAMPLE_FILTER_TRAILER_SIZE]) {
+  write_uint32(TRAILER_MAGIC, output);
+  write_uint32(PAYLOAD_SIZE, output + 4);
+  memcpy(output + 8, "SDRE", 4);
+  write_uint32((uint32_t)total_len, output + 12);
+  write_uint32((uint32_t)(total_len >> 32), output + 16);
+}
+
+int sample_filter_parse_trailer(const uint8_t *input, size_t len, uint64_t *total_len) {
+  if (len < SAMPLE_FILTER_TRAILER_SIZE) {
+    return -1;
+  }
+  if (read_uint32(input) != TRAILER_MAGIC || read_uint32(input + 4) != PAYLOAD_SIZE || memcmp(input + 8, "SDRE", 4) != 0) {
+    return -1;
+  }
+  *total_len = (uint64_t)read_uint32(input + 12) | ((uint64_t)read_uint32(input + 16) << 32);
+  return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef SAMPLE_FILTER_H_
+#define SAMPLE_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// filter is applied on independent blocks of this size
+#define SAMPLE_FILTER_BLOCK_SIZE 65536
+// zstd and lz4 skippable frame: magic + length + payload
+#define SAMPLE_FILTER_HEADER_SIZE 20
+#define SAMPLE_FILTER_TRAILER_SIZE 20
+
+typedef struct {
+  compression_filter filter;
+  // size of a single I or Q value in bytes. 4 for cf32, 2 for cs16, 1 for cu8
+  uint8_t lane_size;
+  uint32_t block_size;
+} sample_filter_header;
+
+// output should have at least len bytes
+void sample_filter_encode(const uint8_t *input, size_t len, const sample_filter_header *header, uint8_t *output);
+
+void sample_filter_decode(const uint8_t *input, size_t len, const sample_filter_header *header, uint8_t *output);
+
+// header and trailer are stored as skippable frames. zstd and lz4 decoders ignore them
+void sample_filter_format_header(const sample_filter_header *header, uint8_t output[SAMPLE_FILTER_HEADER_SIZE]);
+
+int sample_filter_parse_header(const uint8_t *input, size_t len, sample_filter_header *header);
+
+void sample_filter_format_trailer(uint64_t total_len, uint8_t output[SAMPLE_FILTER_TRAILER_SIZE]);
+
+int sample_filter_parse_trailer(const uint8_t *input, size_t len, uint64_t *total_len);
+
+#endif /* SAMPLE_FILTER_H_ */
@@ -0,0 +1,153 @@
+#include "sample_memory.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define SAMPLE_MEMORY_HUGEPAGE (2 * 1024 * 1024)
+// keeps the memory aligned for AVX and cache lines
+#define SAMPLE_MEMORY_ALIGNMENT 64
+
+// allocations are rare: one per queue or filter buffer, so the list is enough
+struct sample_memory_mapping {
+  void *ptr;
+  size_t len;
+  struct sample_memory_mapping *next;
+};
+
+static bool sample_memory_hugepages = false;
+static bool sample_memory_prefault = false;
+static bool sample_memory_lock = false;
+
+static struct sample_memory_mapping *mappings = NULL;
+static pthread_mutex_t mappings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void sample_memory_configure(bool hugepages, bool prefault, bool lock) {
+  sample_memory_hugepages = hugepages;
+  sample_memory_prefault = prefault;
+  sample_memory_lock = lock;
+}
+
+static size_t round_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// transparent hugepages are used only for the 2MB aligned ranges
+static void *map_aligned_to_hugepage(size_t len) {
+  size_t mapped_len = len + SAMPLE_MEMORY_HUGEPAGE;
+  uint8_t *raw = mmap(NULL, mapped_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return NULL;
+  }
+  uint8_t *result = (uint8_t *) round_up((uintptr_t) raw, SAMPLE_MEMORY_HUGEPAGE);
+  size_t head = (size_t) (result - raw);
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  size_t tail = mapped_len - head - len;
+  if (tail > 0) {
+    munmap(result + len, tail);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(result, len, MADV_HUGEPAGE);
+#endif
+  return result;
+}
+
+static void *map_memory(size_t size, size_t *mapped_len) {
+  size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+  // smaller buffers would waste most of the hugepage
+  bool hugepages = sample_memory_hugepages && size >= SAMPLE_MEMORY_HUGEPAGE / 2;
+  if (hugepages) {
+    *mapped_len = round_up(size, SAMPLE_MEMORY_HUGEPAGE);
+#ifdef MAP_HUGETLB
+    int populate = 0;
+#ifdef MAP_POPULATE
+    if (sample_memory_prefault) {
+      populate = MAP_POPULATE;
+    }
+#endif
+    // only if hugepages were reserved via vm.nr_hugepages
+    void *result = mmap(NULL, *mapped_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+    if (result != MAP_FAILED) {
+      return result;
+    }
+#endif
+  }
+  uint8_t *result;
+  if (hugepages) {
+    result = map_aligned_to_hugepage(*mapped_len);
+  } else {
+    *mapped_len = round_up(size, page_size);
+    result = mmap(NULL, *mapped_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (result == MAP_FAILED) {
+      result = NULL;
+    }
+  }
+  if (result == NULL) {
+    return NULL;
+  }
+  // MAP_POPULATE before madvise would fault in 4KB pages
+  if (sample_memory_prefault) {
+    for (size_t i = 0; i < *mapped_len; i += page_size) {
+      ((volatile uint8_t *) result)[i] = 0;
+    }
+  }
+  return result;
+}
+
+void *sample_memory_alloc(size_t size) {
+  if (!sample_memory_hugepages && !sample_memory_prefault && !sample_memory_lock) {
+    return aligned_alloc(SAMPLE_MEMORY_ALIGNMENT, round_up(size, SAMPLE_MEMORY_ALIGNMENT));
+  }
+  struct sample_memory_mapping *mapping = malloc(sizeof(struct sample_memory_mapping));
+  if (mapping == NULL) {
+    return NULL;
+  }
+  mapping->ptr = map_memory(size, &mapping->len);
+  if (mapping->ptr == NULL) {
+    free(mapping);
+    return NULL;
+  }
+  if (sample_memory_lock && mlock(mapping->ptr, mapping->len) != 0) {
+    perror("unable to lock sample memory");
+  }
+  pthread_mutex_lock(&mappings_mutex);
+  mapping->next = mappings;
+  mappings = mapping;
+  pthread_mutex_unlock(&mappings_mutex);
+  return mapping->ptr;
+}
+
+void sample_memory_free(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&mappings_mutex);
+  struct sample_memory_mapping *previous = NULL;
+  struct sample_memory_mapping *current = mappings;
+  while (current != NULL && current->ptr != ptr) {
+    previous = current;
+    current = current->next;
+  }
+  if (current != NULL) {
+    if (previous == NULL) {
+      mappings = current->next;
+    } else {
+      previous->next = current->next;
+    }
+  }
+  pthread_mutex_unlock(&mappings_mutex);
+  // allocated when all options were disabled
+  if (current == NULL) {
+    free(ptr);
+    return;
+  }
+  // munlock is implicit
+  munmap(current->ptr, current->len);
+  free(current);
+}
@@ -0,0 +1,18 @@
+#ifndef SAMPLE_MEMORY_H_
+#define SAMPLE_MEMORY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// process-wide policy for the big sample buffers: queues and filter buffers
+// hugepages - back the allocations of 1MB and more with 2MB pages. Falls back to transparent hugepages
+// prefault - touch every page at allocation, so that the first buffers don't stall on page faults
+// lock - mlock the memory. Requires RLIMIT_MEMLOCK
+void sample_memory_configure(bool hugepages, bool prefault, bool lock);
+
+// 64 bytes aligned. Should be released by sample_memory_free
+void *sample_memory_alloc(size_t size);
+
+void sample_memory_free(void *ptr);
+
+#endif /* SAMPLE_MEMORY_H_ */
@@ -1,9 +1,17 @@
 #include "airspy_device.h"
 
 #include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "../queue.h"
+#include "../real_to_iq.h"
+
+// raw buffers waiting for the conversion. ~100ms at 10 Msps
+#define AIRSPY_CONVERTER_QUEUE_SIZE 16
+
 #define ERROR_CHECK(x, y)                       \
   do {                                          \
     int __err_rc = (x);                         \
@@ -20,14 +28,61 @@
 struct airspy_device_t {
   uint32_t id;
   struct airspy_device *dev;
-  void (*sdr_callback)(uint8_t *buf, uint32_t len, void *ctx);
+  void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx);
   void *ctx;
 
   struct server_config *server_config;
   airspy_lib *lib;
+
+  // real samples are converted here, not in the libairspy
+  // libairspy thread only copies them into the queue
+  real_to_iq *converter;
+  enum airspy_sample_type sample_type;
+  queue *raw_queue;
+  pthread_t converter_thread;
+  bool converter_started;
 };
 
-int airspy_device_create(struct server_config *server_config, airspy_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, void *ctx), void *ctx, void **plugin) {
+static void stop_converter(struct airspy_device_t *device) {
+  if (device->converter_started) {
+    interrupt_waiting_the_data(device->raw_queue);
+    pthread_join(device->converter_thread, NULL);
+    device->converter_started = false;
+  }
+  if (device->raw_queue != NULL) {
+    destroy_queue(device->raw_queue);
+    device->raw_queue = NULL;
+  }
+  real_to_iq_destroy(device->converter);
+  device->converter = NULL;
+}
+
+static void *converter_worker(void *arg) {
+  struct airspy_device_t *device = (struct airspy_device_t *)arg;
+  while (true) {
+    uint8_t *input = NULL;
+    size_t input_len = 0;
+    take_buffer_for_processing(&input, &input_len, device->raw_queue);
+    // poison pill
+    if (input == NULL) {
+      break;
+    }
+    // real samples. 2 of them make 1 iq sample
+    uint64_t dropped_samples = get_dropped_before_buffer(device->raw_queue) / sizeof(int16_t) / 2;
+    int16_t *output = NULL;
+    size_t output_len = 0;
+    if (device->sample_type == AIRSPY_SAMPLE_UINT16_REAL) {
+      real_to_iq_process_uint16((const uint16_t *)input, input_len / sizeof(uint16_t), &output, &output_len, device->converter);
+    } else {
+      real_to_iq_process_int16((const int16_t *)input, input_len / sizeof(int16_t), &output, &output_len, device->converter);
+    }
+    device->sdr_callback((uint8_t *)output, output_len * 2 * sizeof(int16_t), dropped_samples, device->ctx);
+    complete_buffer_processing(device->raw_queue);
+  }
+  return (void *)0;
+}
+
+int airspy_device_create(struct server_config *server_config, airspy_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin) {
   struct airspy_device_t *device = malloc(sizeof(struct airspy_device_t));
   if (device == NULL) {
     return -ENOMEM;
@@ -47,13 +102,29 @@ void airspy_device_destroy(void *plugin) {
     return;
   }
   struct airspy_device_t *device = (struct airspy_device_t *)plugin;
+  stop_converter(device);
   free(device);
   fprintf(stdout, "airspy device destroyed\n");
 }
 
 int airspy_device_callback(airspy_transfer *transfer) {
   struct airspy_device_t *device = (struct airspy_device_t *)transfer->ctx;
-  device->sdr_callback(transfer->samples, transfer->sample_count * 2 * sizeof(int16_t), device->ctx);
+  if (device->raw_queue == NULL) {
+    device->sdr_callback(transfer->samples, transfer->sample_count * 2 * sizeof(int16_t), transfer->dropped_samples, device->ctx);
+    return 0;
+  }
+  // both int16 and uint16 real samples are 2 bytes
+  size_t dropped_bytes = (size_t)transfer->dropped_samples * sizeof(int16_t);
+  // sample_count is the number of real samples. Converter output should not exceed buffer_size
+  size_t max_input_len = device->server_config->buffer_size / sizeof(int16_t);
+  for (size_t i = 0; i < (size_t)transfer->sample_count; i += max_input_len) {
+    size_t input_len = transfer->sample_count - i;
+    if (input_len > max_input_len) {
+      input_len = max_input_len;
+    }
+    queue_put_after_gap((const uint8_t *)((const int16_t *)transfer->samples + i), input_len * sizeof(int16_t), dropped_bytes, device->raw_queue);
+    dropped_bytes = 0;
+  }
   return 0;
 }
 
@@ -61,7 +132,30 @@ int airspy_device_start_rx(uint32_t band_freq, void *plugin) {
   struct airspy_device_t *device = (struct airspy_device_t *)plugin;
   struct server_config *server_config = device->server_config;
   ERROR_CHECK(device->lib->airspy_open(&device->dev), "<3>unable to init airspy device");
-  ERROR_CHECK(device->lib->airspy_set_sample_type(device->dev, AIRSPY_SAMPLE_INT16_IQ), "<3>unable to set sample type int16 iq");
+  switch (server_config->airspy_sample_type) {
+    case AIRSPY_SAMPLES_INT16_REAL: {
+      device->sample_type = AIRSPY_SAMPLE_INT16_REAL;
+      break;
+    }
+    case AIRSPY_SAMPLES_UINT16_REAL: {
+      device->sample_type = AIRSPY_SAMPLE_UINT16_REAL;
+      break;
+    }
+    default: {
+      device->sample_type = AIRSPY_SAMPLE_INT16_IQ;
+      break;
+    }
+  }
+  ERROR_CHECK(device->lib->airspy_set_sample_type(device->dev, device->sample_type), "<3>unable to set sample type");
+  // new stream - new filter history
+  stop_converter(device);
+  if (device->sample_type != AIRSPY_SAMPLE_INT16_IQ) {
+    ERROR_CHECK(real_to_iq_create(server_config->buffer_size / sizeof(int16_t), &device->converter), "<3>unable to create real to iq converter");
+    ERROR_CHECK(create_queue(server_config->buffer_size, AIRSPY_CONVERTER_QUEUE_SIZE, &device->raw_queue), "<3>unable to create real samples queue");
+    ERROR_CHECK(pthread_create(&device->converter_thread, NULL, &converter_worker, device), "<3>unable to start real to iq converter");
+    device->converter_started = true;
+    fprintf(stdout, "real samples are converted to iq by sdr-server\n");
+  }
   ERROR_CHECK(device->lib->airspy_set_samplerate(device->dev, server_config->band_sampling_rate), "<3>unable to set sample rate");
   ERROR_CHECK(device->lib->airspy_set_packing(device->dev, 1), "<3>unable to set packing");
   ERROR_CHECK(device->lib->airspy_set_rf_bias(device->dev, server_config->bias_t), "<3>unable to set bias_t");
@@ -105,4 +199,6 @@ void airspy_device_stop_rx(void *plugin) {
     device->lib->airspy_stop_rx(device->dev);
     device->lib->airspy_close(device->dev);
   }
+  // no more buffers from libairspy
+  stop_converter(device);
 }
@@ -4,7 +4,7 @@
 #include "../config.h"
 #include "airspy_lib.h"
 
-int airspy_device_create(struct server_config *server_config, airspy_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, void *ctx), void *ctx, void **plugin);
+int airspy_device_create(struct server_config *server_config, airspy_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin);
 
 void airspy_device_destroy(void *plugin);
 
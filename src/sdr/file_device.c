@@ -0,0 +1,130 @@
+#include "file_device.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../sdr_device.h"
+#include "pacer.h"
+
+struct file_device_t {
+  FILE *file;
+  pthread_t replay_thread;
+  atomic_bool running;
+  struct server_config *server_config;
+
+  uint8_t *output;
+  size_t output_len;
+
+  void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx);
+  void *ctx;
+};
+
+int file_device_create(struct server_config *server_config, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin) {
+  struct file_device_t *device = malloc(sizeof(struct file_device_t));
+  if (device == NULL) {
+    return -ENOMEM;
+  }
+  *device = (struct file_device_t){0};
+  device->sdr_callback = sdr_callback;
+  device->ctx = ctx;
+  device->server_config = server_config;
+  size_t sample_size = sdr_device_get_sample_size(server_config->replay_format);
+  // only whole samples
+  device->output_len = server_config->buffer_size / sample_size * sample_size;
+  if (device->output_len == 0) {
+    fprintf(stderr, "<3>buffer_size is too small: %u\n", server_config->buffer_size);
+    file_device_destroy(device);
+    return -1;
+  }
+  device->output = malloc(sizeof(uint8_t) * device->output_len);
+  if (device->output == NULL) {
+    file_device_destroy(device);
+    return -ENOMEM;
+  }
+  fprintf(stdout, "file device created\n");
+  *plugin = device;
+  return 0;
+}
+
+static void *file_device_replay(void *arg) {
+  struct file_device_t *device = (struct file_device_t *)arg;
+  struct server_config *server_config = device->server_config;
+  size_t sample_size = sdr_device_get_sample_size(server_config->replay_format);
+  pacer pacer;
+  pacer_start(server_config->band_sampling_rate, &pacer);
+  // rewinding the file without a single sample would spin forever
+  bool read_since_rewind = true;
+  while (device->running) {
+    size_t read = fread(device->output, sizeof(uint8_t), device->output_len, device->file);
+    // incomplete sample at the end of file
+    read = read / sample_size * sample_size;
+    if (read == 0) {
+      if (!server_config->replay_loop) {
+        fprintf(stdout, "replay finished: %s\n", server_config->replay_file);
+        break;
+      }
+      if (!read_since_rewind) {
+        fprintf(stderr, "<3>replay file doesn't have a single sample: %s\n", server_config->replay_file);
+        break;
+      }
+      rewind(device->file);
+      read_since_rewind = false;
+      continue;
+    }
+    read_since_rewind = true;
+    // the buffer is available only after all its samples were received
+    if (server_config->replay_realtime && !pacer_wait(read / sample_size, &device->running, &pacer)) {
+      break;
+    }
+    device->sdr_callback(device->output, (uint32_t)read, 0, device->ctx);
+  }
+  return (void *)0;
+}
+
+int file_device_start_rx(uint32_t band_freq, void *plugin) {
+  struct file_device_t *device = (struct file_device_t *)plugin;
+  device->file = fopen(device->server_config->replay_file, "rb");
+  if (device->file == NULL) {
+    fprintf(stderr, "<3>unable to open replay file: %s\n", device->server_config->replay_file);
+    return -1;
+  }
+  device->running = true;
+  int code = pthread_create(&device->replay_thread, NULL, &file_device_replay, device);
+  if (code != 0) {
+    device->running = false;
+    fclose(device->file);
+    device->file = NULL;
+    return 0x04;
+  }
+  return 0;
+}
+
+void file_device_stop_rx(void *plugin) {
+  if (plugin == NULL) {
+    return;
+  }
+  struct file_device_t *device = (struct file_device_t *)plugin;
+  if (device->file == NULL) {
+    return;
+  }
+  device->running = false;
+  pthread_join(device->replay_thread, NULL);
+  fclose(device->file);
+  device->file = NULL;
+}
+
+void file_device_destroy(void *plugin) {
+  if (plugin == NULL) {
+    return;
+  }
+  struct file_device_t *device = (struct file_device_t *)plugin;
+  if (device->output != NULL) {
+    free(device->output);
+  }
+  free(device);
+  fprintf(stdout, "file device destroyed\n");
+}
@@ -0,0 +1,15 @@
+#ifndef SDR_SERVER_FILE_DEVICE_H
+#define SDR_SERVER_FILE_DEVICE_H
+
+#include "../config.h"
+
+// replays replay_file as if it was received from the device
+int file_device_create(struct server_config *server_config, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin);
+
+void file_device_destroy(void *plugin);
+
+int file_device_start_rx(uint32_t band_freq, void *plugin);
+
+void file_device_stop_rx(void *plugin);
+
+#endif //SDR_SERVER_FILE_DEVICE_H
@@ -0,0 +1,105 @@
+#include "generator_device.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../sdr_device.h"
+#include "../signal_generator.h"
+#include "pacer.h"
+
+struct generator_device_t {
+  signal_generator *generator;
+  pthread_t generator_thread;
+  atomic_bool running;
+  bool started;
+  struct server_config *server_config;
+  size_t samples_per_buffer;
+
+  void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx);
+  void *ctx;
+};
+
+int generator_device_create(struct server_config *server_config, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin) {
+  struct generator_device_t *device = malloc(sizeof(struct generator_device_t));
+  if (device == NULL) {
+    return -ENOMEM;
+  }
+  *device = (struct generator_device_t){0};
+  device->sdr_callback = sdr_callback;
+  device->ctx = ctx;
+  device->server_config = server_config;
+  device->samples_per_buffer = server_config->buffer_size / sdr_device_get_sample_size(server_config->generator_format);
+  if (device->samples_per_buffer == 0) {
+    fprintf(stderr, "<3>buffer_size is too small: %u\n", server_config->buffer_size);
+    generator_device_destroy(device);
+    return -1;
+  }
+  fprintf(stdout, "generator device created\n");
+  *plugin = device;
+  return 0;
+}
+
+static void *generator_device_generate(void *arg) {
+  struct generator_device_t *device = (struct generator_device_t *)arg;
+  struct server_config *server_config = device->server_config;
+  size_t sample_size = sdr_device_get_sample_size(server_config->generator_format);
+  pacer pacer;
+  pacer_start(server_config->band_sampling_rate, &pacer);
+  while (device->running) {
+    uint8_t *output = NULL;
+    signal_generator_next(server_config->generator_format, device->samples_per_buffer, &output, device->generator);
+    if (server_config->generator_realtime && !pacer_wait(device->samples_per_buffer, &device->running, &pacer)) {
+      break;
+    }
+    device->sdr_callback(output, (uint32_t)(device->samples_per_buffer * sample_size), 0, device->ctx);
+  }
+  return (void *)0;
+}
+
+int generator_device_start_rx(uint32_t band_freq, void *plugin) {
+  struct generator_device_t *device = (struct generator_device_t *)plugin;
+  struct server_config *server_config = device->server_config;
+  // new stream starts from the beginning
+  signal_generator_destroy(device->generator);
+  device->generator = NULL;
+  int code = signal_generator_create(server_config->band_sampling_rate, server_config->generator_tones, server_config->generator_tones_len, server_config->generator_tone_amplitude, server_config->generator_noise_amplitude, server_config->generator_burst_ms, server_config->generator_burst_period_ms,
+                                     device->samples_per_buffer, &device->generator);
+  if (code != 0) {
+    fprintf(stderr, "<3>unable to create signal generator\n");
+    return code;
+  }
+  device->running = true;
+  code = pthread_create(&device->generator_thread, NULL, &generator_device_generate, device);
+  if (code != 0) {
+    device->running = false;
+    return 0x04;
+  }
+  device->started = true;
+  return 0;
+}
+
+void generator_device_stop_rx(void *plugin) {
+  if (plugin == NULL) {
+    return;
+  }
+  struct generator_device_t *device = (struct generator_device_t *)plugin;
+  if (!device->started) {
+    return;
+  }
+  device->running = false;
+  pthread_join(device->generator_thread, NULL);
+  device->started = false;
+}
+
+void generator_device_destroy(void *plugin) {
+  if (plugin == NULL) {
+    return;
+  }
+  struct generator_device_t *device = (struct generator_device_t *)plugin;
+  signal_generator_destroy(device->generator);
+  free(device);
+  fprintf(stdout, "generator device destroyed\n");
+}
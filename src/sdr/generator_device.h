@@ -0,0 +1,15 @@
+#ifndef SDR_SERVER_GENERATOR_DEVICE_H
+#define SDR_SERVER_GENERATOR_DEVICE_H
+
+#include "../config.h"
+
+// produces tones, noise and bursts configured in generator_* settings
+int generator_device_create(struct server_config *server_config, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin);
+
+void generator_device_destroy(void *plugin);
+
+int generator_device_start_rx(uint32_t band_freq, void *plugin);
+
+void generator_device_stop_rx(void *plugin);
+
+#endif //SDR_SERVER_GENERATOR_DEVICE_H
@@ -17,14 +17,14 @@
 typedef struct {
   uint32_t id;
   hackrf_device *dev;
-  void (*sdr_callback)(uint8_t *buf, uint32_t len, void *ctx);
+  void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx);
   void *ctx;
 
   struct server_config *server_config;
   hackrf_lib *lib;
 } hackrf_wrapper;
 
-int hackrf_device_create(struct server_config *server_config, hackrf_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, void *ctx), void *ctx, void **plugin) {
+int hackrf_device_create(struct server_config *server_config, hackrf_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin) {
   int code = lib->hackrf_init();
   if (code != 0) {
     fprintf(stderr, "<3>unable to initialize hackrf library: %s (%d)\n", lib->hackrf_error_name(code), code);
@@ -58,7 +58,7 @@ void hackrf_device_destroy(void *plugin) {
 
 static int hackrf_callback(hackrf_transfer *transfer) {
   hackrf_wrapper *device = (hackrf_wrapper *)transfer->rx_ctx;
-  device->sdr_callback(transfer->buffer, transfer->buffer_length, device->ctx);
+  device->sdr_callback(transfer->buffer, transfer->buffer_length, 0, device->ctx);
   return 0;
 }
 
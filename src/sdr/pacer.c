@@ -0,0 +1,31 @@
+#include "pacer.h"
+
+// stop request is checked at least this often while waiting
+#define MAX_SLEEP_NS 100000000LL
+
+void pacer_start(uint32_t sampling_rate, pacer *pacer) {
+  clock_gettime(CLOCK_MONOTONIC, &pacer->started);
+  pacer->sampling_rate = sampling_rate;
+  pacer->samples = 0;
+}
+
+bool pacer_wait(uint64_t samples, atomic_bool *running, pacer *pacer) {
+  pacer->samples += samples;
+  uint64_t elapsed_ns = pacer->samples / pacer->sampling_rate * 1000000000ULL + pacer->samples % pacer->sampling_rate * 1000000000ULL / pacer->sampling_rate;
+  uint64_t deadline_ns = (uint64_t)pacer->started.tv_nsec + elapsed_ns;
+  struct timespec deadline = {.tv_sec = pacer->started.tv_sec + (time_t)(deadline_ns / 1000000000ULL), .tv_nsec = (long)(deadline_ns % 1000000000ULL)};
+  while (*running) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t remaining = ((int64_t)deadline.tv_sec - (int64_t)now.tv_sec) * 1000000000LL + ((int64_t)deadline.tv_nsec - (int64_t)now.tv_nsec);
+    if (remaining <= 0) {
+      return true;
+    }
+    if (remaining > MAX_SLEEP_NS) {
+      remaining = MAX_SLEEP_NS;
+    }
+    struct timespec duration = {.tv_sec = (time_t)(remaining / 1000000000LL), .tv_nsec = (long)(remaining % 1000000000LL)};
+    nanosleep(&duration, NULL);
+  }
+  return false;
+}
@@ -0,0 +1,22 @@
+#ifndef SDR_SERVER_PACER_H
+#define SDR_SERVER_PACER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// keeps software devices at the real sample rate
+typedef struct {
+  struct timespec started;
+  uint32_t sampling_rate;
+  uint64_t samples;
+} pacer;
+
+void pacer_start(uint32_t sampling_rate, pacer *pacer);
+
+// waits until samples produced so far were due
+// returns false if device was stopped while waiting
+bool pacer_wait(uint64_t samples, atomic_bool *running, pacer *pacer);
+
+#endif //SDR_SERVER_PACER_H
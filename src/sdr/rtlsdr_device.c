@@ -16,7 +16,7 @@ struct rtlsdr_device_t {
   uint8_t *output;
   size_t output_len;
 
-  void (*rtlsdr_callback)(uint8_t *buf, uint32_t len, void *ctx);
+  void (*rtlsdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx);
   void *ctx;
 
   rtlsdr_lib *lib;
@@ -59,7 +59,7 @@ int find_nearest_gain(struct rtlsdr_device_t *dev, int target_gain, int *nearest
   return 0;
 }
 
-int rtlsdr_device_create(struct server_config *server_config, rtlsdr_lib *lib, void (*rtlsdr_callback)(uint8_t *buf, uint32_t len, void *ctx), void *ctx, void **plugin) {
+int rtlsdr_device_create(struct server_config *server_config, rtlsdr_lib *lib, void (*rtlsdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin) {
   struct rtlsdr_device_t *device = malloc(sizeof(struct rtlsdr_device_t));
   if (device == NULL) {
     return -ENOMEM;
@@ -81,16 +81,32 @@ int rtlsdr_device_create(struct server_config *server_config, rtlsdr_lib *lib, v
   return 0;
 }
 
+static void rtlsdr_async_callback(unsigned char *buf, uint32_t len, void *ctx) {
+  struct rtlsdr_device_t *device = (struct rtlsdr_device_t *)ctx;
+  if (!device->running) {
+    return;
+  }
+  // librtlsdr doesn't report lost transfers. They are detected by the sdr_device
+  device->rtlsdr_callback(buf, len, 0, device->ctx);
+}
+
 static void *rtlsdr_callback(void *arg) {
   struct rtlsdr_device_t *device = (struct rtlsdr_device_t *)arg;
-  device->running = true;
+  if (device->server_config->rtlsdr_async_buffers > 0) {
+    // several transfers are always queued in the kernel, so that usb is never idle
+    int code = device->lib->rtlsdr_read_async(device->dev, rtlsdr_async_callback, device, device->server_config->rtlsdr_async_buffers, device->output_len);
+    if (code != 0) {
+      fprintf(stderr, "<3>unable to read async: %d\n", code);
+    }
+    return (void *)0;
+  }
   int n_read = 0;
   while (device->running) {
     int code = device->lib->rtlsdr_read_sync(device->dev, device->output, device->output_len, &n_read);
     if (code != 0) {
       break;
     }
-    device->rtlsdr_callback(device->output, n_read, device->ctx);
+    rtlsdr_async_callback(device->output, n_read, device);
   }
   return (void *)0;
 }
@@ -126,6 +142,7 @@ int rtlsdr_device_start_rx(uint32_t band_freq, void *plugin) {
   ERROR_CHECK(lib->rtlsdr_set_bias_tee(device->dev, server_config->bias_t), "<3>unable to set bias tee");
   ERROR_CHECK(lib->rtlsdr_reset_buffer(device->dev), "<3>unable to reset buffers");
   ERROR_CHECK(lib->rtlsdr_set_center_freq(device->dev, band_freq), "<3>unable to set freq");
+  device->running = true;
   int code = pthread_create(&device->rtlsdr_device_thread, NULL, &rtlsdr_callback, device);
   if (code != 0) {
     return 0x04;
@@ -139,9 +156,16 @@ void rtlsdr_device_stop_rx(void *plugin) {
   }
   struct rtlsdr_device_t *device = (struct rtlsdr_device_t *)plugin;
   device->running = false;
-  device->lib->rtlsdr_close(device->dev);
+  if (device->server_config->rtlsdr_async_buffers > 0) {
+    // device can be closed only after async read returned
+    device->lib->rtlsdr_cancel_async(device->dev);
+    pthread_join(device->rtlsdr_device_thread, NULL);
+    device->lib->rtlsdr_close(device->dev);
+  } else {
+    device->lib->rtlsdr_close(device->dev);
+    pthread_join(device->rtlsdr_device_thread, NULL);
+  }
   device->dev = NULL;
-  pthread_join(device->rtlsdr_device_thread, NULL);
 }
 
 void rtlsdr_device_destroy(void *plugin) {
@@ -4,7 +4,7 @@
 #include "rtlsdr_lib.h"
 #include "../config.h"
 
-int rtlsdr_device_create(struct server_config *server_config, rtlsdr_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, void *ctx), void *ctx, void **plugin);
+int rtlsdr_device_create(struct server_config *server_config, rtlsdr_lib *lib, void (*sdr_callback)(uint8_t *buf, uint32_t len, uint64_t dropped_samples, void *ctx), void *ctx, void **plugin);
 
 void rtlsdr_device_destroy(void *plugin);
 
@@ -28,6 +28,10 @@ struct rtlsdr_lib_t {
 
   int (*rtlsdr_read_sync)(rtlsdr_dev_t *dev, void *buf, int len, int *n_read);
 
+  int (*rtlsdr_read_async)(rtlsdr_dev_t *dev, rtlsdr_read_async_cb_t cb, void *ctx, uint32_t buf_num, uint32_t buf_len);
+
+  int (*rtlsdr_cancel_async)(rtlsdr_dev_t *dev);
+
   int (*rtlsdr_set_freq_correction)(rtlsdr_dev_t *dev, int ppm);
 
   int (*rtlsdr_get_index_by_serial)(const char *serial);
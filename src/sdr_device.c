@@ -2,25 +2,48 @@
 
 #include <complex.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <zlib.h>
 
 #include "sdr/airspy_device.h"
+#include "sdr/file_device.h"
+#include "sdr/generator_device.h"
 #include "sdr/hackrf_device.h"
+#include "histogram.h"
+#include "sample_continuity.h"
+#include "thread_scheduling.h"
 #include "sdr/rtlsdr_device.h"
 
+// libairspy and libhackrf queue their own usb transfers
+#define DEFAULT_BUFFERS_IN_FLIGHT 16
+
 struct sdr_device_t {
   struct server_config *server_config;
 
   rtlsdr_lib *rtllib;
   airspy_lib *airspy;
   hackrf_lib *hackrf;
-  void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void *ctx);
+  void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, const sdr_buffer_info *info, void *ctx);
   void *ctx;
+  sample_continuity *continuity;
+  // NULL if stage_stats disabled
+  histogram *callback;
+  // lost samples are counted and logged at most once per log_summary_seconds
+  uint64_t log_summary_nanos;
+  struct timespec last_summary;
+  uint64_t summary_dropped_samples;
+  uint64_t summary_lost_samples;
+  // device_cpus and device_priority are applied to the thread of the first buffer
+  bool thread_configured;
+  atomic_uint_fast64_t thread_cpus;
+  atomic_int thread_priority;
 
   void *plugin;
   void (*destroy)(void *plugin);
@@ -28,7 +51,74 @@ struct sdr_device_t {
   void (*stop_rx)(void *plugin);
 };
 
-int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void *ctx), void *ctx, struct server_config *server_config, sdr_device **device) {
+sample_format_t sdr_device_get_sample_format(struct server_config *server_config) {
+  switch (server_config->sdr_type) {
+    case SDR_TYPE_AIRSPY:
+      return SAMPLE_FORMAT_CS16;
+    case SDR_TYPE_HACKRF:
+      return SAMPLE_FORMAT_CS8;
+    case SDR_TYPE_FILE:
+      return server_config->replay_format;
+    case SDR_TYPE_GENERATOR:
+      return server_config->generator_format;
+    default:
+      return SAMPLE_FORMAT_CU8;
+  }
+}
+
+size_t sdr_device_get_sample_size(sample_format_t sample_format) {
+  switch (sample_format) {
+    case SAMPLE_FORMAT_CS16:
+      return 2 * sizeof(int16_t);
+    default:
+      return 2 * sizeof(uint8_t);
+  }
+}
+
+static uint64_t get_elapsed_nanos(const struct timespec *start, const struct timespec *end) {
+  return (uint64_t) ((int64_t) (end->tv_sec - start->tv_sec) * 1000000000LL + (end->tv_nsec - start->tv_nsec));
+}
+
+static void log_summary(const struct timespec *now, sdr_device *device) {
+  sdr_device_stats stats;
+  sample_continuity_get_stats(now, &stats, device->continuity);
+  if (stats.dropped_samples > device->summary_dropped_samples || stats.lost_samples > device->summary_lost_samples) {
+    fprintf(stderr, "<3>last %.1f seconds: %" PRIu64 " samples dropped, %" PRIu64 " samples behind the clock. total gaps: %" PRIu64 "\n", (double) get_elapsed_nanos(&device->last_summary, now) / 1000000000.0, stats.dropped_samples - device->summary_dropped_samples, stats.lost_samples - device->summary_lost_samples, stats.gaps);
+  }
+  device->summary_dropped_samples = stats.dropped_samples;
+  device->summary_lost_samples = stats.lost_samples;
+  device->last_summary = *now;
+}
+
+// every buffer is stamped before it goes to the clients
+static void sdr_device_callback(uint8_t *buf, uint32_t buf_len, uint64_t dropped_samples, void *ctx) {
+  struct sdr_device_t *device = (struct sdr_device_t *)ctx;
+  // libairspy and libhackrf create their threads internally
+  if (!device->thread_configured) {
+    thread_scheduling_apply("device", device->server_config->device_cpus, device->server_config->device_priority);
+    device->thread_cpus = thread_scheduling_get_cpus();
+    device->thread_priority = thread_scheduling_get_priority();
+    device->thread_configured = true;
+    fprintf(stdout, "device thread cpus: 0x%" PRIx64 " priority: %d\n", (uint64_t) device->thread_cpus, (int) device->thread_priority);
+  }
+  sdr_buffer_info info;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  sample_continuity_update(buf_len, dropped_samples, &now, &info, device->continuity);
+  if (device->log_summary_nanos > 0 && get_elapsed_nanos(&device->last_summary, &now) >= device->log_summary_nanos) {
+    log_summary(&now, device);
+  }
+  if (device->callback == NULL) {
+    device->sdr_callback(buf, buf_len, &info, device->ctx);
+    return;
+  }
+  device->sdr_callback(buf, buf_len, &info, device->ctx);
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  histogram_record((uint64_t) (end.tv_sec - now.tv_sec) * 1000000000ULL + (uint64_t) end.tv_nsec - (uint64_t) now.tv_nsec, device->callback);
+}
+
+int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, const sdr_buffer_info *info, void *ctx), void *ctx, struct server_config *server_config, sdr_device **device) {
   struct sdr_device_t *result = malloc(sizeof(struct sdr_device_t));
   if (result == NULL) {
     return -ENOMEM;
@@ -38,6 +128,7 @@ int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void
   result->server_config = server_config;
   result->sdr_callback = sdr_callback;
   result->ctx = ctx;
+  result->log_summary_nanos = (uint64_t) server_config->log_summary_seconds * 1000000000ULL;
   int code = -1;
   switch (server_config->sdr_type) {
     case SDR_TYPE_RTL: {
@@ -61,6 +152,20 @@ int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void
       result->stop_rx = hackrf_device_stop_rx;
       break;
     }
+    case SDR_TYPE_FILE: {
+      code = 0;
+      result->destroy = file_device_destroy;
+      result->start_rx = file_device_start_rx;
+      result->stop_rx = file_device_stop_rx;
+      break;
+    }
+    case SDR_TYPE_GENERATOR: {
+      code = 0;
+      result->destroy = generator_device_destroy;
+      result->start_rx = generator_device_start_rx;
+      result->stop_rx = generator_device_stop_rx;
+      break;
+    }
     default: {
       fprintf(stderr, "<3>unsupported sdr type: %d\n", server_config->sdr_type);
       code = -1;
@@ -71,6 +176,28 @@ int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void
     sdr_device_destroy(result);
     return code;
   }
+  uint32_t buffers_in_flight = DEFAULT_BUFFERS_IN_FLIGHT;
+  if (server_config->sdr_type == SDR_TYPE_RTL) {
+    buffers_in_flight = (server_config->rtlsdr_async_buffers > 0 ? server_config->rtlsdr_async_buffers : 1);
+  } else if (server_config->sdr_type == SDR_TYPE_FILE || server_config->sdr_type == SDR_TYPE_GENERATOR) {
+    buffers_in_flight = 1;
+  }
+  size_t sample_size = sdr_device_get_sample_size(sdr_device_get_sample_format(server_config));
+  // plus the buffer being processed
+  uint64_t tolerance_samples = (uint64_t)(buffers_in_flight + 1) * server_config->buffer_size / sample_size;
+  code = sample_continuity_create(server_config->band_sampling_rate, sample_size, server_config->buffer_size, tolerance_samples, &result->continuity);
+  if (code != 0) {
+    sdr_device_destroy(result);
+    return code;
+  }
+  if (server_config->stage_stats) {
+    result->callback = malloc(sizeof(histogram));
+    if (result->callback == NULL) {
+      sdr_device_destroy(result);
+      return -ENOMEM;
+    }
+    histogram_reset(result->callback);
+  }
   *device = result;
   return 0;
 }
@@ -78,21 +205,29 @@ int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void
 int sdr_device_start(client_config *config, sdr_device *device) {
   if (device->plugin == NULL) {
     int code = -1;
-    switch (config->sdr_type) {
+    switch (device->server_config->sdr_type) {
       case SDR_TYPE_RTL: {
-        code = rtlsdr_device_create(device->server_config, device->rtllib, device->sdr_callback, device->ctx, &device->plugin);
+        code = rtlsdr_device_create(device->server_config, device->rtllib, sdr_device_callback, device, &device->plugin);
         break;
       }
       case SDR_TYPE_AIRSPY: {
-        code = airspy_device_create(device->server_config, device->airspy, device->sdr_callback, device->ctx, &device->plugin);
+        code = airspy_device_create(device->server_config, device->airspy, sdr_device_callback, device, &device->plugin);
         break;
       }
       case SDR_TYPE_HACKRF: {
-        code = hackrf_device_create(device->server_config, device->hackrf, device->sdr_callback, device->ctx, &device->plugin);
+        code = hackrf_device_create(device->server_config, device->hackrf, sdr_device_callback, device, &device->plugin);
+        break;
+      }
+      case SDR_TYPE_FILE: {
+        code = file_device_create(device->server_config, sdr_device_callback, device, &device->plugin);
+        break;
+      }
+      case SDR_TYPE_GENERATOR: {
+        code = generator_device_create(device->server_config, sdr_device_callback, device, &device->plugin);
         break;
       }
       default: {
-        fprintf(stderr, "<3>unsupported sdr type: %d\n", config->sdr_type);
+        fprintf(stderr, "<3>unsupported sdr type: %d\n", device->server_config->sdr_type);
         code = -1;
         break;
       }
@@ -102,6 +237,14 @@ int sdr_device_start(client_config *config, sdr_device *device) {
       return 0x04;
     }
   }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  // the clock is anchored to the first buffer, so start_rx time is not counted
+  sample_continuity_start(&now, device->continuity);
+  device->last_summary = now;
+  device->summary_dropped_samples = 0;
+  device->summary_lost_samples = 0;
+  device->thread_configured = false;
   int code = device->start_rx(config->band_freq, device->plugin);
   if (code != 0) {
     fprintf(stderr, "<3>unable to start rx\n");
@@ -115,6 +258,29 @@ int sdr_device_start(client_config *config, sdr_device *device) {
 void sdr_device_stop(sdr_device *device) {
   // synchronous wait until all threads shutdown
   device->stop_rx(device->plugin);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  sample_continuity_stop(&now, device->continuity);
+  sdr_device_stats stats;
+  sdr_device_get_stats(device, &stats);
+  fprintf(stdout, "sdr stopped. buffers: %" PRIu64 " short buffers: %" PRIu64 " dropped samples: %" PRIu64 " lost samples: %" PRIu64 " observed sampling rate: %" PRIu32 "\n", stats.buffers, stats.short_buffers, stats.dropped_samples, stats.lost_samples, stats.observed_sampling_rate);
+}
+
+void sdr_device_get_stats(sdr_device *device, sdr_device_stats *stats) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  sample_continuity_get_stats(&now, stats, device->continuity);
+  stats->thread_cpus = device->thread_cpus;
+  stats->thread_priority = device->thread_priority;
+  if (device->callback == NULL) {
+    stats->callback_p50_nanos = 0;
+    stats->callback_p99_nanos = 0;
+    stats->callback_max_nanos = 0;
+    return;
+  }
+  stats->callback_p50_nanos = histogram_percentile(50.0, device->callback);
+  stats->callback_p99_nanos = histogram_percentile(99.0, device->callback);
+  stats->callback_max_nanos = device->callback->max;
 }
 
 void sdr_device_destroy(sdr_device *device) {
@@ -133,6 +299,10 @@ void sdr_device_destroy(sdr_device *device) {
   if (device->hackrf != NULL) {
     hackrf_lib_destroy(device->hackrf);
   }
+  sample_continuity_destroy(device->continuity);
+  if (device->callback != NULL) {
+    free(device->callback);
+  }
   fprintf(stdout, "sdr destroyed\n");
   free(device);
 }
@@ -3,15 +3,25 @@
 
 #include "config.h"
 #include "dsp_worker.h"
+#include "sdr_device_stats.h"
 
 typedef struct sdr_device_t sdr_device;
 
-int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, void *ctx), void *ctx, struct server_config *server_config, sdr_device **result);
+sample_format_t sdr_device_get_sample_format(struct server_config *server_config);
+
+// size of a single I/Q sample produced by the device
+size_t sdr_device_get_sample_size(sample_format_t sample_format);
+
+// every buffer comes with the monotonic timestamp, sample index and the number of samples lost before it
+int sdr_device_create(void (*sdr_callback)(uint8_t *buf, uint32_t buf_len, const sdr_buffer_info *info, void *ctx), void *ctx, struct server_config *server_config, sdr_device **result);
 
 int sdr_device_start(client_config *config, sdr_device *sdr_device);
 
 void sdr_device_stop(sdr_device *sdr_device);
 
+// sample continuity counters since the device was started
+void sdr_device_get_stats(sdr_device *sdr_device, sdr_device_stats *stats);
+
 void sdr_device_destroy(sdr_device *sdr_device);
 
 #endif /* SDR_DEVICE_H_ */
@@ -0,0 +1,43 @@
+#ifndef SDR_DEVICE_STATS_H_
+#define SDR_DEVICE_STATS_H_
+
+#include <stdint.h>
+#include <time.h>
+
+// sample continuity counters since the device was started
+typedef struct {
+  // number of buffers received from the device
+  uint64_t buffers;
+  uint64_t bytes;
+  // buffers shorter than requested
+  uint64_t short_buffers;
+  uint64_t samples;
+  // reported by the driver. For example, airspy dropped_samples
+  uint64_t dropped_samples;
+  // received samples fell behind the monotonic clock more than buffers in flight can explain
+  // diagnostic only: slow crystal or clock slew look the same. Not reported as gaps
+  uint64_t lost_samples;
+  // number of buffers with dropped samples right before them
+  uint64_t gaps;
+  // samples per second since the device was started
+  uint32_t observed_sampling_rate;
+  // cpus and SCHED_FIFO priority of the device thread. 0 until the first buffer
+  uint64_t thread_cpus;
+  int32_t thread_priority;
+  // time spent in the device callback distributing the buffer to the clients. 0 if stage_stats disabled
+  uint64_t callback_p50_nanos;
+  uint64_t callback_p99_nanos;
+  uint64_t callback_max_nanos;
+} sdr_device_stats;
+
+// stamped on every buffer received from the device
+typedef struct {
+  // monotonic clock when the buffer was received
+  struct timespec received;
+  // index of the first sample of the buffer. Includes dropped samples
+  uint64_t sample_index;
+  // dropped samples right before the buffer
+  uint64_t lost_samples;
+} sdr_buffer_info;
+
+#endif /* SDR_DEVICE_STATS_H_ */
@@ -0,0 +1,132 @@
+#include "sigmf.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct sigmf_capture {
+  uint64_t sample_start;
+  struct timespec realtime;
+  struct timespec monotonic;
+  uint64_t dropped_samples;
+};
+
+struct sigmf_t {
+  char datatype[16];
+  uint32_t sample_rate;
+  uint32_t frequency;
+
+  struct sigmf_capture *captures;
+  size_t captures_len;
+  size_t captures_capacity;
+};
+
+int sigmf_create(const char *datatype, uint32_t sample_rate, uint32_t frequency, sigmf **meta) {
+  struct sigmf_t *result = malloc(sizeof(struct sigmf_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  *result = (struct sigmf_t){0};
+  snprintf(result->datatype, sizeof(result->datatype), "%s", datatype);
+  result->sample_rate = sample_rate;
+  result->frequency = frequency;
+  result->captures_capacity = 4;
+  result->captures = malloc(sizeof(struct sigmf_capture) * result->captures_capacity);
+  if (result->captures == NULL) {
+    sigmf_destroy(result);
+    return -ENOMEM;
+  }
+  *meta = result;
+  return 0;
+}
+
+int sigmf_add_capture(uint64_t sample_start, const struct timespec *realtime, const struct timespec *monotonic, uint64_t dropped_samples, sigmf *meta) {
+  if (meta->captures_len > 0) {
+    struct sigmf_capture *last = &meta->captures[meta->captures_len - 1];
+    if (last->sample_start == sample_start) {
+      last->realtime = *realtime;
+      last->monotonic = *monotonic;
+      last->dropped_samples += dropped_samples;
+      return 0;
+    }
+  }
+  if (meta->captures_len == meta->captures_capacity) {
+    size_t capacity = meta->captures_capacity * 2;
+    struct sigmf_capture *captures = realloc(meta->captures, sizeof(struct sigmf_capture) * capacity);
+    if (captures == NULL) {
+      return -ENOMEM;
+    }
+    meta->captures = captures;
+    meta->captures_capacity = capacity;
+  }
+  struct sigmf_capture *capture = &meta->captures[meta->captures_len];
+  capture->sample_start = sample_start;
+  capture->realtime = *realtime;
+  capture->monotonic = *monotonic;
+  capture->dropped_samples = dropped_samples;
+  meta->captures_len++;
+  return 0;
+}
+
+// ISO 8601 with nanoseconds
+static void sigmf_format_datetime(const struct timespec *value, char *output, size_t output_len) {
+  struct tm tm;
+  time_t seconds = value->tv_sec;
+  gmtime_r(&seconds, &tm);
+  char date[32];
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm);
+  snprintf(output, output_len, "%s.%09ldZ", date, value->tv_nsec);
+}
+
+int sigmf_write(const char *meta_path, const char *dataset, sigmf *meta) {
+  FILE *fp = fopen(meta_path, "w");
+  if (fp == NULL) {
+    return -1;
+  }
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"global\": {\n");
+  fprintf(fp, "    \"core:datatype\": \"%s\",\n", meta->datatype);
+  fprintf(fp, "    \"core:sample_rate\": %" PRIu32 ",\n", meta->sample_rate);
+  fprintf(fp, "    \"core:version\": \"1.0.0\",\n");
+  fprintf(fp, "    \"core:recorder\": \"sdr-server\",\n");
+  fprintf(fp, "    \"core:dataset\": \"%s\",\n", dataset);
+  fprintf(fp, "    \"core:extensions\": [{\"name\": \"sdr_server\", \"version\": \"1.0.0\", \"optional\": true}]\n");
+  fprintf(fp, "  },\n");
+  fprintf(fp, "  \"captures\": [");
+  char datetime[64];
+  for (size_t i = 0; i < meta->captures_len; i++) {
+    struct sigmf_capture *capture = &meta->captures[i];
+    sigmf_format_datetime(&capture->realtime, datetime, sizeof(datetime));
+    uint64_t monotonic_ns = (uint64_t)capture->monotonic.tv_sec * 1000000000ULL + (uint64_t)capture->monotonic.tv_nsec;
+    fprintf(fp, "%s\n    {\"core:sample_start\": %" PRIu64 ", \"core:frequency\": %" PRIu32 ", \"core:datetime\": \"%s\", \"sdr_server:monotonic_ns\": %" PRIu64 "}", (i == 0 ? "" : ","), capture->sample_start, meta->frequency, datetime, monotonic_ns);
+  }
+  fprintf(fp, "\n  ],\n");
+  fprintf(fp, "  \"annotations\": [");
+  int annotations = 0;
+  for (size_t i = 0; i < meta->captures_len; i++) {
+    struct sigmf_capture *capture = &meta->captures[i];
+    if (capture->dropped_samples == 0) {
+      continue;
+    }
+    fprintf(fp, "%s\n    {\"core:sample_start\": %" PRIu64 ", \"core:label\": \"gap\", \"core:comment\": \"%" PRIu64 " samples dropped before this sample\", \"sdr_server:dropped_samples\": %" PRIu64 "}", (annotations == 0 ? "" : ","), capture->sample_start, capture->dropped_samples, capture->dropped_samples);
+    annotations++;
+  }
+  fprintf(fp, "\n  ]\n");
+  fprintf(fp, "}\n");
+  if (fclose(fp) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+void sigmf_destroy(sigmf *meta) {
+  if (meta == NULL) {
+    return;
+  }
+  if (meta->captures != NULL) {
+    free(meta->captures);
+  }
+  free(meta);
+}
@@ -0,0 +1,23 @@
+#ifndef SIGMF_H_
+#define SIGMF_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#define SIGMF_META_EXTENSION ".sigmf-meta"
+
+typedef struct sigmf_t sigmf;
+
+int sigmf_create(const char *datatype, uint32_t sample_rate, uint32_t frequency, sigmf **meta);
+
+// new capture segment starts at sample_start. realtime and monotonic are the timestamps of this sample
+// dropped_samples > 0 adds the gap annotation
+// capture with the same sample_start replaces the previous one and sums up dropped samples
+int sigmf_add_capture(uint64_t sample_start, const struct timespec *realtime, const struct timespec *monotonic, uint64_t dropped_samples, sigmf *meta);
+
+// dataset is the file name of the data file relative to the meta file
+int sigmf_write(const char *meta_path, const char *dataset, sigmf *meta);
+
+void sigmf_destroy(sigmf *meta);
+
+#endif /* SIGMF_H_ */
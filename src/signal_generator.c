@@ -0,0 +1,208 @@
+#include "signal_generator.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// tones are generated in blocks: phase at the block start multiplied by the precomputed rotations
+// the inner loop has no dependencies between samples and is vectorized by the compiler
+#define BLOCK_LEN 64
+
+struct tone {
+  float phase_re;
+  float phase_im;
+  // e^(j*w*k) for k = 0..BLOCK_LEN
+  float rotation_re[BLOCK_LEN + 1];
+  float rotation_im[BLOCK_LEN + 1];
+};
+
+struct signal_generator_t {
+  struct tone *tones;
+  size_t tones_len;
+  float tone_amplitude;
+  // uniform sum of 2 is scaled to the requested rms
+  float noise_scale;
+  uint64_t burst_samples;
+  uint64_t burst_period_samples;
+
+  float *re;
+  float *im;
+  uint8_t *output;
+  size_t max_samples;
+
+  // number of samples generated so far
+  uint64_t position;
+};
+
+int signal_generator_create(uint32_t sampling_rate, const int32_t *tones, size_t tones_len, float tone_amplitude, float noise_amplitude, uint32_t burst_ms, uint32_t burst_period_ms, size_t max_samples, signal_generator **result) {
+  if (sampling_rate == 0 || max_samples == 0 || (burst_ms > 0 && burst_period_ms < burst_ms)) {
+    return -1;
+  }
+  struct signal_generator_t *generator = malloc(sizeof(struct signal_generator_t));
+  if (generator == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *generator = (struct signal_generator_t){0};
+  generator->tone_amplitude = tone_amplitude;
+  generator->noise_scale = noise_amplitude * sqrtf(6.0f);
+  if (burst_ms > 0) {
+    generator->burst_samples = (uint64_t)sampling_rate * burst_ms / 1000;
+    generator->burst_period_samples = (uint64_t)sampling_rate * burst_period_ms / 1000;
+  }
+  generator->max_samples = max_samples;
+  if (tones_len > 0) {
+    generator->tones = malloc(sizeof(struct tone) * tones_len);
+    if (generator->tones == NULL) {
+      signal_generator_destroy(generator);
+      return -ENOMEM;
+    }
+    generator->tones_len = tones_len;
+    for (size_t i = 0; i < tones_len; i++) {
+      struct tone *tone = generator->tones + i;
+      tone->phase_re = 1.0f;
+      tone->phase_im = 0.0f;
+      double step = 2.0 * M_PI * tones[i] / sampling_rate;
+      for (int k = 0; k <= BLOCK_LEN; k++) {
+        tone->rotation_re[k] = (float)cos(step * k);
+        tone->rotation_im[k] = (float)sin(step * k);
+      }
+    }
+  }
+  generator->re = malloc(sizeof(float) * max_samples);
+  generator->im = malloc(sizeof(float) * max_samples);
+  // the biggest sample is cs16
+  generator->output = malloc(sizeof(int16_t) * 2 * max_samples);
+  if (generator->re == NULL || generator->im == NULL || generator->output == NULL) {
+    signal_generator_destroy(generator);
+    return -ENOMEM;
+  }
+  *result = generator;
+  return 0;
+}
+
+static void generate_tone(struct tone *tone, size_t len, float *re, float *im) {
+  for (size_t start = 0; start < len; start += BLOCK_LEN) {
+    size_t block = len - start;
+    if (block > BLOCK_LEN) {
+      block = BLOCK_LEN;
+    }
+    float phase_re = tone->phase_re;
+    float phase_im = tone->phase_im;
+    float *block_re = re + start;
+    float *block_im = im + start;
+    for (size_t k = 0; k < block; k++) {
+      block_re[k] += phase_re * tone->rotation_re[k] - phase_im * tone->rotation_im[k];
+      block_im[k] += phase_re * tone->rotation_im[k] + phase_im * tone->rotation_re[k];
+    }
+    float next_re = phase_re * tone->rotation_re[block] - phase_im * tone->rotation_im[block];
+    float next_im = phase_re * tone->rotation_im[block] + phase_im * tone->rotation_re[block];
+    // keep the amplitude from drifting
+    float magnitude = sqrtf(next_re * next_re + next_im * next_im);
+    tone->phase_re = next_re / magnitude;
+    tone->phase_im = next_im / magnitude;
+  }
+}
+
+static inline uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+static inline float uniform(uint32_t x) {
+  return (float)hash32(x) * (1.0f / 4294967296.0f);
+}
+
+static inline float clamp(float value) {
+  float result = (value > 1.0f) ? 1.0f : value;
+  return (result < -1.0f) ? -1.0f : result;
+}
+
+void signal_generator_next(sample_format_t format, size_t len, uint8_t **output, signal_generator *generator) {
+  if (len > generator->max_samples) {
+    len = generator->max_samples;
+  }
+  float *re = generator->re;
+  float *im = generator->im;
+  memset(re, 0, sizeof(float) * len);
+  memset(im, 0, sizeof(float) * len);
+  for (size_t i = 0; i < generator->tones_len; i++) {
+    generate_tone(generator->tones + i, len, re, im);
+  }
+  for (size_t i = 0; i < len; i++) {
+    re[i] *= generator->tone_amplitude;
+    im[i] *= generator->tone_amplitude;
+  }
+  if (generator->burst_period_samples > 0) {
+    for (size_t i = 0; i < len; i++) {
+      if ((generator->position + i) % generator->burst_period_samples >= generator->burst_samples) {
+        re[i] = 0.0f;
+        im[i] = 0.0f;
+      }
+    }
+  }
+  if (generator->noise_scale > 0.0f) {
+    // counter based, so that there is no dependency between samples
+    for (size_t i = 0; i < len; i++) {
+      uint32_t index = 4 * (uint32_t)(generator->position + i);
+      re[i] += (uniform(index) + uniform(index + 1) - 1.0f) * generator->noise_scale;
+      im[i] += (uniform(index + 2) + uniform(index + 3) - 1.0f) * generator->noise_scale;
+    }
+  }
+  switch (format) {
+    case SAMPLE_FORMAT_CS16: {
+      int16_t *result = (int16_t *)generator->output;
+      for (size_t i = 0; i < len; i++) {
+        result[2 * i] = (int16_t)(clamp(re[i]) * INT16_MAX);
+        result[2 * i + 1] = (int16_t)(clamp(im[i]) * INT16_MAX);
+      }
+      break;
+    }
+    case SAMPLE_FORMAT_CS8: {
+      int8_t *result = (int8_t *)generator->output;
+      for (size_t i = 0; i < len; i++) {
+        result[2 * i] = (int8_t)(clamp(re[i]) * INT8_MAX);
+        result[2 * i + 1] = (int8_t)(clamp(im[i]) * INT8_MAX);
+      }
+      break;
+    }
+    default: {
+      uint8_t *result = generator->output;
+      for (size_t i = 0; i < len; i++) {
+        result[2 * i] = (uint8_t)(clamp(re[i]) * 127.5f + 127.5f);
+        result[2 * i + 1] = (uint8_t)(clamp(im[i]) * 127.5f + 127.5f);
+      }
+      break;
+    }
+  }
+  generator->position += len;
+  *output = generator->output;
+}
+
+void signal_generator_destroy(signal_generator *generator) {
+  if (generator == NULL) {
+    return;
+  }
+  if (generator->tones != NULL) {
+    free(generator->tones);
+  }
+  if (generator->re != NULL) {
+    free(generator->re);
+  }
+  if (generator->im != NULL) {
+    free(generator->im);
+  }
+  if (generator->output != NULL) {
+    free(generator->output);
+  }
+  free(generator);
+}
@@ -0,0 +1,22 @@
+#ifndef SIGNAL_GENERATOR_H_
+#define SIGNAL_GENERATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+typedef struct signal_generator_t signal_generator;
+
+// tones - frequency offsets from the band center in Hz
+// tone_amplitude and noise_amplitude (rms) are relative to the full scale
+// burst_ms - tones are present only for burst_ms every burst_period_ms. 0 - always present
+// max_samples - max number of samples generated in one call
+int signal_generator_create(uint32_t sampling_rate, const int32_t *tones, size_t tones_len, float tone_amplitude, float noise_amplitude, uint32_t burst_ms, uint32_t burst_period_ms, size_t max_samples, signal_generator **result);
+
+// generates next len samples in the format. Output is owned by the generator
+void signal_generator_next(sample_format_t format, size_t len, uint8_t **output, signal_generator *generator);
+
+void signal_generator_destroy(signal_generator *generator);
+
+#endif /* SIGNAL_GENERATOR_H_ */
@@ -0,0 +1,21 @@
+#include "socket_util.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+int write_fully(int socket, const void *buffer, size_t total_len) {
+  size_t left = total_len;
+  while (left > 0) {
+    ssize_t written = write(socket, (const char *) buffer + (total_len - left), left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("unable to write the message");
+      return -1;
+    }
+    left -= (size_t) written;
+  }
+  return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef SOCKET_UTIL_H_
+#define SOCKET_UTIL_H_
+
+#include <stddef.h>
+
+// blocks until the whole buffer is written. Retries on EINTR
+int write_fully(int socket, const void *buffer, size_t total_len);
+
+#endif /* SOCKET_UTIL_H_ */
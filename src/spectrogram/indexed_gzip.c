@@ -0,0 +1,370 @@
+#include "indexed_gzip.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "../gzip_index.h"
+
+#define INPUT_BUFFER_SIZE (64 * 1024)
+
+typedef enum {
+  CHUNK_FREE,
+  CHUNK_PENDING,
+  CHUNK_DECODING,
+  CHUNK_DONE
+} chunk_state;
+
+struct chunk_slot {
+  size_t chunk;
+  uint8_t *output;
+  size_t output_len;
+  int code;
+  chunk_state state;
+};
+
+struct decompress_worker {
+  indexed_gzip *gz;
+  z_stream strm;
+  bool strm_initialized;
+  uint8_t *input;
+  pthread_t thread;
+  bool thread_started;
+};
+
+struct indexed_gzip_t {
+  int fd;
+  gzip_index_entry *entries;
+  // the last entry contains total length only
+  size_t number_of_chunks;
+
+  struct chunk_slot *slots;
+  size_t number_of_slots;
+  // the following fields are accessed by the reader thread only
+  size_t read_index;
+  size_t read_pos;
+  size_t submitted;
+  size_t next_chunk;
+  uint64_t position;
+
+  struct decompress_worker *workers;
+  int number_of_workers;
+  // guarded by mutex
+  size_t decompress_index;
+  bool shutdown;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t chunk_pending;
+  pthread_cond_t chunk_done;
+};
+
+static void decompress_chunk(indexed_gzip *gz, struct chunk_slot *slot, struct decompress_worker *worker) {
+  gzip_index_entry *entry = &gz->entries[slot->chunk];
+  size_t expected = (size_t)(gz->entries[slot->chunk + 1].uncompressed - entry->uncompressed);
+  z_stream *strm = &worker->strm;
+  inflateReset(strm);
+  strm->next_out = slot->output;
+  strm->avail_out = (uInt)expected;
+  off_t offset = (off_t)entry->compressed;
+  slot->code = 0;
+  while (strm->avail_out > 0) {
+    if (strm->avail_in == 0) {
+      ssize_t actually_read = pread(gz->fd, worker->input, INPUT_BUFFER_SIZE, offset);
+      if (actually_read <= 0) {
+        slot->code = -1;
+        break;
+      }
+      offset += actually_read;
+      strm->next_in = worker->input;
+      strm->avail_in = (uInt)actually_read;
+    }
+    int code = inflate(strm, Z_NO_FLUSH);
+    if (code == Z_STREAM_END) {
+      break;
+    }
+    if (code != Z_OK) {
+      slot->code = -1;
+      break;
+    }
+  }
+  slot->output_len = expected - strm->avail_out;
+  if (slot->output_len != expected) {
+    slot->code = -1;
+  }
+  // leftovers belong to the next chunk
+  strm->avail_in = 0;
+}
+
+static void *decompress_callback(void *arg) {
+  struct decompress_worker *worker = (struct decompress_worker *)arg;
+  indexed_gzip *gz = worker->gz;
+  pthread_mutex_lock(&gz->mutex);
+  while (true) {
+    struct chunk_slot *slot = &gz->slots[gz->decompress_index];
+    if (slot->state != CHUNK_PENDING) {
+      if (gz->shutdown) {
+        break;
+      }
+      pthread_cond_wait(&gz->chunk_pending, &gz->mutex);
+      continue;
+    }
+    slot->state = CHUNK_DECODING;
+    gz->decompress_index = (gz->decompress_index + 1) % gz->number_of_slots;
+    pthread_mutex_unlock(&gz->mutex);
+
+    decompress_chunk(gz, slot, worker);
+
+    pthread_mutex_lock(&gz->mutex);
+    slot->state = CHUNK_DONE;
+    pthread_cond_broadcast(&gz->chunk_done);
+  }
+  pthread_mutex_unlock(&gz->mutex);
+  return (void *)0;
+}
+
+// keep all slots busy with the next chunks
+static void submit_chunks(indexed_gzip *gz) {
+  if (gz->submitted == gz->number_of_slots || gz->next_chunk == gz->number_of_chunks) {
+    return;
+  }
+  pthread_mutex_lock(&gz->mutex);
+  while (gz->submitted < gz->number_of_slots && gz->next_chunk < gz->number_of_chunks) {
+    struct chunk_slot *slot = &gz->slots[(gz->read_index + gz->submitted) % gz->number_of_slots];
+    slot->chunk = gz->next_chunk;
+    slot->state = CHUNK_PENDING;
+    gz->next_chunk++;
+    gz->submitted++;
+  }
+  pthread_cond_broadcast(&gz->chunk_pending);
+  pthread_mutex_unlock(&gz->mutex);
+}
+
+static struct chunk_slot *wait_for_chunk(indexed_gzip *gz) {
+  struct chunk_slot *slot = &gz->slots[gz->read_index];
+  pthread_mutex_lock(&gz->mutex);
+  while (slot->state != CHUNK_DONE) {
+    pthread_cond_wait(&gz->chunk_done, &gz->mutex);
+  }
+  pthread_mutex_unlock(&gz->mutex);
+  return slot;
+}
+
+static void release_chunk(indexed_gzip *gz) {
+  gz->slots[gz->read_index].state = CHUNK_FREE;
+  gz->read_index = (gz->read_index + 1) % gz->number_of_slots;
+  gz->submitted--;
+  gz->read_pos = 0;
+}
+
+int indexed_gzip_create(const char *filename, int threads, indexed_gzip **gz) {
+  if (threads <= 0) {
+    return -1;
+  }
+  struct indexed_gzip_t *result = malloc(sizeof(struct indexed_gzip_t));
+  if (result == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *result = (struct indexed_gzip_t){0};
+  result->fd = -1;
+  result->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+  result->chunk_pending = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+  result->chunk_done = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+
+  size_t entries_len = 0;
+  int code = gzip_index_load(filename, &result->entries, &entries_len);
+  if (code != 0) {
+    indexed_gzip_destroy(result);
+    return code;
+  }
+  result->number_of_chunks = entries_len - 1;
+  size_t max_chunk_len = 0;
+  for (size_t i = 0; i < result->number_of_chunks; i++) {
+    size_t cur = (size_t)(result->entries[i + 1].uncompressed - result->entries[i].uncompressed);
+    if (cur > max_chunk_len) {
+      max_chunk_len = cur;
+    }
+  }
+
+  result->fd = open(filename, O_RDONLY);
+  if (result->fd < 0) {
+    fprintf(stderr, "unable to read input file %s: %s\n", filename, strerror(errno));
+    indexed_gzip_destroy(result);
+    return -1;
+  }
+
+  // two chunks per thread: one is decoding, another is waiting to be read
+  result->number_of_slots = (size_t)threads * 2;
+  result->slots = malloc(sizeof(struct chunk_slot) * result->number_of_slots);
+  if (result->slots == NULL) {
+    indexed_gzip_destroy(result);
+    return -ENOMEM;
+  }
+  for (size_t i = 0; i < result->number_of_slots; i++) {
+    result->slots[i] = (struct chunk_slot){0};
+  }
+  for (size_t i = 0; i < result->number_of_slots; i++) {
+    // zero-length chunk is still valid
+    result->slots[i].output = malloc(sizeof(uint8_t) * (max_chunk_len + 1));
+    if (result->slots[i].output == NULL) {
+      indexed_gzip_destroy(result);
+      return -ENOMEM;
+    }
+  }
+  result->workers = malloc(sizeof(struct decompress_worker) * threads);
+  if (result->workers == NULL) {
+    indexed_gzip_destroy(result);
+    return -ENOMEM;
+  }
+  result->number_of_workers = threads;
+  for (int i = 0; i < threads; i++) {
+    result->workers[i] = (struct decompress_worker){0};
+    result->workers[i].gz = result;
+  }
+  for (int i = 0; i < threads; i++) {
+    result->workers[i].input = malloc(sizeof(uint8_t) * INPUT_BUFFER_SIZE);
+    if (result->workers[i].input == NULL) {
+      indexed_gzip_destroy(result);
+      return -ENOMEM;
+    }
+    // raw inflate. seek points don't have gzip header
+    if (inflateInit2(&result->workers[i].strm, -15) != Z_OK) {
+      indexed_gzip_destroy(result);
+      return -1;
+    }
+    result->workers[i].strm_initialized = true;
+  }
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&result->workers[i].thread, NULL, &decompress_callback, &result->workers[i]) != 0) {
+      indexed_gzip_destroy(result);
+      return -1;
+    }
+    result->workers[i].thread_started = true;
+  }
+  submit_chunks(result);
+  *gz = result;
+  return 0;
+}
+
+uint64_t indexed_gzip_get_length(indexed_gzip *gz) {
+  return gz->entries[gz->number_of_chunks].uncompressed;
+}
+
+int indexed_gzip_read(void *output, size_t len, indexed_gzip *gz) {
+  uint8_t *result = (uint8_t *)output;
+  while (len > 0) {
+    if (gz->submitted == 0) {
+      // end of file
+      return -1;
+    }
+    struct chunk_slot *slot = wait_for_chunk(gz);
+    if (slot->code != 0) {
+      return -1;
+    }
+    size_t to_copy = slot->output_len - gz->read_pos;
+    if (to_copy > len) {
+      to_copy = len;
+    }
+    memcpy(result, slot->output + gz->read_pos, to_copy);
+    result += to_copy;
+    len -= to_copy;
+    gz->read_pos += to_copy;
+    gz->position += to_copy;
+    if (gz->read_pos == slot->output_len) {
+      release_chunk(gz);
+      submit_chunks(gz);
+    }
+  }
+  return 0;
+}
+
+static size_t find_chunk(uint64_t offset, indexed_gzip *gz) {
+  size_t low = 0;
+  size_t high = gz->number_of_chunks;
+  // last chunk which starts before or at the offset
+  while (high - low > 1) {
+    size_t mid = low + (high - low) / 2;
+    if (gz->entries[mid].uncompressed <= offset) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int indexed_gzip_seek(uint64_t offset, indexed_gzip *gz) {
+  // the same as fseek: next read will fail
+  if (offset > indexed_gzip_get_length(gz)) {
+    offset = indexed_gzip_get_length(gz);
+  }
+  size_t chunk = find_chunk(offset, gz);
+  size_t first_submitted = gz->next_chunk - gz->submitted;
+  if (gz->submitted > 0 && chunk >= first_submitted && chunk < gz->next_chunk) {
+    // already decoding. just skip chunks in between
+    while (gz->slots[gz->read_index].chunk != chunk) {
+      wait_for_chunk(gz);
+      release_chunk(gz);
+    }
+  } else {
+    // chunks cannot be cancelled, wait until they are decoded
+    while (gz->submitted > 0) {
+      wait_for_chunk(gz);
+      release_chunk(gz);
+    }
+    gz->next_chunk = chunk;
+  }
+  submit_chunks(gz);
+  gz->read_pos = (size_t)(offset - gz->entries[chunk].uncompressed);
+  gz->position = offset;
+  return 0;
+}
+
+uint64_t indexed_gzip_tell(indexed_gzip *gz) {
+  return gz->position;
+}
+
+void indexed_gzip_destroy(indexed_gzip *gz) {
+  if (gz == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&gz->mutex);
+  gz->shutdown = true;
+  pthread_cond_broadcast(&gz->chunk_pending);
+  pthread_mutex_unlock(&gz->mutex);
+  if (gz->workers != NULL) {
+    for (int i = 0; i < gz->number_of_workers; i++) {
+      if (gz->workers[i].thread_started) {
+        pthread_join(gz->workers[i].thread, NULL);
+      }
+      if (gz->workers[i].strm_initialized) {
+        inflateEnd(&gz->workers[i].strm);
+      }
+      if (gz->workers[i].input != NULL) {
+        free(gz->workers[i].input);
+      }
+    }
+    free(gz->workers);
+  }
+  if (gz->slots != NULL) {
+    for (size_t i = 0; i < gz->number_of_slots; i++) {
+      if (gz->slots[i].output != NULL) {
+        free(gz->slots[i].output);
+      }
+    }
+    free(gz->slots);
+  }
+  if (gz->fd >= 0) {
+    close(gz->fd);
+  }
+  if (gz->entries != NULL) {
+    free(gz->entries);
+  }
+  free(gz);
+}
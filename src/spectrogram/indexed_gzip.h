@@ -0,0 +1,23 @@
+#ifndef INDEXED_GZIP_H_
+#define INDEXED_GZIP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct indexed_gzip_t indexed_gzip;
+
+// returns non-zero if file doesn't have complete index
+// chunks between seek points are inflated in parallel
+int indexed_gzip_create(const char *filename, int threads, indexed_gzip **gz);
+
+uint64_t indexed_gzip_get_length(indexed_gzip *gz);
+
+int indexed_gzip_read(void *output, size_t len, indexed_gzip *gz);
+
+int indexed_gzip_seek(uint64_t offset, indexed_gzip *gz);
+
+uint64_t indexed_gzip_tell(indexed_gzip *gz);
+
+void indexed_gzip_destroy(indexed_gzip *gz);
+
+#endif /* INDEXED_GZIP_H_ */
@@ -2,6 +2,165 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+
+static int ends_with(const char *str, const char *suffix) {
+  size_t str_len = strlen(str);
+  size_t suffix_len = strlen(suffix);
+  return str_len >= suffix_len && strcmp(str + str_len - suffix_len, suffix) == 0;
+}
+
+static int iq_file_open_compressed(const char *filename, iq_file *result) {
+  result->compressed_fp = fopen(filename, "rb");
+  if (result->compressed_fp == NULL) {
+    fprintf(stderr, "unable to read input file %s: %s\n", filename, strerror(errno));
+    return -1;
+  }
+  uint8_t header[SAMPLE_FILTER_HEADER_SIZE];
+  if (fread(header, 1, sizeof(header), result->compressed_fp) != sizeof(header) || sample_filter_parse_header(header, sizeof(header), &result->filter_header) != 0) {
+    fprintf(stderr, "unsupported file header %s\n", filename);
+    return -1;
+  }
+  uint8_t trailer[SAMPLE_FILTER_TRAILER_SIZE];
+  if (fseek(result->compressed_fp, -SAMPLE_FILTER_TRAILER_SIZE, SEEK_END) != 0) {
+    return -1;
+  }
+  long file_size = ftell(result->compressed_fp) + SAMPLE_FILTER_TRAILER_SIZE;
+  // the trailer is written on close. incomplete files are not supported
+  if (fread(trailer, 1, sizeof(trailer), result->compressed_fp) != sizeof(trailer) || sample_filter_parse_trailer(trailer, sizeof(trailer), &result->compressed_number_of_bytes) != 0 || file_size < SAMPLE_FILTER_HEADER_SIZE + SAMPLE_FILTER_TRAILER_SIZE) {
+    fprintf(stderr, "premature end of file %s\n", filename);
+    return -1;
+  }
+  if (fseek(result->compressed_fp, SAMPLE_FILTER_HEADER_SIZE, SEEK_SET) != 0) {
+    return -1;
+  }
+  result->compressed_remaining = (uint64_t) (file_size - SAMPLE_FILTER_HEADER_SIZE - SAMPLE_FILTER_TRAILER_SIZE);
+
+  if (ends_with(filename, ".zst")) {
+    result->zstd = ZSTD_createDStream();
+    if (result->zstd == NULL) {
+      return -ENOMEM;
+    }
+    result->compressed_capacity = ZSTD_DStreamInSize();
+  } else {
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&result->lz4, LZ4F_VERSION))) {
+      return -1;
+    }
+    result->compressed_capacity = 128 * 1024;
+  }
+  result->compressed = malloc(sizeof(uint8_t) * result->compressed_capacity);
+  result->filtered = malloc(sizeof(uint8_t) * result->filter_header.block_size);
+  result->block = malloc(sizeof(uint8_t) * result->filter_header.block_size);
+  if (result->compressed == NULL || result->filtered == NULL || result->block == NULL) {
+    return -ENOMEM;
+  }
+  return 0;
+}
+
+// decompress and unfilter the next block
+static int read_compressed_block(iq_file *file) {
+  uint64_t left = file->compressed_number_of_bytes - file->decompressed_total;
+  if (left == 0) {
+    return -1;
+  }
+  size_t expected = file->filter_header.block_size;
+  if (expected > left) {
+    expected = (size_t) left;
+  }
+  size_t filtered_len = 0;
+  while (filtered_len < expected) {
+    if (file->compressed_pos == file->compressed_len) {
+      if (file->compressed_remaining == 0) {
+        return -1;
+      }
+      size_t to_read = file->compressed_capacity;
+      if (to_read > file->compressed_remaining) {
+        to_read = (size_t) file->compressed_remaining;
+      }
+      file->compressed_len = fread(file->compressed, 1, to_read, file->compressed_fp);
+      file->compressed_pos = 0;
+      if (file->compressed_len == 0) {
+        return -1;
+      }
+      file->compressed_remaining -= file->compressed_len;
+    }
+    if (file->zstd != NULL) {
+      ZSTD_inBuffer in = {file->compressed, file->compressed_len, file->compressed_pos};
+      ZSTD_outBuffer out = {file->filtered, expected, filtered_len};
+      size_t code = ZSTD_decompressStream(file->zstd, &out, &in);
+      if (ZSTD_isError(code)) {
+        fprintf(stderr, "unable to decompress: %s\n", ZSTD_getErrorName(code));
+        return -1;
+      }
+      file->compressed_pos = in.pos;
+      filtered_len = out.pos;
+    } else {
+      size_t dst_size = expected - filtered_len;
+      size_t src_size = file->compressed_len - file->compressed_pos;
+      size_t code = LZ4F_decompress(file->lz4, file->filtered + filtered_len, &dst_size, file->compressed + file->compressed_pos, &src_size, NULL);
+      if (LZ4F_isError(code)) {
+        fprintf(stderr, "unable to decompress: %s\n", LZ4F_getErrorName(code));
+        return -1;
+      }
+      file->compressed_pos += src_size;
+      filtered_len += dst_size;
+    }
+  }
+  sample_filter_decode(file->filtered, filtered_len, &file->filter_header, file->block);
+  file->block_len = filtered_len;
+  file->block_pos = 0;
+  file->decompressed_total += filtered_len;
+  return 0;
+}
+
+static int read_compressed(uint8_t *output, size_t len, iq_file *file) {
+  while (len > 0) {
+    if (file->block_pos == file->block_len && read_compressed_block(file) != 0) {
+      return -1;
+    }
+    size_t to_copy = file->block_len - file->block_pos;
+    if (to_copy > len) {
+      to_copy = len;
+    }
+    if (output != NULL) {
+      memcpy(output, file->block + file->block_pos, to_copy);
+      output += to_copy;
+    }
+    file->block_pos += to_copy;
+    len -= to_copy;
+  }
+  return 0;
+}
+
+static int iq_file_get_threads() {
+  long result = sysconf(_SC_NPROCESSORS_ONLN);
+  if (result <= 0) {
+    return 1;
+  }
+  return (int) result;
+}
+
+static int read_bytes(void *output, size_t len, iq_file *file) {
+  if (file->fp != NULL) {
+    if (fread(output, 1, len, file->fp) != len) {
+      return -1;
+    }
+    return 0;
+  }
+  if (file->gz != NULL) {
+    if (gzread(file->gz, output, (unsigned int) len) != (int) len) {
+      return -1;
+    }
+    return 0;
+  }
+  if (file->indexed_gz != NULL) {
+    return indexed_gzip_read(output, len, file->indexed_gz);
+  }
+  if (file->compressed_fp != NULL) {
+    return read_compressed(output, len, file);
+  }
+  return -1;
+}
 
 int iq_file_create(const char *filename, uint32_t samples, const char *data_format, iq_file **file) {
   iq_file *result = malloc(sizeof(iq_file));
@@ -32,7 +191,15 @@ int iq_file_create(const char *filename, uint32_t samples, const char *data_form
     return -1;
   }
 
-  if (strstr(filename, ".gz") != NULL) {
+  if (ends_with(filename, ".zst") || ends_with(filename, ".lz4")) {
+    int code = iq_file_open_compressed(filename, result);
+    if (code != 0) {
+      iq_file_destroy(result);
+      return code;
+    }
+  } else if (strstr(filename, ".gz") != NULL && indexed_gzip_create(filename, iq_file_get_threads(), &result->indexed_gz) == 0) {
+    result->gz_file_number_of_bytes = indexed_gzip_get_length(result->indexed_gz);
+  } else if (strstr(filename, ".gz") != NULL) {
     FILE *fp = fopen(filename, "rb");
     if (fp == NULL) {
       fprintf(stderr, "unable to read input file %s: %s\n", filename, strerror(errno));
@@ -103,39 +270,21 @@ void iq_file_skip(uint32_t samples_to_skip, iq_file *file) {
   if (file->gz != NULL) {
     gzseek(file->gz, bytes_to_skip, SEEK_CUR);
   }
+  if (file->indexed_gz != NULL) {
+    indexed_gzip_seek(indexed_gzip_tell(file->indexed_gz) + bytes_to_skip, file->indexed_gz);
+  }
+  if (file->compressed_fp != NULL) {
+    // blocks depend on each other, so decode everything in between
+    read_compressed(NULL, (size_t) bytes_to_skip, file);
+  }
 }
 
 int iq_file_read(fftwf_complex *in, iq_file *file) {
   if (file->data_format == CF32_FORMAT) {
-    if (file->fp != NULL) {
-      size_t actually_read = fread(in, sizeof(fftwf_complex), file->width, file->fp);
-      if (actually_read != file->width) {
-        return -1;
-      }
-    } else if (file->gz != NULL) {
-      int expected = (int) (sizeof(fftwf_complex) * file->width);
-      int actually_read = gzread(file->gz, in, expected);
-      if (actually_read != expected) {
-        return -1;
-      }
-    } else {
-      return -1;
-    }
-    return 0;
+    return read_bytes(in, sizeof(fftwf_complex) * file->width, file);
   }
   if (file->data_format == CU8_FORMAT) {
-    if (file->fp != NULL) {
-      size_t actually_read = fread(file->temp, 2 * sizeof(uint8_t), file->width, file->fp);
-      if (actually_read != file->width) {
-        return -1;
-      }
-    } else if (file->gz != NULL) {
-      int expected = (int) (2 * sizeof(uint8_t) * file->width);
-      int actually_read = gzread(file->gz, file->temp, expected);
-      if (actually_read != expected) {
-        return -1;
-      }
-    } else {
+    if (read_bytes(file->temp, 2 * sizeof(uint8_t) * file->width, file) != 0) {
       return -1;
     }
     for (size_t i = 0; i < file->width; i++) {
@@ -146,18 +295,7 @@ int iq_file_read(fftwf_complex *in, iq_file *file) {
     return 0;
   }
   if (file->data_format == CS16_FORMAT) {
-    if (file->fp != NULL) {
-      size_t actually_read = fread(file->temp, 2 * sizeof(int16_t), file->width, file->fp);
-      if (actually_read != file->width) {
-        return -1;
-      }
-    } else if (file->gz != NULL) {
-      int expected = (int) (2 * sizeof(int16_t) * file->width);
-      int actually_read = gzread(file->gz, file->temp, expected);
-      if (actually_read != expected) {
-        return -1;
-      }
-    } else {
+    if (read_bytes(file->temp, 2 * sizeof(int16_t) * file->width, file) != 0) {
       return -1;
     }
     for (size_t i = 0; i < file->width; i++) {
@@ -192,8 +330,11 @@ void iq_file_get_samples(uint32_t *samples, iq_file *file) {
     *samples = number_of_bytes / sample_size;
     rewind(file->fp);
   }
-  if (file->gz != NULL) {
-    *samples = file->gz_file_number_of_bytes / sample_size;
+  if (file->gz != NULL || file->indexed_gz != NULL) {
+    *samples = (uint32_t) (file->gz_file_number_of_bytes / sample_size);
+  }
+  if (file->compressed_fp != NULL) {
+    *samples = (uint32_t) (file->compressed_number_of_bytes / sample_size);
   }
 }
 
@@ -211,6 +352,27 @@ void iq_file_destroy(iq_file *file) {
   if (file->gz != NULL) {
     gzclose(file->gz);
   }
+  if (file->indexed_gz != NULL) {
+    indexed_gzip_destroy(file->indexed_gz);
+  }
+  if (file->compressed_fp != NULL) {
+    fclose(file->compressed_fp);
+  }
+  if (file->zstd != NULL) {
+    ZSTD_freeDStream(file->zstd);
+  }
+  if (file->lz4 != NULL) {
+    LZ4F_freeDecompressionContext(file->lz4);
+  }
+  if (file->compressed != NULL) {
+    free(file->compressed);
+  }
+  if (file->filtered != NULL) {
+    free(file->filtered);
+  }
+  if (file->block != NULL) {
+    free(file->block);
+  }
 
   free(file);
 }
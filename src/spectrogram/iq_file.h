@@ -2,22 +2,45 @@
 #define IQ_FILE_H_
 
 #include <zlib.h>
+#include <zstd.h>
+#include <lz4frame.h>
 #include <stdio.h>
 #include <complex.h> // must be defined before fftw3
 #include <fftw3.h>
 #include <stdint.h>
 
+#include "../sample_filter.h"
+#include "indexed_gzip.h"
+
 #define CU8_FORMAT 0
 #define CS16_FORMAT 1
 #define CF32_FORMAT 2
 
 typedef struct {
   gzFile gz;
+  indexed_gzip *indexed_gz;
   FILE *fp;
   int data_format;
-  long gz_file_number_of_bytes;
+  uint64_t gz_file_number_of_bytes;
   uint8_t *temp;
   uint32_t width;
+
+  // zstd and lz4 files produced by sdr-server
+  ZSTD_DStream *zstd;
+  LZ4F_dctx *lz4;
+  FILE *compressed_fp;
+  sample_filter_header filter_header;
+  uint64_t compressed_remaining;
+  uint64_t compressed_number_of_bytes;
+  uint64_t decompressed_total;
+  uint8_t *compressed;
+  size_t compressed_capacity;
+  size_t compressed_len;
+  size_t compressed_pos;
+  uint8_t *filtered;
+  uint8_t *block;
+  size_t block_len;
+  size_t block_pos;
 } iq_file;
 
 int iq_file_create(const char *filename, uint32_t samples, const char *data_format, iq_file **result);
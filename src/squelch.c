@@ -0,0 +1,151 @@
+#include "squelch.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// how fast noise floor follows the power when squelch is closed
+#define NOISE_FLOOR_ALPHA 0.05f
+
+struct squelch_t {
+  size_t window;
+  float threshold;
+  uint32_t hang_windows;
+
+  bool floor_initialized;
+  float noise_floor;
+  bool open;
+  uint32_t hang_left;
+
+  // the most recent samples while squelch is closed
+  float complex *preroll;
+  size_t preroll_len;
+  size_t preroll_capacity;
+
+  // number of samples processed before the current input
+  uint64_t offset;
+};
+
+int squelch_create(uint32_t sample_rate, uint8_t threshold_db, uint32_t hang_ms, uint32_t preroll_ms, squelch **result) {
+  if (sample_rate == 0) {
+    return -1;
+  }
+  struct squelch_t *sq = malloc(sizeof(struct squelch_t));
+  if (sq == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *sq = (struct squelch_t){0};
+  sq->window = (size_t)sample_rate * SQUELCH_WINDOW_MS / 1000;
+  if (sq->window == 0) {
+    sq->window = 1;
+  }
+  sq->threshold = powf(10.0f, threshold_db / 10.0f);
+  sq->hang_windows = (hang_ms + SQUELCH_WINDOW_MS - 1) / SQUELCH_WINDOW_MS;
+  sq->preroll_capacity = (size_t)((uint64_t)sample_rate * preroll_ms / 1000);
+  if (sq->preroll_capacity > 0) {
+    sq->preroll = malloc(sizeof(float complex) * sq->preroll_capacity);
+    if (sq->preroll == NULL) {
+      squelch_destroy(sq);
+      return -ENOMEM;
+    }
+  }
+  *result = sq;
+  return 0;
+}
+
+static void squelch_update_noise_floor(float power, squelch *squelch) {
+  if (!squelch->floor_initialized || power < squelch->noise_floor) {
+    squelch->noise_floor = power;
+    squelch->floor_initialized = true;
+    return;
+  }
+  squelch->noise_floor += NOISE_FLOOR_ALPHA * (power - squelch->noise_floor);
+}
+
+static void squelch_append_preroll(const float complex *input, size_t len, squelch *squelch) {
+  size_t capacity = squelch->preroll_capacity;
+  if (capacity == 0) {
+    return;
+  }
+  if (len >= capacity) {
+    memcpy(squelch->preroll, input + len - capacity, sizeof(float complex) * capacity);
+    squelch->preroll_len = capacity;
+    return;
+  }
+  if (squelch->preroll_len + len > capacity) {
+    size_t to_remove = squelch->preroll_len + len - capacity;
+    memmove(squelch->preroll, squelch->preroll + to_remove, sizeof(float complex) * (squelch->preroll_len - to_remove));
+    squelch->preroll_len -= to_remove;
+  }
+  memcpy(squelch->preroll + squelch->preroll_len, input, sizeof(float complex) * len);
+  squelch->preroll_len += len;
+}
+
+int squelch_process(const float complex *input, size_t input_len, squelch_callback callback, void *ctx, squelch *squelch) {
+  // start of the active part in the current input
+  size_t segment_start = 0;
+  for (size_t i = 0; i < input_len; i += squelch->window) {
+    size_t len = squelch->window;
+    if (i + len > input_len) {
+      len = input_len - i;
+    }
+    float power = 0.0f;
+    for (size_t j = i; j < i + len; j++) {
+      float re = crealf(input[j]);
+      float im = cimagf(input[j]);
+      power += re * re + im * im;
+    }
+    power /= (float)len;
+    bool active = squelch->floor_initialized && power > squelch->noise_floor * squelch->threshold;
+    if (squelch->open) {
+      if (active) {
+        squelch->hang_left = squelch->hang_windows;
+        continue;
+      }
+      if (squelch->hang_left > 0) {
+        squelch->hang_left--;
+        continue;
+      }
+      squelch->open = false;
+      if (i > segment_start) {
+        int code = callback(input + segment_start, i - segment_start, squelch->offset + segment_start, ctx);
+        if (code != 0) {
+          return code;
+        }
+      }
+    } else if (active) {
+      squelch->open = true;
+      squelch->hang_left = squelch->hang_windows;
+      segment_start = i;
+      if (squelch->preroll_len > 0) {
+        int code = callback(squelch->preroll, squelch->preroll_len, squelch->offset + i - squelch->preroll_len, ctx);
+        squelch->preroll_len = 0;
+        if (code != 0) {
+          return code;
+        }
+      }
+      continue;
+    }
+    squelch_update_noise_floor(power, squelch);
+    squelch_append_preroll(input + i, len, squelch);
+  }
+  int code = 0;
+  if (squelch->open && input_len > segment_start) {
+    code = callback(input + segment_start, input_len - segment_start, squelch->offset + segment_start, ctx);
+  }
+  squelch->offset += input_len;
+  return code;
+}
+
+void squelch_destroy(squelch *squelch) {
+  if (squelch == NULL) {
+    return;
+  }
+  if (squelch->preroll != NULL) {
+    free(squelch->preroll);
+  }
+  free(squelch);
+}
@@ -0,0 +1,28 @@
+#ifndef SQUELCH_H_
+#define SQUELCH_H_
+
+#include <complex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct squelch_t squelch;
+
+// signal power is measured in windows of this duration
+#define SQUELCH_WINDOW_MS 10
+// preroll is kept in memory for every client
+#define SQUELCH_MAX_PREROLL_MS 60000
+
+// sample_offset - index of the first sample of the output in the input stream
+typedef int (*squelch_callback)(const float complex *output, size_t output_len, uint64_t sample_offset, void *ctx);
+
+// threshold_db - signal is present when window power is above the noise floor by threshold_db
+// hang_ms - keep squelch open for this time after the signal is gone
+// preroll_ms - emit this time before the signal was detected
+int squelch_create(uint32_t sample_rate, uint8_t threshold_db, uint32_t hang_ms, uint32_t preroll_ms, squelch **result);
+
+// callback is called for each part of the input with the signal present
+int squelch_process(const float complex *input, size_t input_len, squelch_callback callback, void *ctx, squelch *squelch);
+
+void squelch_destroy(squelch *squelch);
+
+#endif /* SQUELCH_H_ */
@@ -2,6 +2,7 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <netinet/in.h>
 #include <pthread.h>
 #include <signal.h>
@@ -13,8 +14,15 @@
 #include <unistd.h>
 
 #include "api.h"
+#include "dsp_cost.h"
 #include "dsp_worker.h"
+#include "kernel_tuner.h"
+#include "metrics.h"
+#include "sample_memory.h"
 #include "sdr_device.h"
+#include "socket_util.h"
+#include "thread_scheduling.h"
+#include "time_shift.h"
 
 struct linked_list_tcp_node {
   struct linked_list_tcp_node *next;
@@ -29,6 +37,7 @@ struct tcp_server_t {
   volatile sig_atomic_t is_running;
   pthread_t acceptor_thread;
   sdr_device *device;
+  time_shift *time_shift;
   struct server_config *server_config;
   uint32_t client_counter;
   uint32_t current_band_freq;
@@ -41,6 +50,14 @@ struct tcp_server_t {
   pthread_cond_t sdr_stopped_condition;
   bool sdr_stopped;
   bool shutdown_thread_created;
+
+  server_metrics metrics;
+  // NULL if metrics_port is 0
+  metrics_server *metrics_server;
+  // calibrated at start if cpu_budget_percent is set
+  dsp_cost_model cost_model;
+  // NULL if cpu_optimization is not AUTO_CF32
+  kernel_tuner *kernel_tuner;
 };
 
 static void log_client(struct sockaddr_in *address, uint32_t id) {
@@ -80,7 +97,7 @@ static int read_struct(int socket, void *result, size_t len) {
   return 0;
 }
 
-static int read_client_config(int client_socket, uint32_t client_id, struct server_config *server_config, client_config **config) {
+static int read_client_config(int client_socket, uint8_t type, uint32_t client_id, struct server_config *server_config, client_config **config) {
   client_config *result = malloc(sizeof(client_config));
   if (result == NULL) {
     return -ENOMEM;
@@ -98,6 +115,27 @@ static int read_client_config(int client_socket, uint32_t client_id, struct serv
   result->band_freq = ntohl(req.band_freq);
   result->client_socket = client_socket;
   result->destination = req.destination;
+  if (type == TYPE_REQUEST_TIME_SHIFT) {
+    struct time_shift_request time_shift_req;
+    if (read_struct(client_socket, &time_shift_req, sizeof(struct time_shift_request)) < 0) {
+      fprintf(stderr, "<3>[%d] unable to read time shift request fully\n", client_id);
+      free(result);
+      return -1;
+    }
+    result->time_shift_millis = ntohl(time_shift_req.milliseconds);
+  }
+  if (type == TYPE_REQUEST_SQUELCH) {
+    struct squelch_request squelch_req;
+    if (read_struct(client_socket, &squelch_req, sizeof(struct squelch_request)) < 0) {
+      fprintf(stderr, "<3>[%d] unable to read squelch request fully\n", client_id);
+      free(result);
+      return -1;
+    }
+    result->squelch = true;
+    result->squelch_threshold_db = squelch_req.threshold_db;
+    result->squelch_hang_ms = ntohl(squelch_req.hang_ms);
+    result->squelch_preroll_ms = ntohl(squelch_req.preroll_ms);
+  }
   if (result->sampling_rate > 0 && server_config->band_sampling_rate % result->sampling_rate != 0) {
     fprintf(stderr, "<3>[%d] sampling frequency is not an integer factor of server sample rate: %u\n", client_id, server_config->band_sampling_rate);
     free(result);
@@ -121,10 +159,27 @@ static int validate_client_config(client_config *config, struct server_config *s
     fprintf(stderr, "<3>[%d] missing band_freq parameter\n", client_id);
     return -1;
   }
-  if (config->destination != REQUEST_DESTINATION_FILE && config->destination != REQUEST_DESTINATION_SOCKET) {
+  if (config->destination != REQUEST_DESTINATION_FILE && config->destination != REQUEST_DESTINATION_SOCKET && config->destination != REQUEST_DESTINATION_FILE_RAW && config->destination != REQUEST_DESTINATION_SOCKET_RAW) {
     fprintf(stderr, "<3>[%d] unknown destination: %d\n", client_id, config->destination);
     return -1;
   }
+  // raw samples are not shifted nor decimated
+  if ((config->destination == REQUEST_DESTINATION_FILE_RAW || config->destination == REQUEST_DESTINATION_SOCKET_RAW) && (config->sampling_rate != server_config->band_sampling_rate || config->center_freq != config->band_freq)) {
+    fprintf(stderr, "<3>[%d] raw destination requires the band sampling rate %u and center_freq equal to band_freq\n", client_id, server_config->band_sampling_rate);
+    return -1;
+  }
+  if (config->squelch && (config->destination == REQUEST_DESTINATION_FILE_RAW || config->destination == REQUEST_DESTINATION_SOCKET_RAW)) {
+    fprintf(stderr, "<3>[%d] squelch is not supported for raw destinations\n", client_id);
+    return -1;
+  }
+  if (config->squelch && config->squelch_preroll_ms > SQUELCH_MAX_PREROLL_MS) {
+    fprintf(stderr, "<3>[%d] squelch preroll is too long: %u ms\n", client_id, config->squelch_preroll_ms);
+    return -1;
+  }
+  if (config->time_shift_millis > (uint64_t) server_config->time_shift_seconds * 1000) {
+    fprintf(stderr, "<3>[%d] time shift is longer than configured time_shift_seconds: %u ms\n", client_id, config->time_shift_millis);
+    return -1;
+  }
   uint32_t requested_min_freq = config->center_freq - config->sampling_rate / 2;
   uint32_t server_min_freq = config->band_freq - server_config->band_sampling_rate / 2;
   if (requested_min_freq < server_min_freq) {
@@ -156,18 +211,88 @@ static int write_message(int socket, uint8_t status, uint32_t details) {
   memcpy(buffer, &header, sizeof(struct message_header));
   memcpy(buffer + sizeof(struct message_header), &resp, sizeof(struct response));
 
-  size_t left = total_len;
-  while (left > 0) {
-    ssize_t written = write(socket, buffer + (total_len - left), left);
-    if (written < 0) {
-      perror("unable to write the message");
-      free(buffer);
-      return -1;
+  int code = write_fully(socket, buffer, total_len);
+  free(buffer);
+  return code;
+}
+
+// the same bytes as big-endian uint64 on the wire
+static uint64_t to_uint64_be(uint64_t value) {
+  uint8_t output[sizeof(uint64_t)];
+  for (size_t i = 0; i < sizeof(uint64_t); i++) {
+    output[i] = (uint8_t) (value >> (56 - 8 * i));
+  }
+  uint64_t result;
+  memcpy(&result, output, sizeof(uint64_t));
+  return result;
+}
+
+static int write_stats(int socket, tcp_server *server) {
+  sdr_device_stats device_stats;
+  sdr_device_get_stats(server->device, &device_stats);
+  struct stats_device device;
+  device.buffers = to_uint64_be(device_stats.buffers);
+  device.samples = to_uint64_be(device_stats.samples);
+  device.dropped_samples = to_uint64_be(device_stats.dropped_samples);
+  device.lost_samples = to_uint64_be(device_stats.lost_samples);
+  device.gaps = to_uint64_be(device_stats.gaps);
+  device.observed_sampling_rate = htonl(device_stats.observed_sampling_rate);
+  device.thread_cpus = to_uint64_be(device_stats.thread_cpus);
+  device.thread_priority = (uint8_t) device_stats.thread_priority;
+
+  size_t sample_size = sdr_device_get_sample_size(sdr_device_get_sample_format(server->server_config));
+  pthread_mutex_lock(&server->mutex);
+  uint32_t number_of_clients = 0;
+  struct linked_list_tcp_node *cur_node = server->tcp_nodes;
+  while (cur_node != NULL) {
+    if (cur_node->config->is_running) {
+      number_of_clients++;
     }
-    left -= written;
+    cur_node = cur_node->next;
   }
-  free(buffer);
-  return 0;
+  struct stats_client *clients = malloc(sizeof(struct stats_client) * number_of_clients);
+  if (clients == NULL && number_of_clients > 0) {
+    pthread_mutex_unlock(&server->mutex);
+    return -ENOMEM;
+  }
+  uint32_t index = 0;
+  cur_node = server->tcp_nodes;
+  while (cur_node != NULL) {
+    // dsp_worker is destroyed under the mutex once the client is not running
+    if (cur_node->config->is_running) {
+      dsp_worker_stats stats;
+      dsp_worker_get_stats(cur_node->dsp_worker, &stats);
+      struct stats_client *client = clients + index;
+      client->id = htonl(cur_node->config->id);
+      client->center_freq = htonl(cur_node->config->center_freq);
+      client->sampling_rate = htonl(cur_node->config->sampling_rate);
+      client->band_freq = htonl(cur_node->config->band_freq);
+      client->destination = cur_node->config->destination;
+      client->kernel = stats.kernel;
+      client->queue_depth = htonl(stats.queue_depth);
+      client->input_samples = to_uint64_be(stats.input_bytes / sample_size);
+      client->output_bytes = to_uint64_be(stats.output_bytes);
+      client->queue_overflows = to_uint64_be(stats.queue_overflows);
+      client->cpu_micros = to_uint64_be(stats.cpu_nanos / 1000);
+      client->latency_p99_micros = to_uint64_be(stats.latency_p99_micros);
+      client->thread_cpus = to_uint64_be(stats.thread_cpus);
+      client->queue_size = htonl(cur_node->config->queue_size);
+      client->memory_bytes = to_uint64_be(stats.memory_bytes);
+      index++;
+    }
+    cur_node = cur_node->next;
+  }
+  pthread_mutex_unlock(&server->mutex);
+
+  int code = write_message(socket, RESPONSE_STATUS_SUCCESS, number_of_clients);
+  if (code == 0) {
+    code = write_fully(socket, &device, sizeof(struct stats_device));
+  }
+  if (code == 0) {
+    code = write_fully(socket, clients, sizeof(struct stats_client) * number_of_clients);
+  }
+  free(clients);
+  return code;
 }
 
 static void respond_failure(int client_socket, uint8_t status, uint32_t details) {
@@ -204,6 +329,7 @@ static void *shutdown_callback(void *arg) {
 static void *tcp_worker(void *arg) {
   struct linked_list_tcp_node *node = (struct linked_list_tcp_node *)arg;
   uint32_t node_id = node->config->id;
+  thread_scheduling_apply("tcp", node->server->server_config->io_cpus, 0);
   fprintf(stdout, "[%d] tcp_worker started. center_freq %d sampling_rate %d destination %d\n", node_id, node->config->center_freq, node->config->sampling_rate, node->config->destination);
   while (node->config->is_running) {
     struct message_header header;
@@ -254,19 +380,24 @@ static void *tcp_worker(void *arg) {
   return (void *)0;
 }
 
-static void sdr_callback(uint8_t *buf, uint32_t buf_len, void *ctx) {
+static void sdr_callback(uint8_t *buf, uint32_t buf_len, const sdr_buffer_info *info, void *ctx) {
   tcp_server *server = (tcp_server *)ctx;
   int result = 0;
+  size_t lost_bytes = (size_t)info->lost_samples * sdr_device_get_sample_size(sdr_device_get_sample_format(server->server_config));
   pthread_mutex_lock(&server->mutex);
   struct linked_list_tcp_node *current_node = server->tcp_nodes;
   while (current_node != NULL) {
     if (current_node->config->is_running) {
       // current node marked for termination. that means dsp thread already terminated
       // copy to client's buffers and notify
-      dsp_worker_process(buf, buf_len, current_node->dsp_worker);
+      dsp_worker_process(buf, buf_len, lost_bytes, current_node->dsp_worker);
     }
     current_node = current_node->next;
   }
+  // after the clients, so that new clients can find where their backlog ends
+  if (server->time_shift != NULL) {
+    time_shift_put(buf, buf_len, server->time_shift);
+  }
   pthread_mutex_unlock(&server->mutex);
 }
 
@@ -298,9 +429,49 @@ static void cleanup_terminated_threads(tcp_server *server) {
   }
 }
 
-void handle_new_client(int client_socket, tcp_server *server) {
+// the same as memory, the load can only go down until dsp_worker_start
+static int reserve_client_cpu(client_config *config, tcp_server *server) {
+  config->cpu_cost_millicores = 0;
+  if (server->server_config->cpu_budget_percent == 0) {
+    return 0;
+  }
+  config->cpu_cost_millicores = dsp_cost_estimate(config, server->server_config, &server->cost_model);
+  uint64_t load = server->metrics.dsp_load_millicores;
+  uint64_t capacity = server->metrics.dsp_capacity_millicores;
+  if (load + config->cpu_cost_millicores > capacity) {
+    fprintf(stderr, "<3>[%d] not enough cpu. client needs %" PRIu64 " millicores, used %" PRIu64 " of %" PRIu64 "\n", config->id, config->cpu_cost_millicores, load, capacity);
+    return -1;
+  }
+  return 0;
+}
+
+// only the acceptor thread starts the clients, so the used memory can only go down until dsp_worker_start
+static int reserve_client_memory(client_config *config, tcp_server *server) {
+  struct server_config *server_config = server->server_config;
+  config->queue_size = server_config->queue_size;
+  if (server_config->memory_budget_mb == 0) {
+    return 0;
+  }
+  uint64_t budget = server->metrics.memory_budget_bytes;
+  uint64_t used = server->metrics.memory_bytes;
+  uint64_t overhead = dsp_worker_get_memory_overhead(config, server_config);
+  uint64_t available = (used + overhead < budget) ? (budget - used - overhead) : 0;
+  uint64_t fits = available / server_config->buffer_size;
+  if (fits >= (uint64_t) config->queue_size) {
+    return 0;
+  }
+  if (fits < (uint64_t) server_config->min_queue_size) {
+    fprintf(stderr, "<3>[%d] not enough memory. used %" PRIu64 " bytes of %" PRIu64 "\n", config->id, used, budget);
+    return -1;
+  }
+  config->queue_size = (int) fits;
+  fprintf(stdout, "[%d] queue is reduced to %d buffers to fit into memory budget\n", config->id, config->queue_size);
+  return 0;
+}
+
+void handle_new_client(int client_socket, uint8_t type, tcp_server *server) {
   client_config *config = NULL;
-  if (read_client_config(client_socket, server->client_counter, server->server_config, &config) < 0) {
+  if (read_client_config(client_socket, type, server->client_counter, server->server_config, &config) < 0) {
     respond_failure(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INVALID_REQUEST);
     return;
   }
@@ -312,7 +483,23 @@ void handle_new_client(int client_socket, tcp_server *server) {
 
   config->is_running = true;
   config->id = server->client_counter;
-  config->sdr_type = server->server_config->sdr_type;
+  config->sample_format = sdr_device_get_sample_format(server->server_config);
+  config->optimization = server->server_config->optimization;
+  if (server->kernel_tuner != NULL && kernel_tuner_select(config, server->server_config, server->kernel_tuner, &config->optimization) != 0) {
+    respond_failure(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INTERNAL_ERROR);
+    free(config);
+    return;
+  }
+  if (reserve_client_cpu(config, server) < 0) {
+    respond_failure(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_OUT_OF_CPU);
+    free(config);
+    return;
+  }
+  if (reserve_client_memory(config, server) < 0) {
+    respond_failure(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_OUT_OF_MEMORY);
+    free(config);
+    return;
+  }
 
   struct linked_list_tcp_node *tcp_node = malloc(sizeof(struct linked_list_tcp_node));
   if (tcp_node == NULL) {
@@ -324,7 +511,7 @@ void handle_new_client(int client_socket, tcp_server *server) {
   tcp_node->next = NULL;
   tcp_node->server = server;
 
-  int code = dsp_worker_start(config, server->server_config, &tcp_node->dsp_worker);
+  int code = dsp_worker_start(config, server->server_config, server->time_shift, &server->metrics, &tcp_node->dsp_worker);
   if (code != 0) {
     respond_failure(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INTERNAL_ERROR);
     tcp_node_destroy(tcp_node);
@@ -349,6 +536,10 @@ void handle_new_client(int client_socket, tcp_server *server) {
       pthread_join(server->shutdown_thread, NULL);
       server->shutdown_thread_created = false;
     }
+    // the ring might contain data from another band
+    if (server->time_shift != NULL) {
+      time_shift_reset(server->time_shift);
+    }
     code = sdr_device_start(config, server->device);
     if (code == 0) {
       server->tcp_nodes = tcp_node;
@@ -419,13 +610,27 @@ static void *acceptor_worker(void *arg) {
 
     switch (header.type) {
       case TYPE_REQUEST:
+      case TYPE_REQUEST_TIME_SHIFT:
+      case TYPE_REQUEST_SQUELCH:
         log_client(&address, server->client_counter);
-        handle_new_client(client_socket, server);
+        handle_new_client(client_socket, header.type, server);
         break;
       case TYPE_PING:
         write_message(client_socket, RESPONSE_STATUS_SUCCESS, 0);
         close(client_socket);
         break;
+      case TYPE_STATS:
+        // slow poller should not block the acceptor
+        if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, sizeof tv)) {
+          perror("setsockopt - SO_SNDTIMEO");
+          close(client_socket);
+          break;
+        }
+        if (write_stats(client_socket, server) == -ENOMEM) {
+          write_message(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INTERNAL_ERROR);
+        }
+        close(client_socket);
+        break;
       default:
         fprintf(stderr, "<3>[%d] unsupported request: %d\n", server->client_counter, header.type);
         respond_failure(client_socket, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INVALID_REQUEST);
@@ -433,6 +638,10 @@ static void *acceptor_worker(void *arg) {
     }
   }
 
+  // reads the device stats, so stop it before the device is destroyed
+  metrics_server_destroy(server->metrics_server);
+  server->metrics_server = NULL;
+
   pthread_mutex_lock(&server->mutex);
   struct linked_list_tcp_node *cur_node = server->tcp_nodes;
   while (cur_node != NULL) {
@@ -459,6 +668,12 @@ static void *acceptor_worker(void *arg) {
   if (server->device != NULL) {
     sdr_device_destroy(server->device);
   }
+  if (server->time_shift != NULL) {
+    time_shift_destroy(server->time_shift);
+    server->time_shift = NULL;
+  }
+  kernel_tuner_destroy(server->kernel_tuner);
+  server->kernel_tuner = NULL;
   pthread_mutex_unlock(&server->mutex);
 
   printf("tcp server stopped\n");
@@ -472,11 +687,41 @@ int start_tcp_server(struct server_config *config, tcp_server **server) {
   }
   result->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
   result->tcp_nodes = NULL;
+  result->time_shift = NULL;
+  result->metrics_server = NULL;
+  result->kernel_tuner = NULL;
+  metrics_reset(&result->metrics);
+  result->metrics.memory_budget_bytes = (uint64_t) config->memory_budget_mb * 1024 * 1024;
+  if (config->cpu_budget_percent > 0) {
+    if (dsp_cost_calibrate(config, &result->cost_model) != 0) {
+      free(result);
+      return -1;
+    }
+    result->metrics.dsp_capacity_millicores = (uint64_t) dsp_cost_get_cpus(config) * 10 * config->cpu_budget_percent;
+    fprintf(stdout, "dsp cost: %.3f ns per sample, %.3f ns per tap. capacity: %" PRIu64 " millicores\n", result->cost_model.nanos_per_sample, result->cost_model.nanos_per_tap, result->metrics.dsp_capacity_millicores);
+  }
+  if (config->optimization == AUTO_CF32) {
+    if (kernel_tuner_create(config->kernel_cache_file, &result->kernel_tuner) != 0) {
+      free(result);
+      return -1;
+    }
+  }
+  // before the first queue or filter is allocated
+  sample_memory_configure(config->sample_memory_hugepages, config->sample_memory_prefault, config->sample_memory_lock);
   int code = sdr_device_create(sdr_callback, result, config, &result->device);
   if (code != 0) {
     free(result);
     return -1;
   }
+  if (config->time_shift_seconds > 0) {
+    uint64_t capacity = (uint64_t)config->time_shift_seconds * config->band_sampling_rate * sdr_device_get_sample_size(sdr_device_get_sample_format(config));
+    code = time_shift_create(capacity, config->time_shift_file, &result->time_shift);
+    if (code != 0) {
+      sdr_device_destroy(result->device);
+      free(result);
+      return -1;
+    }
+  }
 
   int server_socket = socket(AF_INET, SOCK_STREAM, 0);
   if (server_socket == 0) {
@@ -529,9 +774,26 @@ int start_tcp_server(struct server_config *config, tcp_server **server) {
     return -1;
   }
 
+  if (config->metrics_port != 0) {
+    code = metrics_server_start(config->metrics_bind_address, config->metrics_port, config->io_cpus, &result->metrics, result->device, &result->metrics_server);
+    if (code != 0) {
+      close(server_socket);
+      time_shift_destroy(result->time_shift);
+      sdr_device_destroy(result->device);
+      kernel_tuner_destroy(result->kernel_tuner);
+      free(result);
+      return -1;
+    }
+  }
+
   pthread_t acceptor_thread;
   code = pthread_create(&acceptor_thread, NULL, &acceptor_worker, result);
   if (code != 0) {
+    metrics_server_destroy(result->metrics_server);
+    close(server_socket);
+    time_shift_destroy(result->time_shift);
+    sdr_device_destroy(result->device);
+    kernel_tuner_destroy(result->kernel_tuner);
     free(result);
     return -1;
   }
@@ -562,3 +824,24 @@ void stop_tcp_server(tcp_server *server) {
     close(server->server_socket);
   }
 }
+
+int tcp_server_get_client_stats(tcp_server *server, uint32_t client_id, dsp_worker_stats *stats) {
+  int result = -1;
+  pthread_mutex_lock(&server->mutex);
+  struct linked_list_tcp_node *cur_node = server->tcp_nodes;
+  while (cur_node != NULL) {
+    // dsp_worker is destroyed under the mutex once the client is not running
+    if (cur_node->config->id == client_id && cur_node->config->is_running) {
+      dsp_worker_get_stats(cur_node->dsp_worker, stats);
+      result = 0;
+      break;
+    }
+    cur_node = cur_node->next;
+  }
+  pthread_mutex_unlock(&server->mutex);
+  return result;
+}
+
+void tcp_server_get_device_stats(tcp_server *server, sdr_device_stats *stats) {
+  sdr_device_get_stats(server->device, stats);
+}
@@ -2,6 +2,8 @@
 #define TCP_SERVER_H_
 
 #include "config.h"
+#include "dsp_worker.h"
+#include "sdr_device_stats.h"
 
 typedef struct tcp_server_t tcp_server;
 
@@ -11,5 +13,10 @@ void join_tcp_server_thread(tcp_server *server);
 
 void stop_tcp_server(tcp_server *server);
 
+// client_id - returned in the response details. -1 if the client is not running
+int tcp_server_get_client_stats(tcp_server *server, uint32_t client_id, dsp_worker_stats *stats);
+
+void tcp_server_get_device_stats(tcp_server *server, sdr_device_stats *stats);
+
 
 #endif /* TCP_SERVER_H_ */
@@ -0,0 +1,69 @@
+#define _GNU_SOURCE
+#include "thread_scheduling.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+int thread_scheduling_apply(const char *name, uint64_t cpus, int priority) {
+  int code = 0;
+  if (cpus != 0) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < 64; i++) {
+      if ((cpus >> i) & 1) {
+        CPU_SET(i, &set);
+      }
+    }
+    code = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+    if (code != 0) {
+      fprintf(stderr, "<3>unable to set cpu affinity of %s thread: %s\n", name, strerror(code));
+    }
+#else
+    fprintf(stderr, "<3>cpu affinity is not supported on this platform\n");
+    code = -1;
+#endif
+  }
+  if (priority > 0) {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int priority_code = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (priority_code != 0) {
+      // requires CAP_SYS_NICE or RLIMIT_RTPRIO
+      fprintf(stderr, "<3>unable to set SCHED_FIFO priority %d of %s thread: %s\n", priority, name, strerror(priority_code));
+      code = priority_code;
+    }
+  }
+  return code;
+}
+
+uint64_t thread_scheduling_get_cpus() {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0) {
+    return 0;
+  }
+  uint64_t result = 0;
+  for (int i = 0; i < 64; i++) {
+    if (CPU_ISSET(i, &set)) {
+      result |= (uint64_t) 1 << i;
+    }
+  }
+  return result;
+#else
+  return 0;
+#endif
+}
+
+int thread_scheduling_get_priority() {
+  int policy;
+  struct sched_param param;
+  if (pthread_getschedparam(pthread_self(), &policy, &param) != 0 || policy != SCHED_FIFO) {
+    return 0;
+  }
+  return param.sched_priority;
+}
@@ -0,0 +1,17 @@
+#ifndef THREAD_SCHEDULING_H_
+#define THREAD_SCHEDULING_H_
+
+#include <stdint.h>
+
+// applied to the calling thread
+// cpus - bitmask of the allowed cpus. 0 - don't change
+// priority - SCHED_FIFO priority from 1 to 99. 0 - don't change
+int thread_scheduling_apply(const char *name, uint64_t cpus, int priority);
+
+// bitmask of the first 64 cpus the calling thread is allowed to run on. 0 if not supported
+uint64_t thread_scheduling_get_cpus();
+
+// SCHED_FIFO priority of the calling thread or 0
+int thread_scheduling_get_priority();
+
+#endif /* THREAD_SCHEDULING_H_ */
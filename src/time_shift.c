@@ -0,0 +1,156 @@
+#include "time_shift.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct time_shift_t {
+  uint8_t *buffer;
+  uint64_t capacity;
+  bool mapped;
+  int fd;
+
+  // absolute number of bytes written
+  uint64_t position;
+  pthread_mutex_t mutex;
+};
+
+int time_shift_create(uint64_t capacity, const char *file_path, time_shift **result) {
+  if (capacity == 0 || capacity > SIZE_MAX) {
+    return -1;
+  }
+  struct time_shift_t *ts = malloc(sizeof(struct time_shift_t));
+  if (ts == NULL) {
+    return -ENOMEM;
+  }
+  // init all fields with 0 so that destroy_* method would work
+  *ts = (struct time_shift_t){0};
+  ts->fd = -1;
+  ts->capacity = capacity;
+  ts->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+  if (file_path != NULL) {
+    // page cache decides what stays in memory
+    ts->fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (ts->fd < 0) {
+      fprintf(stderr, "<3>unable to open time shift file: %s\n", file_path);
+      time_shift_destroy(ts);
+      return -1;
+    }
+    if (ftruncate(ts->fd, (off_t)capacity) != 0) {
+      fprintf(stderr, "<3>unable to allocate time shift file: %s\n", file_path);
+      time_shift_destroy(ts);
+      return -1;
+    }
+    void *mapped = mmap(NULL, (size_t)capacity, PROT_READ | PROT_WRITE, MAP_SHARED, ts->fd, 0);
+    if (mapped == MAP_FAILED) {
+      fprintf(stderr, "<3>unable to map time shift file: %s\n", file_path);
+      time_shift_destroy(ts);
+      return -1;
+    }
+    ts->buffer = mapped;
+    ts->mapped = true;
+  } else {
+    ts->buffer = malloc((size_t)capacity);
+    if (ts->buffer == NULL) {
+      time_shift_destroy(ts);
+      return -ENOMEM;
+    }
+  }
+  *result = ts;
+  return 0;
+}
+
+void time_shift_put(const uint8_t *buffer, size_t len, time_shift *time_shift) {
+  pthread_mutex_lock(&time_shift->mutex);
+  // only the tail of a huge buffer fits
+  if (len > time_shift->capacity) {
+    time_shift->position += len - time_shift->capacity;
+    buffer += len - time_shift->capacity;
+    len = (size_t)time_shift->capacity;
+  }
+  size_t offset = (size_t)(time_shift->position % time_shift->capacity);
+  size_t first = (size_t)time_shift->capacity - offset;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(time_shift->buffer + offset, buffer, first);
+  memcpy(time_shift->buffer, buffer + first, len - first);
+  time_shift->position += len;
+  pthread_mutex_unlock(&time_shift->mutex);
+}
+
+uint64_t time_shift_get_position(time_shift *time_shift) {
+  pthread_mutex_lock(&time_shift->mutex);
+  uint64_t result = time_shift->position;
+  pthread_mutex_unlock(&time_shift->mutex);
+  return result;
+}
+
+static uint64_t time_shift_get_oldest_locked(time_shift *time_shift) {
+  if (time_shift->position < time_shift->capacity) {
+    return 0;
+  }
+  return time_shift->position - time_shift->capacity;
+}
+
+uint64_t time_shift_get_oldest(time_shift *time_shift) {
+  pthread_mutex_lock(&time_shift->mutex);
+  uint64_t result = time_shift_get_oldest_locked(time_shift);
+  pthread_mutex_unlock(&time_shift->mutex);
+  return result;
+}
+
+size_t time_shift_read(uint64_t *position, uint8_t *output, size_t len, time_shift *time_shift) {
+  pthread_mutex_lock(&time_shift->mutex);
+  uint64_t oldest = time_shift_get_oldest_locked(time_shift);
+  if (*position < oldest) {
+    *position = oldest;
+  }
+  if (*position >= time_shift->position) {
+    pthread_mutex_unlock(&time_shift->mutex);
+    return 0;
+  }
+  uint64_t available = time_shift->position - *position;
+  if (len > available) {
+    len = (size_t)available;
+  }
+  size_t offset = (size_t)(*position % time_shift->capacity);
+  size_t first = (size_t)time_shift->capacity - offset;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(output, time_shift->buffer + offset, first);
+  memcpy(output + first, time_shift->buffer, len - first);
+  pthread_mutex_unlock(&time_shift->mutex);
+  *position += len;
+  return len;
+}
+
+void time_shift_reset(time_shift *time_shift) {
+  pthread_mutex_lock(&time_shift->mutex);
+  time_shift->position = 0;
+  pthread_mutex_unlock(&time_shift->mutex);
+}
+
+void time_shift_destroy(time_shift *time_shift) {
+  if (time_shift == NULL) {
+    return;
+  }
+  if (time_shift->buffer != NULL) {
+    if (time_shift->mapped) {
+      munmap(time_shift->buffer, (size_t)time_shift->capacity);
+    } else {
+      free(time_shift->buffer);
+    }
+  }
+  if (time_shift->fd >= 0) {
+    close(time_shift->fd);
+  }
+  free(time_shift);
+}
@@ -0,0 +1,31 @@
+#ifndef TIME_SHIFT_H_
+#define TIME_SHIFT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct time_shift_t time_shift;
+
+// ring of the last capacity bytes received from the device
+// file_path - optional. if set, the ring is memory mapped onto this file
+int time_shift_create(uint64_t capacity, const char *file_path, time_shift **result);
+
+void time_shift_put(const uint8_t *buffer, size_t len, time_shift *time_shift);
+
+// total number of bytes ever put. Used as an absolute position in the stream
+uint64_t time_shift_get_position(time_shift *time_shift);
+
+// the oldest position which is still available
+uint64_t time_shift_get_oldest(time_shift *time_shift);
+
+// copies up to len bytes starting from the position
+// if data at the position was already overwritten, then position is moved to the oldest available
+// position is advanced by the number of bytes returned
+size_t time_shift_read(uint64_t *position, uint8_t *output, size_t len, time_shift *time_shift);
+
+// forget all data. For example, when device was restarted
+void time_shift_reset(time_shift *time_shift);
+
+void time_shift_destroy(time_shift *time_shift);
+
+#endif /* TIME_SHIFT_H_ */
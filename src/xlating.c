@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "sample_memory.h"
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -551,13 +553,14 @@ int create_frequency_xlating_filter(uint32_t decimation, float *taps, size_t tap
   // max input length + history
   result->history_offset = (taps_len - 1);
   result->working_buffer_len_samples = max_input_buffer_length / 2 + result->history_offset;
-  result->working_buffer_cf32 = sdrserver_aligned_alloc(result->alignment_cf32, sizeof(float complex) * result->working_buffer_len_samples);
+  // sample memory is 64 bytes aligned, i.e. more than alignment_cf32
+  result->working_buffer_cf32 = sample_memory_alloc(sizeof(float complex) * result->working_buffer_len_samples);
   if (result->working_buffer_cf32 == NULL) {
     destroy_xlating(result);
     return -ENOMEM;
   }
   memset(result->working_buffer_cf32, 0, sizeof(float complex) * result->working_buffer_len_samples);
-  result->working_buffer_cs16 = sdrserver_aligned_alloc(result->alignment_cf32, sizeof(int16_t) * 2 * result->working_buffer_len_samples);
+  result->working_buffer_cs16 = sample_memory_alloc(sizeof(int16_t) * 2 * result->working_buffer_len_samples);
   if (result->working_buffer_cs16 == NULL) {
     destroy_xlating(result);
     return -ENOMEM;
@@ -566,12 +569,12 @@ int create_frequency_xlating_filter(uint32_t decimation, float *taps, size_t tap
 
   // +1 for case when round-up needed.
   result->output_len_sampls = max_input_buffer_length / 2 / decimation + 1;
-  result->output_cf32 = malloc(sizeof(float complex) * result->output_len_sampls);
+  result->output_cf32 = sample_memory_alloc(sizeof(float complex) * result->output_len_sampls);
   if (result->output_cf32 == NULL) {
     destroy_xlating(result);
     return -ENOMEM;
   }
-  result->output_cs16 = malloc(sizeof(int16_t) * 2 * result->output_len_sampls);
+  result->output_cs16 = sample_memory_alloc(sizeof(int16_t) * 2 * result->output_len_sampls);
   if (result->output_cs16 == NULL) {
     destroy_xlating(result);
     return -ENOMEM;
@@ -601,16 +604,16 @@ void destroy_xlating(xlating *filter) {
     free(filter->original_taps);
   }
   if (filter->output_cf32 != NULL) {
-    free(filter->output_cf32);
+    sample_memory_free(filter->output_cf32);
   }
   if (filter->output_cs16 != NULL) {
-    free(filter->output_cs16);
+    sample_memory_free(filter->output_cs16);
   }
   if (filter->working_buffer_cf32 != NULL) {
-    free(filter->working_buffer_cf32);
+    sample_memory_free(filter->working_buffer_cf32);
   }
   if (filter->working_buffer_cs16 != NULL) {
-    free(filter->working_buffer_cs16);
+    sample_memory_free(filter->working_buffer_cs16);
   }
   free(filter);
 }
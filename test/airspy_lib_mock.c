@@ -12,6 +12,7 @@
 struct mock_status {
   int16_t *buffer;
   int len;
+  enum airspy_sample_type sample_type;
 
   pthread_t worker_thread;
   airspy_sample_block_cb_fn callback;
@@ -32,6 +33,7 @@ int airspy_open(struct airspy_device **device) {
 }
 
 int airspy_set_sample_type(struct airspy_device *device, enum airspy_sample_type sample_type) {
+  airspy_mock.sample_type = sample_type;
   return 0;
 }
 
@@ -93,8 +95,9 @@ static void *airspy_worker(void *ctx) {
           .ctx = ctx,
           .device = NULL,
           .dropped_samples = 0,
-          .sample_count = airspy_mock.len / 2,
-          .sample_type = AIRSPY_SAMPLE_INT16_IQ,
+          // real samples are counted individually
+          .sample_count = (airspy_mock.sample_type == AIRSPY_SAMPLE_INT16_IQ ? airspy_mock.len / 2 : airspy_mock.len),
+          .sample_type = airspy_mock.sample_type,
           .samples = airspy_mock.buffer};
       airspy_mock.callback(&transfer);
       airspy_mock.buffer = NULL;
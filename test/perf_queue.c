@@ -0,0 +1,186 @@
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/histogram.h"
+#include "../src/queue.h"
+
+#define MAX_CONSUMERS 64
+
+typedef struct {
+  queue *queue;
+  pthread_t thread;
+  // simulated processing time of every buffer
+  uint64_t work_nanos;
+  atomic_uint_fast64_t buffers;
+  atomic_uint_fast64_t bytes;
+  // from queue_put until take_buffer_for_processing returned the buffer
+  histogram handoff;
+} consumer;
+
+static uint64_t get_nanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void *consume(void *arg) {
+  consumer *current = (consumer *)arg;
+  while (true) {
+    uint8_t *buffer = NULL;
+    size_t len = 0;
+    take_buffer_for_processing(&buffer, &len, current->queue);
+    // poison pill received
+    if (buffer == NULL) {
+      break;
+    }
+    uint64_t taken = get_nanos();
+    struct timespec put_time;
+    get_put_time_of_buffer(&put_time, current->queue);
+    histogram_record(taken - ((uint64_t)put_time.tv_sec * 1000000000ULL + (uint64_t)put_time.tv_nsec), &current->handoff);
+    // busy wait like the dsp
+    while (get_nanos() - taken < current->work_nanos) {
+    }
+    current->buffers++;
+    current->bytes += len;
+    complete_buffer_processing(current->queue);
+  }
+  return (void *)0;
+}
+
+// comma separated list. The last value is used for the rest of consumers
+static int parse_work(char *value, uint64_t *work_nanos, int max) {
+  int count = 0;
+  char *saveptr = NULL;
+  char *token = strtok_r(value, ",", &saveptr);
+  while (token != NULL && count < max) {
+    work_nanos[count] = (uint64_t)(atof(token) * 1000.0);
+    count++;
+    token = strtok_r(NULL, ",", &saveptr);
+  }
+  return count;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-n consumers] [-s buffer_size] [-q queue_size] [-r producer buffers per second] [-w consumer work micros] [-d duration seconds]\n", name);
+  fprintf(stderr, "  -r 0 produces as fast as possible\n");
+  fprintf(stderr, "  -w comma separated work per buffer for every consumer. For example: 0,100,2000\n");
+}
+
+// one producer puts every buffer into the queue of every consumer, the same as sdr thread and dsp workers.
+// Prints JSON to stdout
+int main(int argc, char **argv) {
+  int number_of_consumers = 4;
+  uint32_t buffer_size = 262144;
+  int queue_size = 64;
+  double rate = 0.0;
+  int duration = 5;
+  uint64_t work_nanos[MAX_CONSUMERS] = {0};
+  int work_len = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:q:r:w:d:")) != -1) {
+    switch (opt) {
+      case 'n':
+        number_of_consumers = atoi(optarg);
+        break;
+      case 's':
+        buffer_size = (uint32_t)atoi(optarg);
+        break;
+      case 'q':
+        queue_size = atoi(optarg);
+        break;
+      case 'r':
+        rate = atof(optarg);
+        break;
+      case 'w':
+        work_len = parse_work(optarg, work_nanos, MAX_CONSUMERS);
+        break;
+      case 'd':
+        duration = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (number_of_consumers <= 0 || number_of_consumers > MAX_CONSUMERS || buffer_size == 0 || queue_size <= 0 || rate < 0.0 || duration <= 0 || work_len <= 0) {
+    usage(argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  uint8_t *input = malloc(buffer_size);
+  consumer *consumers = calloc(number_of_consumers, sizeof(consumer));
+  histogram *put = malloc(sizeof(histogram));
+  if (input == NULL || consumers == NULL || put == NULL) {
+    exit(EXIT_FAILURE);
+  }
+  memset(input, 1, buffer_size);
+  histogram_reset(put);
+  for (int i = 0; i < number_of_consumers; i++) {
+    consumer *current = consumers + i;
+    current->work_nanos = work_nanos[i < work_len ? i : work_len - 1];
+    histogram_reset(&current->handoff);
+    if (create_queue(buffer_size, queue_size, &current->queue) != 0 || pthread_create(&current->thread, NULL, &consume, current) != 0) {
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  uint64_t produced = 0;
+  uint64_t start = get_nanos();
+  uint64_t end = start + (uint64_t)duration * 1000000000ULL;
+  uint64_t now = start;
+  while (now < end) {
+    if (rate > 0.0) {
+      uint64_t next = start + (uint64_t)((double)produced * 1000000000.0 / rate);
+      if (now < next) {
+        struct timespec delay = {(time_t)((next - now) / 1000000000ULL), (long)((next - now) % 1000000000ULL)};
+        nanosleep(&delay, NULL);
+      }
+    }
+    uint64_t put_start = get_nanos();
+    for (int i = 0; i < number_of_consumers; i++) {
+      queue_put(input, buffer_size, consumers[i].queue);
+    }
+    now = get_nanos();
+    histogram_record(now - put_start, put);
+    produced++;
+  }
+  double elapsed = (double)(now - start) / 1000000000.0;
+
+  printf("{\n");
+  printf("  \"consumers\": %d,\n", number_of_consumers);
+  printf("  \"buffer_size\": %u,\n", buffer_size);
+  printf("  \"queue_size\": %d,\n", queue_size);
+  printf("  \"duration_seconds\": %.3f,\n", elapsed);
+  printf("  \"produced_buffers_per_second\": %.1f,\n", (double)produced / elapsed);
+  printf("  \"put_all_queues_p50_nanos\": %" PRIu64 ",\n", histogram_percentile(50.0, put));
+  printf("  \"put_all_queues_p99_nanos\": %" PRIu64 ",\n", histogram_percentile(99.0, put));
+  printf("  \"results\": [\n");
+  for (int i = 0; i < number_of_consumers; i++) {
+    consumer *current = consumers + i;
+    // take the counters before the remaining buffers are drained
+    queue_stats stats;
+    queue_get_stats(current->queue, &stats);
+    uint64_t consumed = current->buffers;
+    printf("    {\"work_micros\": %.1f, \"buffers_per_second\": %.1f, \"mbytes_per_second\": %.3f, ", (double)current->work_nanos / 1000.0, (double)consumed / elapsed, (double)consumed * buffer_size / elapsed / 1000000.0);
+    printf("\"wakeups_per_buffer\": %.3f, \"overflow_rate\": %.4f, \"depth\": %u, ", consumed > 0 ? (double)stats.wakeups / (double)consumed : 0.0, stats.buffers > 0 ? (double)stats.overflows / (double)stats.buffers : 0.0, stats.depth);
+    printf("\"handoff_p50_nanos\": %" PRIu64 ", \"handoff_p99_nanos\": %" PRIu64 ", \"handoff_max_nanos\": %" PRIu64 "}%s\n", histogram_percentile(50.0, &current->handoff), histogram_percentile(99.0, &current->handoff), (uint64_t)current->handoff.max, (i + 1 < number_of_consumers) ? "," : "");
+  }
+  printf("  ]\n");
+  printf("}\n");
+
+  for (int i = 0; i < number_of_consumers; i++) {
+    interrupt_waiting_the_data(consumers[i].queue);
+    pthread_join(consumers[i].thread, NULL);
+    destroy_queue(consumers[i].queue);
+  }
+  free(consumers);
+  free(put);
+  free(input);
+  return 0;
+}
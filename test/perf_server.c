@@ -0,0 +1,294 @@
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/api.h"
+#include "../src/client/tcp_client.h"
+#include "../src/config.h"
+#include "../src/sdr_device.h"
+#include "../src/tcp_server.h"
+
+#ifndef CMAKE_C_FLAGS
+#define CMAKE_C_FLAGS ""
+#endif
+
+#define BAND_FREQ 100000000
+
+extern const char *SIMD_STATUS;
+
+// output sampling rates and destinations are assigned round-robin
+static const uint32_t DECIMATIONS[] = {42, 21, 14, 7};
+static const uint8_t DESTINATIONS[] = {REQUEST_DESTINATION_SOCKET, REQUEST_DESTINATION_SOCKET, REQUEST_DESTINATION_FILE, REQUEST_DESTINATION_SOCKET, REQUEST_DESTINATION_SOCKET, REQUEST_DESTINATION_SOCKET, REQUEST_DESTINATION_SOCKET, REQUEST_DESTINATION_SOCKET_RAW};
+
+typedef struct {
+  struct tcp_client *client;
+  uint32_t id;
+  uint32_t sampling_rate;
+  int32_t offset;
+  uint8_t destination;
+  pthread_t reader_thread;
+  bool reader_started;
+  atomic_uint_fast64_t received_bytes;
+
+  uint64_t start_received_bytes;
+  dsp_worker_stats start;
+  dsp_worker_stats end;
+} perf_client;
+
+static const char *get_destination_name(uint8_t destination) {
+  switch (destination) {
+    case REQUEST_DESTINATION_FILE:
+      return "file";
+    case REQUEST_DESTINATION_SOCKET:
+      return "socket";
+    case REQUEST_DESTINATION_FILE_RAW:
+      return "file_raw";
+    case REQUEST_DESTINATION_SOCKET_RAW:
+      return "socket_raw";
+    default:
+      return "unknown";
+  }
+}
+
+static double get_seconds(const struct timespec *value) {
+  return (double)value->tv_sec + (double)value->tv_nsec / 1000000000.0;
+}
+
+static double get_process_cpu_seconds() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+static void *read_client_data(void *arg) {
+  perf_client *client = (perf_client *)arg;
+  uint8_t buffer[65536];
+  while (true) {
+    ssize_t received = read(client->client->client_socket, buffer, sizeof(buffer));
+    // server closed the connection
+    if (received <= 0) {
+      break;
+    }
+    client->received_bytes += (uint64_t)received;
+  }
+  return (void *)0;
+}
+
+static int connect_client(struct server_config *config, int index, perf_client *client) {
+  uint32_t decimation = DECIMATIONS[index % (sizeof(DECIMATIONS) / sizeof(DECIMATIONS[0]))];
+  client->destination = DESTINATIONS[index % (sizeof(DESTINATIONS) / sizeof(DESTINATIONS[0]))];
+  if (client->destination == REQUEST_DESTINATION_SOCKET_RAW) {
+    client->sampling_rate = config->band_sampling_rate;
+    client->offset = 0;
+  } else {
+    client->sampling_rate = config->band_sampling_rate / decimation;
+    // spread channels across the inner half of the band
+    int32_t steps = 16;
+    int32_t step = (int32_t)(config->band_sampling_rate / 2 / steps);
+    client->offset = ((index * 7) % steps - steps / 2) * step;
+  }
+  int code = create_client(config->bind_address, config->port, &client->client);
+  if (code != 0) {
+    fprintf(stderr, "<3>unable to connect client %d\n", index);
+    return code;
+  }
+  code = send_message(client->client, PROTOCOL_VERSION, TYPE_REQUEST, BAND_FREQ + client->offset, client->sampling_rate, BAND_FREQ, client->destination);
+  if (code != 0) {
+    return code;
+  }
+  struct message_header *response_header = NULL;
+  struct response *resp = NULL;
+  code = read_response(&response_header, &resp, client->client);
+  if (code != 0) {
+    return code;
+  }
+  if (resp->status != RESPONSE_STATUS_SUCCESS) {
+    fprintf(stderr, "<3>client %d rejected: %d\n", index, resp->details);
+    code = -1;
+  } else {
+    client->id = resp->details;
+  }
+  free(resp);
+  free(response_header);
+  if (code != 0) {
+    return code;
+  }
+  code = pthread_create(&client->reader_thread, NULL, &read_client_data, client);
+  if (code != 0) {
+    return code;
+  }
+  client->reader_started = true;
+  return 0;
+}
+
+static void disconnect_client(perf_client *client) {
+  if (client->client == NULL) {
+    return;
+  }
+  send_message(client->client, PROTOCOL_VERSION, TYPE_SHUTDOWN, 0, 0, 0, 0);
+  if (client->reader_started) {
+    pthread_join(client->reader_thread, NULL);
+  }
+  destroy_client(client->client);
+  client->client = NULL;
+}
+
+static void print_report(FILE *output, struct server_config *config, perf_client *clients, int number_of_clients, double elapsed, const sdr_device_stats *device_start, const sdr_device_stats *device_end, double process_cpu) {
+  uint64_t total_overflows = 0;
+  uint64_t max_p99 = 0;
+  for (int i = 0; i < number_of_clients; i++) {
+    total_overflows += clients[i].end.queue_overflows - clients[i].start.queue_overflows;
+    if (clients[i].end.latency_p99_micros > max_p99) {
+      max_p99 = clients[i].end.latency_p99_micros;
+    }
+  }
+  uint64_t lost_samples = (device_end->lost_samples + device_end->dropped_samples) - (device_start->lost_samples + device_start->dropped_samples);
+  fprintf(output, "{\n");
+  fprintf(output, "  \"simd\": \"%s\",\n", SIMD_STATUS);
+  fprintf(output, "  \"compilation_flags\": \"%s\",\n", CMAKE_C_FLAGS);
+  fprintf(output, "  \"band_sampling_rate\": %u,\n", config->band_sampling_rate);
+  fprintf(output, "  \"buffer_size\": %u,\n", config->buffer_size);
+  fprintf(output, "  \"queue_size\": %d,\n", config->queue_size);
+  fprintf(output, "  \"number_of_clients\": %d,\n", number_of_clients);
+  fprintf(output, "  \"duration_seconds\": %.3f,\n", elapsed);
+  fprintf(output, "  \"device_msps\": %.6f,\n", (double)(device_end->samples - device_start->samples) / elapsed / 1000000.0);
+  fprintf(output, "  \"device_lost_samples\": %" PRIu64 ",\n", lost_samples);
+  fprintf(output, "  \"queue_overflows\": %" PRIu64 ",\n", total_overflows);
+  fprintf(output, "  \"max_latency_p99_micros\": %" PRIu64 ",\n", max_p99);
+  // includes the simulated clients
+  fprintf(output, "  \"process_cpu_percent\": %.2f,\n", process_cpu / elapsed * 100.0);
+  fprintf(output, "  \"keeping_up\": %s,\n", (total_overflows == 0 && lost_samples == 0) ? "true" : "false");
+  if (config->stage_stats) {
+    fprintf(output, "  \"device_callback_p50_nanos\": %" PRIu64 ", \"device_callback_p99_nanos\": %" PRIu64 ", \"device_callback_max_nanos\": %" PRIu64 ",\n", device_end->callback_p50_nanos, device_end->callback_p99_nanos, device_end->callback_max_nanos);
+  }
+  fprintf(output, "  \"clients\": [\n");
+  for (int i = 0; i < number_of_clients; i++) {
+    perf_client *client = clients + i;
+    dsp_worker_stats *start = &client->start;
+    dsp_worker_stats *end = &client->end;
+    fprintf(output, "    {\"id\": %u, \"destination\": \"%s\", \"sampling_rate\": %u, \"offset\": %d, ", client->id, get_destination_name(client->destination), client->sampling_rate, client->offset);
+    fprintf(output, "\"input_msps\": %.6f, ", (double)(end->input_bytes - start->input_bytes) / sdr_device_get_sample_size(sdr_device_get_sample_format(config)) / elapsed / 1000000.0);
+    fprintf(output, "\"output_bytes_per_second\": %.1f, ", (double)(end->output_bytes - start->output_bytes) / elapsed);
+    fprintf(output, "\"received_bytes_per_second\": %.1f, ", (double)(client->received_bytes - client->start_received_bytes) / elapsed);
+    fprintf(output, "\"queue_overflows\": %" PRIu64 ", ", end->queue_overflows - start->queue_overflows);
+    fprintf(output, "\"latency_p50_micros\": %" PRIu64 ", \"latency_p99_micros\": %" PRIu64 ", \"latency_max_micros\": %" PRIu64 ", ", end->latency_p50_micros, end->latency_p99_micros, end->latency_max_micros);
+    if (config->stage_stats) {
+      for (int j = 0; j < DSP_STAGE_COUNT; j++) {
+        const char *name = dsp_worker_get_stage_name(j);
+        fprintf(output, "\"%s_p50_nanos\": %" PRIu64 ", \"%s_p99_nanos\": %" PRIu64 ", \"%s_max_nanos\": %" PRIu64 ", ", name, end->stage_p50_nanos[j], name, end->stage_p99_nanos[j], name, end->stage_max_nanos[j]);
+      }
+    }
+    fprintf(output, "\"cpu_percent\": %.2f}%s\n", (double)(end->cpu_nanos - start->cpu_nanos) / 1000000000.0 / elapsed * 100.0, (i + 1 < number_of_clients) ? "," : "");
+  }
+  fprintf(output, "  ]\n");
+  fprintf(output, "}\n");
+}
+
+static void snapshot_clients(tcp_server *server, perf_client *clients, int number_of_clients, bool start) {
+  for (int i = 0; i < number_of_clients; i++) {
+    dsp_worker_stats *stats = start ? &clients[i].start : &clients[i].end;
+    if (tcp_server_get_client_stats(server, clients[i].id, stats) != 0) {
+      fprintf(stderr, "<3>client %u is not running\n", clients[i].id);
+    }
+    if (start) {
+      clients[i].start_received_bytes = clients[i].received_bytes;
+    }
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-c number of clients] [-d duration seconds] [-w warmup seconds] [-f config]\n", name);
+}
+
+// starts the server on the synthetic device, connects clients with mixed sampling rates and destinations
+// and prints JSON report to stdout. Server logs go to stderr
+int main(int argc, char **argv) {
+  int number_of_clients = 8;
+  int duration = 10;
+  int warmup = 1;
+  const char *config_file = "perf_server.config";
+  int opt;
+  while ((opt = getopt(argc, argv, "c:d:w:f:")) != -1) {
+    switch (opt) {
+      case 'c':
+        number_of_clients = atoi(optarg);
+        break;
+      case 'd':
+        duration = atoi(optarg);
+        break;
+      case 'w':
+        warmup = atoi(optarg);
+        break;
+      case 'f':
+        config_file = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (number_of_clients <= 0 || duration <= 0 || warmup < 0) {
+    usage(argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  // keep stdout for the report only
+  FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+  if (report == NULL || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+    exit(EXIT_FAILURE);
+  }
+
+  struct server_config *config = NULL;
+  int code = create_server_config(&config, config_file);
+  if (code != 0) {
+    exit(EXIT_FAILURE);
+  }
+  tcp_server *server = NULL;
+  code = start_tcp_server(config, &server);
+  if (code != 0) {
+    destroy_server_config(config);
+    exit(EXIT_FAILURE);
+  }
+  perf_client *clients = calloc(number_of_clients, sizeof(perf_client));
+  if (clients == NULL) {
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < number_of_clients && code == 0; i++) {
+    code = connect_client(config, i, clients + i);
+  }
+  if (code == 0) {
+    sleep(warmup);
+    sdr_device_stats device_start;
+    tcp_server_get_device_stats(server, &device_start);
+    snapshot_clients(server, clients, number_of_clients, true);
+    double process_cpu_start = get_process_cpu_seconds();
+    struct timespec start_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    sleep(duration);
+
+    sdr_device_stats device_end;
+    tcp_server_get_device_stats(server, &device_end);
+    snapshot_clients(server, clients, number_of_clients, false);
+    double process_cpu = get_process_cpu_seconds() - process_cpu_start;
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+    print_report(report, config, clients, number_of_clients, get_seconds(&end_time) - get_seconds(&start_time), &device_start, &device_end, process_cpu);
+    fflush(report);
+  }
+
+  for (int i = 0; i < number_of_clients; i++) {
+    disconnect_client(clients + i);
+  }
+  free(clients);
+  stop_tcp_server(server);
+  join_tcp_server_thread(server);
+  destroy_server_config(config);
+  fclose(report);
+  return code == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -75,6 +75,24 @@ int rtlsdr_read_sync_mocked(rtlsdr_dev_t *dev, void *buf, int len, int *n_read)
   return -1;
 }
 
+int rtlsdr_read_async_mocked(rtlsdr_dev_t *dev, rtlsdr_read_async_cb_t cb, void *ctx, uint32_t buf_num, uint32_t buf_len) {
+  uint8_t *buf = malloc(buf_len);
+  if (buf == NULL) {
+    return -ENOMEM;
+  }
+  int n_read = 0;
+  while (rtlsdr_read_sync_mocked(dev, buf, (int)buf_len, &n_read) == 0) {
+    cb(buf, (uint32_t)n_read, ctx);
+  }
+  free(buf);
+  return 0;
+}
+
+int rtlsdr_cancel_async_mocked(rtlsdr_dev_t *dev) {
+  rtlsdr_stop_mock();
+  return 0;
+}
+
 int rtlsdr_close_mocked(rtlsdr_dev_t *dev) {
   rtlsdr_stop_mock();
   if (dev != NULL) {
@@ -147,6 +165,8 @@ int rtlsdr_lib_create(rtlsdr_lib **lib) {
   result->rtlsdr_set_tuner_gain = rtlsdr_set_tuner_gain_mocked;
   result->rtlsdr_set_tuner_gain_mode = rtlsdr_set_tuner_gain_mode_mocked;
   result->rtlsdr_read_sync = rtlsdr_read_sync_mocked;
+  result->rtlsdr_read_async = rtlsdr_read_async_mocked;
+  result->rtlsdr_cancel_async = rtlsdr_cancel_async_mocked;
   result->rtlsdr_set_freq_correction = rtlsdr_set_freq_correction_mocked;
   result->rtlsdr_get_index_by_serial = rtlsdr_get_index_by_serial;
 
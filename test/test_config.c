@@ -28,6 +28,32 @@ void test_invalid_queue_size_config() {
   TEST_ASSERT_EQUAL_INT(code, -1);
 }
 
+void test_invalid_compression_filter() {
+  int code = create_server_config(&config, "invalid.compression_filter.config");
+  TEST_ASSERT_EQUAL_INT(code, -1);
+}
+
+void test_invalid_rtlsdr_buffer_size() {
+  int code = create_server_config(&config, "invalid.rtlsdr_buffer_size.config");
+  TEST_ASSERT_EQUAL_INT(code, -1);
+}
+
+void test_invalid_replay() {
+  int code = create_server_config(&config, "invalid.replay.config");
+  TEST_ASSERT_EQUAL_INT(code, -1);
+}
+
+void test_rotation() {
+  int code = create_server_config(&config, "rotation.config");
+  TEST_ASSERT_EQUAL_INT(code, 0);
+  TEST_ASSERT_EQUAL_INT(2, config->base_paths_len);
+  TEST_ASSERT_EQUAL_STRING("/tmp/", config->base_path);
+  TEST_ASSERT_EQUAL_STRING("/tmp/", config->base_paths[0]);
+  TEST_ASSERT_EQUAL_STRING("/var/tmp/", config->base_paths[1]);
+  TEST_ASSERT_EQUAL_UINT64(10000000000ULL, config->file_rotation_bytes);
+  TEST_ASSERT_EQUAL_INT(600, config->file_rotation_seconds);
+}
+
 void test_minimal_config() {
   int code = create_server_config(&config, "minimal.config");
   TEST_ASSERT_EQUAL_INT(code, 0);
@@ -47,10 +73,24 @@ void test_success() {
   TEST_ASSERT_EQUAL_INT(config->port, 8089);
   TEST_ASSERT_EQUAL_INT(config->buffer_size, 131072);
   TEST_ASSERT_EQUAL_STRING(config->base_path, "/tmp/");
+  TEST_ASSERT_EQUAL_INT(1, config->base_paths_len);
+  TEST_ASSERT_EQUAL_UINT64(0, config->file_rotation_bytes);
   TEST_ASSERT_EQUAL_INT(config->read_timeout_seconds, 10);
   TEST_ASSERT_EQUAL_INT(config->use_gzip, 0);
+  TEST_ASSERT_EQUAL_INT(COMPRESSION_NONE, config->compression);
+  TEST_ASSERT_EQUAL_INT(COMPRESSION_NONE, config_get_compression(config));
+  // legacy flag set after parsing
+  config->use_gzip = true;
+  TEST_ASSERT_EQUAL_INT(COMPRESSION_GZIP, config_get_compression(config));
+  TEST_ASSERT_EQUAL_INT(COMPRESSION_FILTER_NONE, config->compression_filter);
   TEST_ASSERT_EQUAL_INT(config->queue_size, 64);
+  TEST_ASSERT_EQUAL_INT(0, config->memory_budget_mb);
+  TEST_ASSERT_EQUAL_INT(0, config->cpu_budget_percent);
+  TEST_ASSERT_EQUAL_INT(config->queue_size, config->min_queue_size);
   TEST_ASSERT_EQUAL_INT(config->lpf_cutoff_rate, 5);
+  TEST_ASSERT_EQUAL_INT(10, config->log_summary_seconds);
+  TEST_ASSERT_EQUAL_INT(0, config->metrics_port);
+  TEST_ASSERT_FALSE(config->sample_memory_hugepages);
 }
 
 void tearDown() {
@@ -71,5 +111,9 @@ int main(void) {
   RUN_TEST(test_minimal_config);
   RUN_TEST(test_invalid_timeout);
   RUN_TEST(test_invalid_queue_size_config);
+  RUN_TEST(test_invalid_compression_filter);
+  RUN_TEST(test_invalid_rtlsdr_buffer_size);
+  RUN_TEST(test_invalid_replay);
+  RUN_TEST(test_rotation);
   return UNITY_END();
 }
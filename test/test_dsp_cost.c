@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "../src/api.h"
+#include "../src/dsp_cost.h"
+
+struct server_config *config = NULL;
+dsp_cost_model model;
+
+void test_calibrate() {
+  TEST_ASSERT_EQUAL_INT(0, dsp_cost_calibrate(config, &model));
+  TEST_ASSERT(model.nanos_per_sample > 0.0 || model.nanos_per_tap > 0.0);
+  TEST_ASSERT(model.nanos_per_sample >= 0.0);
+  TEST_ASSERT(model.nanos_per_tap >= 0.0);
+}
+
+void test_estimate() {
+  model.nanos_per_sample = 2.0;
+  model.nanos_per_tap = 0.0;
+  client_config client = {.sampling_rate = 48000, .destination = REQUEST_DESTINATION_SOCKET};
+  // 2.4Msps * 2ns = 4.8ms of cpu every second
+  TEST_ASSERT_EQUAL_UINT64(4, dsp_cost_estimate(&client, config, &model));
+  model.nanos_per_tap = 1.0;
+  uint64_t narrow = dsp_cost_estimate(&client, config, &model);
+  TEST_ASSERT(narrow > 4);
+  // the same channel on twice wider band costs twice more
+  config->band_sampling_rate *= 2;
+  uint64_t wide_band = dsp_cost_estimate(&client, config, &model);
+  TEST_ASSERT_UINT64_WITHIN(narrow / 10 + 1, 2 * narrow, wide_band);
+}
+
+void test_passthrough_is_free() {
+  model.nanos_per_sample = 2.0;
+  model.nanos_per_tap = 1.0;
+  client_config client = {.sampling_rate = config->band_sampling_rate, .destination = REQUEST_DESTINATION_SOCKET_RAW};
+  TEST_ASSERT_EQUAL_UINT64(0, dsp_cost_estimate(&client, config, &model));
+}
+
+void test_cpus() {
+  TEST_ASSERT(dsp_cost_get_cpus(config) >= 1);
+  config->dsp_cpus = 0x6;
+  TEST_ASSERT_EQUAL_UINT32(2, dsp_cost_get_cpus(config));
+}
+
+void setUp() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+}
+
+void tearDown() {
+  destroy_server_config(config);
+  config = NULL;
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_calibrate);
+  RUN_TEST(test_estimate);
+  RUN_TEST(test_passthrough_is_free);
+  RUN_TEST(test_cpus);
+  return UNITY_END();
+}
@@ -0,0 +1,262 @@
+#include <lz4frame.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include "../src/file_output.h"
+#include "../src/gzip_index.h"
+#include "../src/sample_filter.h"
+
+#define FILENAME "file_output.cf32"
+
+file_output *output = NULL;
+uint8_t *input = NULL;
+uint8_t *filtered = NULL;
+uint8_t *decoded = NULL;
+uint8_t *file_data = NULL;
+gzip_index_entry *entries = NULL;
+struct server_config config;
+
+static void setup_input(size_t len) {
+  input = malloc(sizeof(uint8_t) * len);
+  TEST_ASSERT(input != NULL);
+  for (size_t i = 0; i < len; i++) {
+    input[i] = (uint8_t)((i * 7) ^ (i >> 9));
+  }
+}
+
+static void assert_filter(compression_filter filter, uint8_t lane_size, size_t len) {
+  setup_input(len);
+  filtered = malloc(sizeof(uint8_t) * len);
+  decoded = malloc(sizeof(uint8_t) * len);
+  TEST_ASSERT(filtered != NULL);
+  TEST_ASSERT(decoded != NULL);
+  sample_filter_header header = {filter, lane_size, SAMPLE_FILTER_BLOCK_SIZE};
+  sample_filter_encode(input, len, &header, filtered);
+  sample_filter_decode(filtered, len, &header, decoded);
+  TEST_ASSERT_EQUAL_MEMORY(input, decoded, len);
+  free(input);
+  input = NULL;
+  free(filtered);
+  filtered = NULL;
+  free(decoded);
+  decoded = NULL;
+}
+
+static size_t read_file(const char *filename) {
+  FILE *fp = fopen(filename, "rb");
+  TEST_ASSERT(fp != NULL);
+  fseek(fp, 0L, SEEK_END);
+  long len = ftell(fp);
+  rewind(fp);
+  file_data = malloc(sizeof(uint8_t) * len);
+  TEST_ASSERT(file_data != NULL);
+  TEST_ASSERT_EQUAL_INT(len, fread(file_data, 1, len, fp));
+  fclose(fp);
+  return (size_t)len;
+}
+
+static void assert_compressed_file(const char *filename, compression_filter filter, size_t expected_len) {
+  size_t file_len = read_file(filename);
+  TEST_ASSERT(file_len >= SAMPLE_FILTER_HEADER_SIZE + SAMPLE_FILTER_TRAILER_SIZE);
+  sample_filter_header header;
+  TEST_ASSERT_EQUAL_INT(0, sample_filter_parse_header(file_data, file_len, &header));
+  TEST_ASSERT_EQUAL_INT(filter, header.filter);
+  TEST_ASSERT_EQUAL_INT(sizeof(float), header.lane_size);
+  uint64_t total_len = 0;
+  TEST_ASSERT_EQUAL_INT(0, sample_filter_parse_trailer(file_data + file_len - SAMPLE_FILTER_TRAILER_SIZE, SAMPLE_FILTER_TRAILER_SIZE, &total_len));
+  TEST_ASSERT_EQUAL_UINT64(expected_len, total_len);
+
+  const uint8_t *frame = file_data + SAMPLE_FILTER_HEADER_SIZE;
+  size_t frame_len = file_len - SAMPLE_FILTER_HEADER_SIZE - SAMPLE_FILTER_TRAILER_SIZE;
+  filtered = malloc(sizeof(uint8_t) * expected_len + 1);
+  TEST_ASSERT(filtered != NULL);
+  if (config.compression == COMPRESSION_ZSTD) {
+    size_t actual = ZSTD_decompress(filtered, expected_len + 1, frame, frame_len);
+    TEST_ASSERT(!ZSTD_isError(actual));
+    TEST_ASSERT_EQUAL_INT(expected_len, actual);
+  } else {
+    LZ4F_dctx *dctx = NULL;
+    TEST_ASSERT(!LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)));
+    size_t dst_size = expected_len + 1;
+    size_t src_size = frame_len;
+    size_t code = LZ4F_decompress(dctx, filtered, &dst_size, frame, &src_size, NULL);
+    LZ4F_freeDecompressionContext(dctx);
+    TEST_ASSERT_EQUAL_INT(0, code);
+    TEST_ASSERT_EQUAL_INT(expected_len, dst_size);
+  }
+
+  decoded = malloc(sizeof(uint8_t) * expected_len + 1);
+  TEST_ASSERT(decoded != NULL);
+  for (size_t offset = 0; offset < expected_len; offset += header.block_size) {
+    size_t len = (expected_len - offset) < header.block_size ? (expected_len - offset) : header.block_size;
+    sample_filter_decode(filtered + offset, len, &header, decoded + offset);
+  }
+  if (expected_len > 0) {
+    TEST_ASSERT_EQUAL_MEMORY(input, decoded, expected_len);
+  }
+}
+
+static void write_file(file_compression compression, int level, compression_filter filter, size_t len) {
+  config.compression = compression;
+  config.compression_level = level;
+  config.compression_filter = filter;
+  setup_input(len);
+  TEST_ASSERT_EQUAL_INT(0, file_output_create(FILENAME, sizeof(float), &config, &output));
+  // odd chunks to cross block boundaries
+  size_t chunk = 10007;
+  for (size_t offset = 0; offset < len; offset += chunk) {
+    size_t to_write = (len - offset) < chunk ? (len - offset) : chunk;
+    TEST_ASSERT_EQUAL_INT(0, file_output_write(input + offset, to_write, output));
+  }
+  file_output_destroy(output);
+  output = NULL;
+}
+
+void test_filter() {
+  assert_filter(COMPRESSION_FILTER_SHUFFLE, 4, 1000);
+  assert_filter(COMPRESSION_FILTER_SHUFFLE, 2, 1001);
+  assert_filter(COMPRESSION_FILTER_DELTA, 4, 1003);
+  assert_filter(COMPRESSION_FILTER_DELTA, 2, 1000);
+  assert_filter(COMPRESSION_FILTER_DELTA, 1, 1000);
+  assert_filter(COMPRESSION_FILTER_NONE, 4, 1000);
+}
+
+void test_header() {
+  sample_filter_header expected = {COMPRESSION_FILTER_DELTA, 2, 12345};
+  uint8_t buffer[SAMPLE_FILTER_HEADER_SIZE];
+  sample_filter_format_header(&expected, buffer);
+  sample_filter_header actual;
+  TEST_ASSERT_EQUAL_INT(0, sample_filter_parse_header(buffer, sizeof(buffer), &actual));
+  TEST_ASSERT_EQUAL_INT(expected.filter, actual.filter);
+  TEST_ASSERT_EQUAL_INT(expected.lane_size, actual.lane_size);
+  TEST_ASSERT_EQUAL_UINT32(expected.block_size, actual.block_size);
+  TEST_ASSERT_EQUAL_INT(-1, sample_filter_parse_header(buffer, sizeof(buffer) - 1, &actual));
+  buffer[14] = 3;
+  TEST_ASSERT_EQUAL_INT(-1, sample_filter_parse_header(buffer, sizeof(buffer), &actual));
+
+  uint8_t trailer[SAMPLE_FILTER_TRAILER_SIZE];
+  sample_filter_format_trailer(0x123456789AULL, trailer);
+  uint64_t total_len = 0;
+  TEST_ASSERT_EQUAL_INT(0, sample_filter_parse_trailer(trailer, sizeof(trailer), &total_len));
+  TEST_ASSERT_EQUAL_UINT64(0x123456789AULL, total_len);
+  TEST_ASSERT_EQUAL_INT(-1, sample_filter_parse_trailer(buffer, sizeof(buffer), &total_len));
+}
+
+void test_zstd() {
+  size_t len = 3 * SAMPLE_FILTER_BLOCK_SIZE + 123;
+  write_file(COMPRESSION_ZSTD, 3, COMPRESSION_FILTER_DELTA, len);
+  assert_compressed_file(FILENAME ".zst", COMPRESSION_FILTER_DELTA, len);
+}
+
+void test_lz4() {
+  size_t len = 3 * SAMPLE_FILTER_BLOCK_SIZE + 123;
+  write_file(COMPRESSION_LZ4, 0, COMPRESSION_FILTER_SHUFFLE, len);
+  assert_compressed_file(FILENAME ".lz4", COMPRESSION_FILTER_SHUFFLE, len);
+}
+
+void test_empty() {
+  write_file(COMPRESSION_ZSTD, 3, COMPRESSION_FILTER_NONE, 0);
+  assert_compressed_file(FILENAME ".zst", COMPRESSION_FILTER_NONE, 0);
+}
+
+void test_none() {
+  size_t len = 1000;
+  write_file(COMPRESSION_NONE, 0, COMPRESSION_FILTER_NONE, len);
+  TEST_ASSERT_EQUAL_INT(len, read_file(FILENAME));
+  TEST_ASSERT_EQUAL_MEMORY(input, file_data, len);
+}
+
+// every seek point should be inflated independently
+static void assert_gzip_index(const char *filename, size_t expected_len) {
+  size_t entries_len = 0;
+  TEST_ASSERT_EQUAL_INT(0, gzip_index_load(filename, &entries, &entries_len));
+  TEST_ASSERT(entries_len > 2);
+  TEST_ASSERT_EQUAL_UINT64(0, entries[0].uncompressed);
+  TEST_ASSERT_EQUAL_UINT64(expected_len, entries[entries_len - 1].uncompressed);
+  size_t file_len = read_file(filename);
+  decoded = malloc(sizeof(uint8_t) * expected_len);
+  TEST_ASSERT(decoded != NULL);
+  for (size_t i = entries_len - 1; i-- > 0;) {
+    z_stream strm = {0};
+    TEST_ASSERT_EQUAL_INT(Z_OK, inflateInit2(&strm, -15));
+    strm.next_in = file_data + entries[i].compressed;
+    strm.avail_in = (uInt)(file_len - entries[i].compressed);
+    strm.next_out = decoded + entries[i].uncompressed;
+    strm.avail_out = (uInt)(entries[i + 1].uncompressed - entries[i].uncompressed);
+    if (strm.avail_out > 0) {
+      int code = inflate(&strm, Z_NO_FLUSH);
+      TEST_ASSERT(code == Z_OK || code == Z_STREAM_END);
+    }
+    TEST_ASSERT_EQUAL_INT(0, strm.avail_out);
+    inflateEnd(&strm);
+  }
+  TEST_ASSERT_EQUAL_MEMORY(input, decoded, expected_len);
+  remove(FILENAME ".gz" GZIP_INDEX_EXTENSION);
+}
+
+void test_gzip_index() {
+  config.gzip_index_interval = 100000;
+  size_t len = 1000000 + 123;
+  write_file(COMPRESSION_GZIP, Z_DEFAULT_COMPRESSION, COMPRESSION_FILTER_NONE, len);
+  assert_gzip_index(FILENAME ".gz", len);
+}
+
+void test_parallel_gzip_index() {
+  config.gzip_index_interval = 100000;
+  config.gzip_threads = 3;
+  size_t len = 1000000 + 123;
+  write_file(COMPRESSION_GZIP, Z_DEFAULT_COMPRESSION, COMPRESSION_FILTER_NONE, len);
+  assert_gzip_index(FILENAME ".gz", len);
+}
+
+void test_invalid_path() {
+  config.compression = COMPRESSION_LZ4;
+  TEST_ASSERT(file_output_create("/non-existing-directory/1.cf32", sizeof(float), &config, &output) != 0);
+}
+
+void tearDown() {
+  file_output_destroy(output);
+  output = NULL;
+  if (input != NULL) {
+    free(input);
+    input = NULL;
+  }
+  if (filtered != NULL) {
+    free(filtered);
+    filtered = NULL;
+  }
+  if (decoded != NULL) {
+    free(decoded);
+    decoded = NULL;
+  }
+  if (file_data != NULL) {
+    free(file_data);
+    file_data = NULL;
+  }
+  if (entries != NULL) {
+    free(entries);
+    entries = NULL;
+  }
+}
+
+void setUp() {
+  config = (struct server_config){0};
+  config.gzip_threads = 1;
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_filter);
+  RUN_TEST(test_header);
+  RUN_TEST(test_zstd);
+  RUN_TEST(test_lz4);
+  RUN_TEST(test_empty);
+  RUN_TEST(test_none);
+  RUN_TEST(test_gzip_index);
+  RUN_TEST(test_parallel_gzip_index);
+  RUN_TEST(test_invalid_path);
+  return UNITY_END();
+}
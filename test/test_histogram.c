@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "../src/histogram.h"
+
+histogram *result = NULL;
+
+void test_empty() {
+  TEST_ASSERT_EQUAL_UINT64(0, histogram_percentile(50.0, result));
+}
+
+void test_small_values_are_exact() {
+  for (uint64_t i = 0; i < 8; i++) {
+    histogram_record(i, result);
+  }
+  TEST_ASSERT_EQUAL_UINT64(0, histogram_percentile(0.0, result));
+  TEST_ASSERT_EQUAL_UINT64(3, histogram_percentile(50.0, result));
+  TEST_ASSERT_EQUAL_UINT64(7, histogram_percentile(100.0, result));
+  TEST_ASSERT_EQUAL_UINT64(8, result->count);
+  TEST_ASSERT_EQUAL_UINT64(28, result->sum);
+}
+
+void test_percentiles() {
+  for (uint64_t i = 1; i <= 10000; i++) {
+    histogram_record(i, result);
+  }
+  uint64_t p50 = histogram_percentile(50.0, result);
+  TEST_ASSERT(p50 >= 5000);
+  TEST_ASSERT(p50 <= 5000 * 1.125);
+  uint64_t p99 = histogram_percentile(99.0, result);
+  TEST_ASSERT(p99 >= 9900);
+  TEST_ASSERT(p99 <= 10000);
+  TEST_ASSERT_EQUAL_UINT64(10000, histogram_percentile(100.0, result));
+}
+
+void test_huge_values() {
+  histogram_record(1, result);
+  histogram_record(UINT64_MAX / 2, result);
+  TEST_ASSERT_EQUAL_UINT64(1, histogram_percentile(50.0, result));
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX / 2, histogram_percentile(99.0, result));
+  histogram_reset(result);
+  TEST_ASSERT_EQUAL_UINT64(0, histogram_percentile(99.0, result));
+  TEST_ASSERT_EQUAL_UINT64(0, result->max);
+}
+
+void tearDown() {
+  free(result);
+  result = NULL;
+}
+
+void setUp() {
+  result = malloc(sizeof(histogram));
+  TEST_ASSERT(result != NULL);
+  histogram_reset(result);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty);
+  RUN_TEST(test_small_values_are_exact);
+  RUN_TEST(test_percentiles);
+  RUN_TEST(test_huge_values);
+  return UNITY_END();
+}
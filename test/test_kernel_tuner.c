@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../src/api.h"
+#include "../src/kernel_tuner.h"
+#include "../src/lpf.h"
+#include "../src/sdr_device.h"
+
+#define CACHE_FILE "/tmp/test_kernel_tuner.cache"
+
+struct server_config *config = NULL;
+kernel_tuner *tuner = NULL;
+
+static void read_cache(char lines[2][1024]) {
+  FILE *fp = fopen(CACHE_FILE, "r");
+  TEST_ASSERT(fp != NULL);
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT(fgets(lines[i], 1024, fp) != NULL);
+  }
+  fclose(fp);
+}
+
+static void create_outdated_cache() {
+  FILE *fp = fopen(CACHE_FILE, "w");
+  TEST_ASSERT(fp != NULL);
+  fprintf(fp, "cpu=another\nbuild=another\n1 2 3 4 OPTIMIZED_CF32\n");
+  fclose(fp);
+}
+
+// measured kernels might be a near tie and not saved
+static void append_cache_entry(client_config *client, const char *kernel) {
+  float *taps = NULL;
+  size_t taps_len = 0;
+  TEST_ASSERT_EQUAL_INT(0, create_low_pass_filter(1.0F, config->band_sampling_rate, client->sampling_rate / 2, client->sampling_rate / config->lpf_cutoff_rate, &taps, &taps_len));
+  free(taps);
+  FILE *fp = fopen(CACHE_FILE, "a");
+  TEST_ASSERT(fp != NULL);
+  fprintf(fp, "%u %zu %u %u %s\n", (unsigned int) sdr_device_get_sample_format(config), taps_len, config->band_sampling_rate / client->sampling_rate, config->buffer_size, kernel);
+  fclose(fp);
+}
+
+void test_select_without_cache() {
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(NULL, &tuner));
+  client_config client = {.sampling_rate = 48000, .destination = REQUEST_DESTINATION_SOCKET};
+  cpu_optimization first = AUTO_CF32;
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_select(&client, config, tuner, &first));
+  TEST_ASSERT(first == NATIVE_CF32 || first == OPTIMIZED_CF32);
+  // the second client with the same filter gets the same kernel
+  cpu_optimization second = AUTO_CF32;
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_select(&client, config, tuner, &second));
+  TEST_ASSERT_EQUAL_INT(first, second);
+}
+
+void test_passthrough() {
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(NULL, &tuner));
+  client_config client = {.sampling_rate = 48000, .destination = REQUEST_DESTINATION_SOCKET_RAW};
+  cpu_optimization result = AUTO_CF32;
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_select(&client, config, tuner, &result));
+  TEST_ASSERT_EQUAL_INT(NATIVE_CF32, result);
+}
+
+void test_cache() {
+  // outdated results are dropped on load
+  create_outdated_cache();
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(CACHE_FILE, &tuner));
+  kernel_tuner_destroy(tuner);
+  tuner = NULL;
+
+  client_config client = {.sampling_rate = 48000, .destination = REQUEST_DESTINATION_SOCKET};
+  append_cache_entry(&client, "OPTIMIZED_CF32");
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(CACHE_FILE, &tuner));
+  cpu_optimization cached = AUTO_CF32;
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_select(&client, config, tuner, &cached));
+  TEST_ASSERT_EQUAL_INT(OPTIMIZED_CF32, cached);
+  kernel_tuner_destroy(tuner);
+  tuner = NULL;
+
+  // make sure the kernel is taken from the cache and not measured
+  create_outdated_cache();
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(CACHE_FILE, &tuner));
+  kernel_tuner_destroy(tuner);
+  tuner = NULL;
+  append_cache_entry(&client, "NATIVE_CF32");
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(CACHE_FILE, &tuner));
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_select(&client, config, tuner, &cached));
+  TEST_ASSERT_EQUAL_INT(NATIVE_CF32, cached);
+}
+
+void test_outdated_cache() {
+  create_outdated_cache();
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_create(CACHE_FILE, &tuner));
+  char lines[2][1024];
+  read_cache(lines);
+  TEST_ASSERT(strncmp(lines[0], "cpu=", 4) == 0);
+  TEST_ASSERT(strcmp(lines[0], "cpu=another\n") != 0);
+  TEST_ASSERT(strncmp(lines[1], "build=", 6) == 0);
+  TEST_ASSERT(strcmp(lines[1], "build=another\n") != 0);
+  // the results are dropped
+  client_config client = {.sampling_rate = 48000, .destination = REQUEST_DESTINATION_SOCKET};
+  cpu_optimization result = AUTO_CF32;
+  TEST_ASSERT_EQUAL_INT(0, kernel_tuner_select(&client, config, tuner, &result));
+  TEST_ASSERT(result == NATIVE_CF32 || result == OPTIMIZED_CF32);
+}
+
+void setUp() {
+  remove(CACHE_FILE);
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+}
+
+void tearDown() {
+  kernel_tuner_destroy(tuner);
+  tuner = NULL;
+  destroy_server_config(config);
+  config = NULL;
+  remove(CACHE_FILE);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_select_without_cache);
+  RUN_TEST(test_passthrough);
+  RUN_TEST(test_cache);
+  RUN_TEST(test_outdated_cache);
+  return UNITY_END();
+}
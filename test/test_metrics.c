@@ -0,0 +1,98 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "../src/metrics.h"
+
+#define METRICS_PORT 8092
+
+server_metrics *metrics = NULL;
+metrics_server *server = NULL;
+char output[16384];
+
+static void http_get(const char *path, char *response, size_t response_len) {
+  int client_socket = socket(AF_INET, SOCK_STREAM, 0);
+  TEST_ASSERT(client_socket >= 0);
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = inet_addr("127.0.0.1");
+  address.sin_port = htons(METRICS_PORT);
+  TEST_ASSERT_EQUAL_INT(0, connect(client_socket, (struct sockaddr *) &address, sizeof(address)));
+  char request[256];
+  int request_len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+  TEST_ASSERT_EQUAL_INT(request_len, write(client_socket, request, request_len));
+  size_t received = 0;
+  while (received < response_len - 1) {
+    ssize_t current = read(client_socket, response + received, response_len - 1 - received);
+    if (current <= 0) {
+      break;
+    }
+    received += current;
+  }
+  response[received] = '\0';
+  close(client_socket);
+}
+
+void test_format() {
+  metrics->clients = 2;
+  metrics->queue_overflows = 3;
+  metrics->dsp_cpu_nanos = 1500000000;
+  histogram_record(10, &metrics->latency);
+  histogram_record(1000, &metrics->latency);
+  int len = metrics_format(metrics, NULL, output, sizeof(output));
+  TEST_ASSERT(len > 0);
+  TEST_ASSERT_EQUAL_INT(strlen(output), len);
+  TEST_ASSERT(strstr(output, "# TYPE sdr_server_clients gauge\nsdr_server_clients 2\n") != NULL);
+  TEST_ASSERT(strstr(output, "sdr_server_client_queue_overflows_total 3\n") != NULL);
+  TEST_ASSERT(strstr(output, "sdr_server_client_write_failures_total 0\n") != NULL);
+  TEST_ASSERT(strstr(output, "sdr_server_client_dsp_cpu_seconds_total 1.500000\n") != NULL);
+  // buckets are cumulative
+  TEST_ASSERT(strstr(output, "sdr_server_client_latency_seconds_bucket{le=\"1.6e-05\"} 1\n") != NULL);
+  TEST_ASSERT(strstr(output, "sdr_server_client_latency_seconds_bucket{le=\"0.001024\"} 2\n") != NULL);
+  TEST_ASSERT(strstr(output, "sdr_server_client_latency_seconds_bucket{le=\"+Inf\"} 2\n") != NULL);
+  TEST_ASSERT(strstr(output, "sdr_server_client_latency_seconds_count 2\n") != NULL);
+  // device is optional
+  TEST_ASSERT(strstr(output, "sdr_server_device") == NULL);
+}
+
+void test_output_too_small() {
+  TEST_ASSERT_EQUAL_INT(-1, metrics_format(metrics, NULL, output, 100));
+}
+
+void test_http() {
+  metrics->buffers = 42;
+  TEST_ASSERT_EQUAL_INT(0, metrics_server_start("127.0.0.1", METRICS_PORT, 0, metrics, NULL, &server));
+  char response[16384];
+  http_get("/metrics", response, sizeof(response));
+  TEST_ASSERT(strncmp(response, "HTTP/1.0 200 OK\r\n", strlen("HTTP/1.0 200 OK\r\n")) == 0);
+  TEST_ASSERT(strstr(response, "\r\n\r\n# HELP sdr_server_clients") != NULL);
+  TEST_ASSERT(strstr(response, "sdr_server_client_buffers_total 42\n") != NULL);
+  http_get("/", response, sizeof(response));
+  TEST_ASSERT(strncmp(response, "HTTP/1.0 404 Not Found\r\n", strlen("HTTP/1.0 404 Not Found\r\n")) == 0);
+}
+
+void setUp() {
+  metrics = malloc(sizeof(server_metrics));
+  TEST_ASSERT(metrics != NULL);
+  metrics_reset(metrics);
+}
+
+void tearDown() {
+  metrics_server_destroy(server);
+  server = NULL;
+  free(metrics);
+  metrics = NULL;
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_format);
+  RUN_TEST(test_output_too_small);
+  RUN_TEST(test_http);
+  return UNITY_END();
+}
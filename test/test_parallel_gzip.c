@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <unity.h>
+#include <zlib.h>
+
+#include "../src/parallel_gzip.h"
+
+#define FILENAME "parallel.cf32.gz"
+
+parallel_gzip *gz = NULL;
+uint8_t *input = NULL;
+uint8_t *output = NULL;
+
+static void setup_input(size_t len) {
+  input = malloc(sizeof(uint8_t) * len);
+  TEST_ASSERT(input != NULL);
+  for (size_t i = 0; i < len; i++) {
+    // compressible, but not trivial
+    input[i] = (uint8_t)((i * 7) ^ (i >> 9));
+  }
+}
+
+static void assert_gzfile(size_t expected_len) {
+  gzFile fp = gzopen(FILENAME, "rb");
+  TEST_ASSERT(fp != NULL);
+  output = malloc(sizeof(uint8_t) * (expected_len + 1));
+  TEST_ASSERT(output != NULL);
+  int actually_read = gzread(fp, output, expected_len + 1);
+  gzclose(fp);
+  TEST_ASSERT_EQUAL_INT(expected_len, actually_read);
+  if (expected_len > 0) {
+    TEST_ASSERT_EQUAL_MEMORY(input, output, expected_len);
+  }
+
+  // ISIZE from the trailer
+  FILE *raw = fopen(FILENAME, "rb");
+  TEST_ASSERT(raw != NULL);
+  TEST_ASSERT_EQUAL_INT(0, fseek(raw, -4, SEEK_END));
+  uint8_t buf[4];
+  TEST_ASSERT_EQUAL_INT(4, fread(buf, 1, 4, raw));
+  fclose(raw);
+  uint32_t isize = (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+  TEST_ASSERT_EQUAL_UINT32(expected_len, isize);
+}
+
+void test_multiple_blocks() {
+  size_t len = 3 * 1024 * 1024 + 123;
+  setup_input(len);
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_create(FILENAME, Z_DEFAULT_COMPRESSION, 3, NULL, &gz));
+  // odd chunks to cross block boundaries
+  size_t chunk = 100003;
+  for (size_t offset = 0; offset < len; offset += chunk) {
+    size_t to_write = (len - offset) < chunk ? (len - offset) : chunk;
+    TEST_ASSERT_EQUAL_INT(0, parallel_gzip_write(input + offset, to_write, gz));
+  }
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_destroy(gz));
+  gz = NULL;
+  assert_gzfile(len);
+}
+
+void test_single_thread() {
+  size_t len = 1000;
+  setup_input(len);
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_create(FILENAME, 1, 1, NULL, &gz));
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_write(input, len, gz));
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_destroy(gz));
+  gz = NULL;
+  assert_gzfile(len);
+}
+
+void test_empty() {
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_create(FILENAME, Z_DEFAULT_COMPRESSION, 2, NULL, &gz));
+  TEST_ASSERT_EQUAL_INT(0, parallel_gzip_destroy(gz));
+  gz = NULL;
+  assert_gzfile(0);
+}
+
+void test_invalid_arguments() {
+  TEST_ASSERT_EQUAL_INT(-1, parallel_gzip_create(FILENAME, Z_DEFAULT_COMPRESSION, 0, NULL, &gz));
+  TEST_ASSERT_EQUAL_INT(-1, parallel_gzip_create("/non-existing-directory/1.cf32.gz", Z_DEFAULT_COMPRESSION, 2, NULL, &gz));
+}
+
+void tearDown() {
+  parallel_gzip_destroy(gz);
+  gz = NULL;
+  if (input != NULL) {
+    free(input);
+    input = NULL;
+  }
+  if (output != NULL) {
+    free(output);
+    output = NULL;
+  }
+}
+
+void setUp() {
+  // do nothing
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_multiple_blocks);
+  RUN_TEST(test_single_thread);
+  RUN_TEST(test_empty);
+  RUN_TEST(test_invalid_arguments);
+  return UNITY_END();
+}
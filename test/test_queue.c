@@ -42,6 +42,11 @@ void test_put_take() {
   const uint8_t buffer2[2] = {1, 2};
   queue_put(buffer2, sizeof(buffer2), queue_obj);
 
+  queue_stats stats;
+  queue_get_stats(queue_obj, &stats);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.depth);
+  TEST_ASSERT_EQUAL_UINT64(0, stats.overflows);
+
   assert_buffer(buffer, 10);
   assert_buffer(buffer2, 2);
 }
@@ -58,6 +63,51 @@ void test_overflow() {
   assert_buffer(buffer2, 9);
 }
 
+void test_dropped() {
+  int code = create_queue(262144, 1, &queue_obj);
+  TEST_ASSERT_EQUAL_INT(code, 0);
+
+  const uint8_t buffer[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  queue_put(buffer, sizeof(buffer), queue_obj);
+  queue_put(buffer, 9, queue_obj);
+  queue_put(buffer, 8, queue_obj);
+
+  uint8_t *result = NULL;
+  size_t len = 0;
+  take_buffer_for_processing(&result, &len, queue_obj);
+  TEST_ASSERT_EQUAL_INT(8, len);
+  TEST_ASSERT_EQUAL_INT(19, get_dropped_before_buffer(queue_obj));
+  queue_stats stats;
+  queue_get_stats(queue_obj, &stats);
+  TEST_ASSERT_EQUAL_UINT64(3, stats.buffers);
+  TEST_ASSERT_EQUAL_UINT64(2, stats.overflows);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.depth);
+  complete_buffer_processing(queue_obj);
+
+  // the node is reused without drops
+  queue_put(buffer, sizeof(buffer), queue_obj);
+  take_buffer_for_processing(&result, &len, queue_obj);
+  TEST_ASSERT_EQUAL_INT(0, get_dropped_before_buffer(queue_obj));
+  complete_buffer_processing(queue_obj);
+}
+
+void test_put_after_gap() {
+  int code = create_queue(262144, 1, &queue_obj);
+  TEST_ASSERT_EQUAL_INT(code, 0);
+
+  const uint8_t buffer[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  queue_put_after_gap(buffer, sizeof(buffer), 4, queue_obj);
+  // gap before the overwritten buffer is preserved
+  queue_put_after_gap(buffer, 9, 2, queue_obj);
+
+  uint8_t *result = NULL;
+  size_t len = 0;
+  take_buffer_for_processing(&result, &len, queue_obj);
+  TEST_ASSERT_EQUAL_INT(9, len);
+  TEST_ASSERT_EQUAL_INT(4 + 10 + 2, get_dropped_before_buffer(queue_obj));
+  complete_buffer_processing(queue_obj);
+}
+
 void tearDown() {
   destroy_queue(queue_obj);
 }
@@ -70,6 +120,8 @@ int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_put_take);
   RUN_TEST(test_overflow);
+  RUN_TEST(test_dropped);
+  RUN_TEST(test_put_after_gap);
   RUN_TEST(test_terminated_only_after_fully_processed);
   return UNITY_END();
 }
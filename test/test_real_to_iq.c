@@ -0,0 +1,151 @@
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../src/real_to_iq.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// filter delay
+#define SETTLE 32
+
+real_to_iq *converter = NULL;
+int16_t *input = NULL;
+uint16_t *input_u16 = NULL;
+int16_t *expected = NULL;
+
+static void setup_tone(size_t len, double frequency) {
+  input = malloc(sizeof(int16_t) * len);
+  TEST_ASSERT(input != NULL);
+  input_u16 = malloc(sizeof(uint16_t) * len);
+  TEST_ASSERT(input_u16 != NULL);
+  for (size_t i = 0; i < len; i++) {
+    // 12 bit ADC
+    int32_t value = (int32_t) lround(1000.0 * cos(2.0 * M_PI * frequency * (double) i));
+    input[i] = (int16_t) (value * 16);
+    input_u16[i] = (uint16_t) (value + 2048);
+  }
+}
+
+// real tone at sampling_rate / 4 - offset is converted to complex tone at 2 * offset
+static void assert_tone(const int16_t *output, size_t output_len, double expected_frequency) {
+  TEST_ASSERT(output_len > SETTLE + 1);
+  for (size_t i = SETTLE; i < output_len - 1; i++) {
+    float complex current = output[2 * i] + output[2 * i + 1] * I;
+    float complex next = output[2 * (i + 1)] + output[2 * (i + 1) + 1] * I;
+    TEST_ASSERT_FLOAT_WITHIN(16000 * 0.02, 16000, cabsf(current));
+    float actual_frequency = cargf(next * conjf(current)) / (2.0f * (float) M_PI);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, expected_frequency, actual_frequency);
+  }
+}
+
+void test_positive_frequency() {
+  size_t len = 1024;
+  setup_tone(len, 0.25 - 0.03);
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(len, &converter));
+  int16_t *output = NULL;
+  size_t output_len = 0;
+  real_to_iq_process_int16(input, len, &output, &output_len, converter);
+  TEST_ASSERT_EQUAL_INT(len / 2, output_len);
+  assert_tone(output, output_len, 0.06);
+}
+
+void test_negative_frequency() {
+  size_t len = 1024;
+  setup_tone(len, 0.25 + 0.05);
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(len, &converter));
+  int16_t *output = NULL;
+  size_t output_len = 0;
+  real_to_iq_process_int16(input, len, &output, &output_len, converter);
+  assert_tone(output, output_len, -0.1);
+}
+
+void test_uint16() {
+  size_t len = 1024;
+  setup_tone(len, 0.25 - 0.03);
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(len, &converter));
+  int16_t *output = NULL;
+  size_t output_len = 0;
+  real_to_iq_process_uint16(input_u16, len, &output, &output_len, converter);
+  assert_tone(output, output_len, 0.06);
+}
+
+void test_dc_offset() {
+  size_t len = 8192;
+  setup_tone(len, 0.25 - 0.03);
+  for (size_t i = 0; i < len; i++) {
+    input[i] = (int16_t) (input[i] + 8000);
+  }
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(len, &converter));
+  int16_t *output = NULL;
+  size_t output_len = 0;
+  real_to_iq_process_int16(input, len, &output, &output_len, converter);
+  // dc blocker needs some time to converge
+  size_t settled = output_len / 2;
+  assert_tone(output + 2 * settled, output_len - settled, 0.06);
+}
+
+void test_split_input() {
+  size_t len = 1024;
+  setup_tone(len, 0.25 - 0.03);
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(len, &converter));
+  int16_t *output = NULL;
+  size_t output_len = 0;
+  real_to_iq_process_int16(input, len, &output, &output_len, converter);
+  expected = malloc(sizeof(int16_t) * 2 * output_len);
+  TEST_ASSERT(expected != NULL);
+  memcpy(expected, output, sizeof(int16_t) * 2 * output_len);
+  size_t expected_len = output_len;
+  real_to_iq_destroy(converter);
+
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(len, &converter));
+  // odd number of output samples in the first part
+  size_t first = 2 * 101;
+  real_to_iq_process_int16(input, first, &output, &output_len, converter);
+  TEST_ASSERT_EQUAL_INT(first / 2, output_len);
+  TEST_ASSERT_EQUAL_INT16_ARRAY(expected, output, 2 * output_len);
+  real_to_iq_process_int16(input + first, len - first, &output, &output_len, converter);
+  TEST_ASSERT_EQUAL_INT((len - first) / 2, output_len);
+  TEST_ASSERT_EQUAL_INT16_ARRAY(expected + first, output, 2 * output_len);
+  TEST_ASSERT_EQUAL_INT(expected_len, first / 2 + output_len);
+}
+
+void test_invalid() {
+  TEST_ASSERT(real_to_iq_create(0, &converter) < 0);
+}
+
+void tearDown() {
+  real_to_iq_destroy(converter);
+  converter = NULL;
+  if (input != NULL) {
+    free(input);
+    input = NULL;
+  }
+  if (input_u16 != NULL) {
+    free(input_u16);
+    input_u16 = NULL;
+  }
+  if (expected != NULL) {
+    free(expected);
+    expected = NULL;
+  }
+}
+
+void setUp() {
+  // do nothing
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_positive_frequency);
+  RUN_TEST(test_negative_frequency);
+  RUN_TEST(test_uint16);
+  RUN_TEST(test_dc_offset);
+  RUN_TEST(test_split_input);
+  RUN_TEST(test_invalid);
+  return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "../src/recording.h"
+
+recording *rec = NULL;
+struct server_config config;
+recording_config rec_config = {.datatype = "cf32_le", .extension = "cf32", .lane_size = sizeof(float), .sample_rate = 48000, .center_freq = 436700000};
+char *meta = NULL;
+char *paths[2];
+char first_path[] = "/tmp/sdr_recording_test_XXXXXX";
+char second_path[] = "/tmp/sdr_recording_test_XXXXXX";
+uint8_t buffer[400];
+
+static long get_file_size(const char *base_path, const char *filename) {
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s/%s", base_path, filename);
+  struct stat st;
+  if (stat(file_path, &st) != 0) {
+    return -1;
+  }
+  remove(file_path);
+  return (long) st.st_size;
+}
+
+static void read_meta(const char *base_path, const char *filename) {
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s/%s", base_path, filename);
+  FILE *fp = fopen(file_path, "rb");
+  TEST_ASSERT(fp != NULL);
+  meta = calloc(8192, sizeof(char));
+  TEST_ASSERT(meta != NULL);
+  fread(meta, sizeof(char), 8191, fp);
+  fclose(fp);
+  remove(file_path);
+}
+
+static void remove_meta(const char *base_path, const char *filename) {
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s/%s", base_path, filename);
+  TEST_ASSERT_EQUAL_INT(0, remove(file_path));
+}
+
+void test_rotation_by_size() {
+  rec_config.id = 1;
+  config.file_rotation_bytes = 1000;
+  TEST_ASSERT_EQUAL_INT(0, recording_create(&rec_config, &config, &rec));
+  struct timespec start = {1700000000, 0};
+  recording_set_start_time(&start, &start, rec);
+  for (int i = 0; i < 10; i++) {
+    TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  }
+  recording_destroy(rec);
+  rec = NULL;
+  // buffers are never split between segments
+  TEST_ASSERT_EQUAL_INT(1200, get_file_size(second_path, "1.0.cf32"));
+  TEST_ASSERT_EQUAL_INT(1200, get_file_size(first_path, "1.1.cf32"));
+  TEST_ASSERT_EQUAL_INT(1200, get_file_size(second_path, "1.2.cf32"));
+  TEST_ASSERT_EQUAL_INT(400, get_file_size(first_path, "1.3.cf32"));
+  TEST_ASSERT_EQUAL_INT(-1, get_file_size(second_path, "1.4.cf32"));
+  remove_meta(second_path, "1.0.sigmf-meta");
+  remove_meta(first_path, "1.1.sigmf-meta");
+  remove_meta(second_path, "1.2.sigmf-meta");
+  // the last segment continues the timeline: 3 segments * 1200 bytes / 8 bytes per sample / 48000
+  read_meta(first_path, "1.3.sigmf-meta");
+  TEST_ASSERT(strstr(meta, "\"core:dataset\": \"1.3.cf32\"") != NULL);
+  TEST_ASSERT(strstr(meta, "\"core:datetime\": \"2023-11-14T22:13:20.009375000Z\"") != NULL);
+}
+
+void test_rotation_by_time() {
+  rec_config.id = 2;
+  config.file_rotation_seconds = 1;
+  TEST_ASSERT_EQUAL_INT(0, recording_create(&rec_config, &config, &rec));
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  sleep(1);
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  recording_destroy(rec);
+  rec = NULL;
+  TEST_ASSERT_EQUAL_INT(800, get_file_size(first_path, "2.0.cf32"));
+  TEST_ASSERT_EQUAL_INT(400, get_file_size(second_path, "2.1.cf32"));
+  remove_meta(first_path, "2.0.sigmf-meta");
+  remove_meta(second_path, "2.1.sigmf-meta");
+}
+
+void test_gaps() {
+  rec_config.id = 4;
+  TEST_ASSERT_EQUAL_INT(0, recording_create(&rec_config, &config, &rec));
+  struct timespec start = {1700000000, 0};
+  recording_set_start_time(&start, &start, rec);
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  // 48000 samples dropped = 1 second
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 48000, rec));
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  recording_destroy(rec);
+  rec = NULL;
+  TEST_ASSERT_EQUAL_INT(1200, get_file_size(first_path, "4.cf32"));
+  read_meta(first_path, "4.sigmf-meta");
+  TEST_ASSERT(strstr(meta, "{\"core:sample_start\": 0, \"core:frequency\": 436700000, \"core:datetime\": \"2023-11-14T22:13:20.000000000Z\"") != NULL);
+  TEST_ASSERT(strstr(meta, "{\"core:sample_start\": 50, \"core:frequency\": 436700000, \"core:datetime\": \"2023-11-14T22:13:21.001041666Z\"") != NULL);
+  TEST_ASSERT(strstr(meta, "{\"core:sample_start\": 50, \"core:label\": \"gap\"") != NULL);
+  TEST_ASSERT(strstr(meta, "\"core:datatype\": \"cf32_le\"") != NULL);
+  TEST_ASSERT(strstr(meta, "\"core:sample_rate\": 48000") != NULL);
+}
+
+void test_skip() {
+  rec_config.id = 5;
+  TEST_ASSERT_EQUAL_INT(0, recording_create(&rec_config, &config, &rec));
+  struct timespec start = {1700000000, 0};
+  recording_set_start_time(&start, &start, rec);
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  TEST_ASSERT_EQUAL_INT(0, recording_skip(48000, rec));
+  TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  recording_destroy(rec);
+  rec = NULL;
+  TEST_ASSERT_EQUAL_INT(800, get_file_size(second_path, "5.cf32"));
+  read_meta(second_path, "5.sigmf-meta");
+  TEST_ASSERT(strstr(meta, "{\"core:sample_start\": 50, \"core:frequency\": 436700000, \"core:datetime\": \"2023-11-14T22:13:21.001041666Z\"") != NULL);
+  // skipped samples are not a gap
+  TEST_ASSERT(strstr(meta, "\"gap\"") == NULL);
+}
+
+void test_no_rotation() {
+  rec_config.id = 3;
+  TEST_ASSERT_EQUAL_INT(0, recording_create(&rec_config, &config, &rec));
+  for (int i = 0; i < 10; i++) {
+    TEST_ASSERT_EQUAL_INT(0, recording_write(buffer, sizeof(buffer), 0, rec));
+  }
+  recording_destroy(rec);
+  rec = NULL;
+  TEST_ASSERT_EQUAL_INT(4000, get_file_size(second_path, "3.cf32"));
+  remove_meta(second_path, "3.sigmf-meta");
+}
+
+void test_invalid_path() {
+  rec_config.id = 0;
+  paths[0] = "/non-existing-directory";
+  TEST_ASSERT(recording_create(&rec_config, &config, &rec) != 0);
+}
+
+void test_too_long_path() {
+  rec_config.id = 0;
+  // fits into the path buffer only without the file name
+  char long_path[4094];
+  memset(long_path, 'a', sizeof(long_path) - 1);
+  long_path[sizeof(long_path) - 1] = '\0';
+  paths[0] = long_path;
+  TEST_ASSERT_EQUAL_INT(-1, recording_create(&rec_config, &config, &rec));
+}
+
+void tearDown() {
+  recording_destroy(rec);
+  rec = NULL;
+  if (meta != NULL) {
+    free(meta);
+    meta = NULL;
+  }
+  rmdir(first_path);
+  rmdir(second_path);
+}
+
+void setUp() {
+  strcpy(first_path, "/tmp/sdr_recording_test_XXXXXX");
+  strcpy(second_path, "/tmp/sdr_recording_test_XXXXXX");
+  TEST_ASSERT(mkdtemp(first_path) != NULL);
+  TEST_ASSERT(mkdtemp(second_path) != NULL);
+  paths[0] = first_path;
+  paths[1] = second_path;
+  config = (struct server_config) {0};
+  config.base_path = paths[0];
+  config.base_paths = paths;
+  config.base_paths_len = 2;
+  config.compression = COMPRESSION_NONE;
+  memset(buffer, 0, sizeof(buffer));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rotation_by_size);
+  RUN_TEST(test_rotation_by_time);
+  RUN_TEST(test_no_rotation);
+  RUN_TEST(test_gaps);
+  RUN_TEST(test_skip);
+  RUN_TEST(test_invalid_path);
+  RUN_TEST(test_too_long_path);
+  return UNITY_END();
+}
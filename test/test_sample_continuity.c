@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "../src/sample_continuity.h"
+
+// 1000 samples/sec, cu8 samples, 2 buffers in flight
+#define SAMPLING_RATE 1000
+#define BUFFER_SIZE 200
+#define TOLERANCE 200
+
+sample_continuity *continuity = NULL;
+
+static struct timespec at_millis(uint64_t millis) {
+  struct timespec result = {.tv_sec = 1000 + millis / 1000, .tv_nsec = (long) (millis % 1000) * 1000000L};
+  return result;
+}
+
+static void start() {
+  TEST_ASSERT_EQUAL_INT(0, sample_continuity_create(SAMPLING_RATE, 2, BUFFER_SIZE, TOLERANCE, &continuity));
+  struct timespec now = at_millis(0);
+  sample_continuity_start(&now, continuity);
+}
+
+static void update(uint32_t len, uint64_t dropped, uint64_t millis, uint64_t expected_index, uint64_t expected_lost) {
+  struct timespec now = at_millis(millis);
+  sdr_buffer_info info;
+  sample_continuity_update(len, dropped, &now, &info, continuity);
+  TEST_ASSERT_EQUAL_INT(expected_index, info.sample_index);
+  TEST_ASSERT_EQUAL_INT(expected_lost, info.lost_samples);
+  TEST_ASSERT_EQUAL_INT(now.tv_sec, info.received.tv_sec);
+}
+
+void test_continuous() {
+  start();
+  // usb delivers buffers with some jitter
+  update(BUFFER_SIZE, 0, 100, 0, 0);
+  update(BUFFER_SIZE, 0, 350, 100, 0);
+  update(BUFFER_SIZE, 0, 360, 200, 0);
+  update(BUFFER_SIZE / 2, 0, 400, 300, 0);
+
+  sdr_device_stats stats;
+  struct timespec now = at_millis(350);
+  sample_continuity_get_stats(&now, &stats, continuity);
+  TEST_ASSERT_EQUAL_INT(4, stats.buffers);
+  TEST_ASSERT_EQUAL_INT(3 * BUFFER_SIZE + BUFFER_SIZE / 2, stats.bytes);
+  TEST_ASSERT_EQUAL_INT(1, stats.short_buffers);
+  TEST_ASSERT_EQUAL_INT(350, stats.samples);
+  TEST_ASSERT_EQUAL_INT(0, stats.lost_samples);
+  TEST_ASSERT_EQUAL_INT(0, stats.gaps);
+  TEST_ASSERT_EQUAL_INT(SAMPLING_RATE, stats.observed_sampling_rate);
+}
+
+void test_dropped_by_driver() {
+  start();
+  update(BUFFER_SIZE, 0, 100, 0, 0);
+  update(BUFFER_SIZE, 50, 250, 150, 50);
+  update(BUFFER_SIZE, 0, 350, 250, 0);
+
+  sdr_device_stats stats;
+  struct timespec now = at_millis(350);
+  sample_continuity_get_stats(&now, &stats, continuity);
+  TEST_ASSERT_EQUAL_INT(50, stats.dropped_samples);
+  TEST_ASSERT_EQUAL_INT(0, stats.lost_samples);
+  TEST_ASSERT_EQUAL_INT(1, stats.gaps);
+}
+
+void test_usb_overrun() {
+  start();
+  update(BUFFER_SIZE, 0, 100, 0, 0);
+  // 1 second stall. expected 1100 samples, but only 200 received. 200 are in flight
+  // might be a slow crystal, so not a gap
+  update(BUFFER_SIZE, 0, 1100, 100, 0);
+  // the deficit is counted only once
+  update(BUFFER_SIZE, 0, 1100, 200, 0);
+
+  sdr_device_stats stats;
+  struct timespec now = at_millis(2000);
+  sample_continuity_stop(&now, continuity);
+  now = at_millis(5000);
+  sample_continuity_get_stats(&now, &stats, continuity);
+  TEST_ASSERT_EQUAL_INT(700, stats.lost_samples);
+  TEST_ASSERT_EQUAL_INT(0, stats.gaps);
+  // stopped device doesn't receive anything
+  TEST_ASSERT_EQUAL_INT(150, stats.observed_sampling_rate);
+}
+
+void test_setup_time_is_not_lost() {
+  start();
+  // device open, tuning and usb setup took 5 seconds
+  update(BUFFER_SIZE, 0, 5100, 0, 0);
+  update(BUFFER_SIZE, 0, 5200, 100, 0);
+
+  sdr_device_stats stats;
+  struct timespec now = at_millis(5200);
+  sample_continuity_get_stats(&now, &stats, continuity);
+  TEST_ASSERT_EQUAL_INT(0, stats.lost_samples);
+  TEST_ASSERT_EQUAL_INT(SAMPLING_RATE, stats.observed_sampling_rate);
+}
+
+void test_invalid() {
+  TEST_ASSERT(sample_continuity_create(0, 2, BUFFER_SIZE, TOLERANCE, &continuity) < 0);
+}
+
+void tearDown() {
+  sample_continuity_destroy(continuity);
+  continuity = NULL;
+}
+
+void setUp() {
+  // do nothing
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_continuous);
+  RUN_TEST(test_dropped_by_driver);
+  RUN_TEST(test_usb_overrun);
+  RUN_TEST(test_setup_time_is_not_lost);
+  RUN_TEST(test_invalid);
+  return UNITY_END();
+}
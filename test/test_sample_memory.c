@@ -0,0 +1,98 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+
+#include "../src/queue.h"
+#include "../src/sample_memory.h"
+
+#define LARGE_BUFFER (4 * 1024 * 1024 + 3)
+
+queue *queue_obj = NULL;
+
+static void assert_usable(size_t size) {
+  uint8_t *buffer = sample_memory_alloc(size);
+  TEST_ASSERT(buffer != NULL);
+  TEST_ASSERT_EQUAL_INT(0, ((uintptr_t) buffer) % 64);
+  memset(buffer, 1, size);
+  TEST_ASSERT_EQUAL_UINT8(1, buffer[0]);
+  TEST_ASSERT_EQUAL_UINT8(1, buffer[size - 1]);
+  sample_memory_free(buffer);
+}
+
+void test_heap() {
+  assert_usable(1);
+  assert_usable(LARGE_BUFFER);
+}
+
+void test_hugepages_prefault() {
+  sample_memory_configure(true, true, false);
+  assert_usable(1);
+  assert_usable(LARGE_BUFFER);
+  uint8_t *buffer = sample_memory_alloc(LARGE_BUFFER);
+  TEST_ASSERT(buffer != NULL);
+  // prefaulted memory is zeroed the same way as mmap
+  TEST_ASSERT_EQUAL_UINT8(0, buffer[LARGE_BUFFER - 1]);
+  sample_memory_free(buffer);
+}
+
+void test_hugepage_alignment() {
+  sample_memory_configure(true, false, false);
+  // xlating buffers are 1-2MB. Hugepage is used only for the aligned ranges
+  size_t size = 3 * 1024 * 1024 / 2;
+  uint8_t *buffer = sample_memory_alloc(size);
+  TEST_ASSERT(buffer != NULL);
+  TEST_ASSERT_EQUAL_INT(0, ((uintptr_t) buffer) % (2 * 1024 * 1024));
+  memset(buffer, 1, size);
+  sample_memory_free(buffer);
+}
+
+void test_lock() {
+  // mlock might fail because of RLIMIT_MEMLOCK. Memory should be allocated anyway
+  sample_memory_configure(false, false, true);
+  assert_usable(LARGE_BUFFER);
+}
+
+void test_queue() {
+  sample_memory_configure(true, true, false);
+  TEST_ASSERT_EQUAL_INT(0, create_queue(262144, 4, &queue_obj));
+  uint8_t input[262144];
+  memset(input, 2, sizeof(input));
+  // overflow the queue so that every node is used
+  for (int i = 0; i < 6; i++) {
+    queue_put(input, sizeof(input), queue_obj);
+  }
+  uint8_t *buffer = NULL;
+  size_t len = 0;
+  take_buffer_for_processing(&buffer, &len, queue_obj);
+  TEST_ASSERT(buffer != NULL);
+  TEST_ASSERT_EQUAL_INT(sizeof(input), len);
+  TEST_ASSERT_EQUAL_MEMORY(input, buffer, len);
+  // destroy with the detached node
+}
+
+void test_free_null() {
+  sample_memory_free(NULL);
+}
+
+void setUp() {
+  sample_memory_configure(false, false, false);
+}
+
+void tearDown() {
+  if (queue_obj != NULL) {
+    destroy_queue(queue_obj);
+    queue_obj = NULL;
+  }
+  sample_memory_configure(false, false, false);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_heap);
+  RUN_TEST(test_hugepages_prefault);
+  RUN_TEST(test_hugepage_alignment);
+  RUN_TEST(test_lock);
+  RUN_TEST(test_queue);
+  RUN_TEST(test_free_null);
+  return UNITY_END();
+}
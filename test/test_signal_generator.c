@@ -0,0 +1,104 @@
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "../src/signal_generator.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+signal_generator *generator = NULL;
+
+static void assert_tone(const int16_t *output, size_t len, float expected_amplitude, float expected_frequency) {
+  for (size_t i = 0; i < len - 1; i++) {
+    float complex current = output[2 * i] + output[2 * i + 1] * I;
+    float complex next = output[2 * (i + 1)] + output[2 * (i + 1) + 1] * I;
+    TEST_ASSERT_FLOAT_WITHIN(expected_amplitude * 0.01f, expected_amplitude, cabsf(current));
+    float actual_frequency = cargf(next * conjf(current)) / (2.0f * (float)M_PI);
+    TEST_ASSERT_FLOAT_WITHIN(0.0005, expected_frequency, actual_frequency);
+  }
+}
+
+void test_tone() {
+  int32_t tones[] = {1200};
+  size_t len = 1000;
+  TEST_ASSERT_EQUAL_INT(0, signal_generator_create(48000, tones, 1, 0.5f, 0.0f, 0, 0, len, &generator));
+  uint8_t *output = NULL;
+  signal_generator_next(SAMPLE_FORMAT_CS16, len, &output, generator);
+  assert_tone((const int16_t *)output, len, 0.5f * INT16_MAX, 1200.0f / 48000);
+  // phase is continuous between the calls
+  int16_t last[2] = {((int16_t *)output)[2 * (len - 1)], ((int16_t *)output)[2 * (len - 1) + 1]};
+  signal_generator_next(SAMPLE_FORMAT_CS16, len, &output, generator);
+  int16_t joined[4] = {last[0], last[1], ((int16_t *)output)[0], ((int16_t *)output)[1]};
+  assert_tone(joined, 2, 0.5f * INT16_MAX, 1200.0f / 48000);
+  assert_tone((const int16_t *)output, len, 0.5f * INT16_MAX, 1200.0f / 48000);
+}
+
+void test_negative_tone() {
+  int32_t tones[] = {-3000};
+  size_t len = 200;
+  TEST_ASSERT_EQUAL_INT(0, signal_generator_create(48000, tones, 1, 0.9f, 0.0f, 0, 0, len, &generator));
+  uint8_t *output = NULL;
+  signal_generator_next(SAMPLE_FORMAT_CS16, len, &output, generator);
+  assert_tone((const int16_t *)output, len, 0.9f * INT16_MAX, -3000.0f / 48000);
+}
+
+void test_bursts() {
+  int32_t tones[] = {1000};
+  size_t len = 1000;
+  // 100 samples on, 100 samples off
+  TEST_ASSERT_EQUAL_INT(0, signal_generator_create(10000, tones, 1, 1.0f, 0.0f, 10, 20, len, &generator));
+  uint8_t *output = NULL;
+  signal_generator_next(SAMPLE_FORMAT_CS8, len, &output, generator);
+  int8_t *samples = (int8_t *)output;
+  for (size_t i = 0; i < len; i++) {
+    float magnitude = sqrtf((float)(samples[2 * i] * samples[2 * i] + samples[2 * i + 1] * samples[2 * i + 1]));
+    if (i % 200 < 100) {
+      TEST_ASSERT_FLOAT_WITHIN(2.0f, INT8_MAX, magnitude);
+    } else {
+      TEST_ASSERT_EQUAL_FLOAT(0.0f, magnitude);
+    }
+  }
+}
+
+void test_noise() {
+  size_t len = 100000;
+  TEST_ASSERT_EQUAL_INT(0, signal_generator_create(48000, NULL, 0, 0.0f, 0.1f, 0, 0, len, &generator));
+  uint8_t *output = NULL;
+  signal_generator_next(SAMPLE_FORMAT_CU8, len, &output, generator);
+  double sum = 0.0;
+  double power = 0.0;
+  for (size_t i = 0; i < 2 * len; i++) {
+    double value = ((double)output[i] - 127.5) / 127.5;
+    sum += value;
+    power += value * value;
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 0.0, sum / (2 * len));
+  TEST_ASSERT_FLOAT_WITHIN(0.005, 0.1, sqrt(power / (2 * len)));
+}
+
+void test_invalid() {
+  TEST_ASSERT(signal_generator_create(0, NULL, 0, 0.0f, 0.1f, 0, 0, 100, &generator) < 0);
+  TEST_ASSERT(signal_generator_create(48000, NULL, 0, 0.0f, 0.1f, 20, 10, 100, &generator) < 0);
+}
+
+void tearDown() {
+  signal_generator_destroy(generator);
+  generator = NULL;
+}
+
+void setUp() {
+  // do nothing
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_tone);
+  RUN_TEST(test_negative_tone);
+  RUN_TEST(test_bursts);
+  RUN_TEST(test_noise);
+  RUN_TEST(test_invalid);
+  return UNITY_END();
+}
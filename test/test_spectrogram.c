@@ -4,6 +4,8 @@
 #include <iq_file.h>
 #include "utils.h"
 #include <spectrogram.h>
+#include "../src/file_output.h"
+#include "../src/gzip_index.h"
 
 static char test_dir[PATH_MAX];
 char input_file[PATH_MAX];
@@ -60,6 +62,133 @@ void test_gzipped_file() {
   assert_png("spectrogram_cf32_odd.png", output_file);
 }
 
+static void setup_indexed_gzfile(const char *filename, size_t len, uint32_t interval) {
+  gzFile fp = gzopen(filename, "wb");
+  TEST_ASSERT(fp != NULL);
+  gzip_index *index = NULL;
+  TEST_ASSERT_EQUAL_INT(0, gzip_index_create(filename, interval, &index));
+  float *buffer = NULL;
+  setup_input_cf32(&buffer, 0, 2 * len);
+  size_t total = 0;
+  size_t bytes_to_write = sizeof(float) * 2 * len;
+  while (total < bytes_to_write) {
+    if (gzip_index_is_due(total, index)) {
+      TEST_ASSERT_EQUAL_INT(Z_OK, gzflush(fp, Z_FULL_FLUSH));
+      TEST_ASSERT_EQUAL_INT(0, gzip_index_add(total, gzoffset(fp), index));
+    }
+    // odd chunks so that seek points are not aligned with samples
+    size_t to_write = bytes_to_write - total < 99 ? bytes_to_write - total : 99;
+    TEST_ASSERT_EQUAL_INT(to_write, gzwrite(fp, (uint8_t *) buffer + total, to_write));
+    total += to_write;
+  }
+  free(buffer);
+  TEST_ASSERT_EQUAL_INT(Z_OK, gzclose(fp));
+  TEST_ASSERT_EQUAL_INT(0, gzip_index_finish(total, index));
+  gzip_index_destroy(index);
+}
+
+void test_indexed_gzipped_file() {
+  strcat(input_file, ".gz");
+  setup_indexed_gzfile(input_file, 256, 300);
+  spec.data_format = "cf32";
+  TEST_ASSERT_EQUAL_INT(0, spectrogram_main(&spec));
+  assert_png("spectrogram_cf32.png", output_file);
+
+  // test odd with skip on every row
+  spec.width = 63;
+  TEST_ASSERT_EQUAL_INT(0, spectrogram_main(&spec));
+  assert_png("spectrogram_cf32_odd.png", output_file);
+
+  char index_file[PATH_MAX];
+  snprintf(index_file, sizeof(index_file), "%s%s", input_file, GZIP_INDEX_EXTENSION);
+  remove(index_file);
+}
+
+// written the same way as sdr-server writes the files
+static void setup_compressed_file(size_t len, file_compression compression, compression_filter filter, float **samples) {
+  struct server_config config = {0};
+  config.compression = compression;
+  config.compression_filter = filter;
+  config.gzip_threads = 1;
+  file_output *output = NULL;
+  TEST_ASSERT_EQUAL_INT(0, file_output_create(input_file, sizeof(float), &config, &output));
+  strcat(input_file, file_output_get_extension(compression));
+  setup_input_cf32(samples, 0, 2 * len);
+  size_t bytes_to_write = sizeof(float) * 2 * len;
+  // odd chunks so that writes are not aligned with the filter blocks
+  size_t chunk = 10007;
+  for (size_t offset = 0; offset < bytes_to_write; offset += chunk) {
+    size_t to_write = (bytes_to_write - offset) < chunk ? (bytes_to_write - offset) : chunk;
+    TEST_ASSERT_EQUAL_INT(0, file_output_write((uint8_t *) *samples + offset, to_write, output));
+  }
+  file_output_destroy(output);
+}
+
+static void assert_compressed_spectrogram(file_compression compression, compression_filter filter) {
+  float *samples = NULL;
+  setup_compressed_file(256, compression, filter, &samples);
+  free(samples);
+  spec.data_format = "cf32";
+  TEST_ASSERT_EQUAL_INT(0, spectrogram_main(&spec));
+  assert_png("spectrogram_cf32.png", output_file);
+
+  // test odd with skip on every row
+  spec.width = 63;
+  TEST_ASSERT_EQUAL_INT(0, spectrogram_main(&spec));
+  assert_png("spectrogram_cf32_odd.png", output_file);
+}
+
+// several filter blocks and the last one is partial
+static void assert_compressed_rows(file_compression compression, compression_filter filter) {
+  size_t len = 3 * SAMPLE_FILTER_BLOCK_SIZE / sizeof(fftwf_complex) + 123;
+  float *samples = NULL;
+  setup_compressed_file(len, compression, filter, &samples);
+  uint32_t width = 1000;
+  iq_file *file = NULL;
+  TEST_ASSERT_EQUAL_INT(0, iq_file_create(input_file, width, "cf32", &file));
+  uint32_t total = 0;
+  iq_file_get_samples(&total, file);
+  TEST_ASSERT_EQUAL_UINT32(len, total);
+  fftwf_complex *row = malloc(sizeof(fftwf_complex) * width);
+  TEST_ASSERT(row != NULL);
+  // skip crosses the block boundaries
+  uint32_t skip = 7777;
+  size_t position = 0;
+  while (position + width <= len) {
+    TEST_ASSERT_EQUAL_INT(0, iq_file_read(row, file));
+    TEST_ASSERT_EQUAL_MEMORY(samples + 2 * position, row, sizeof(fftwf_complex) * width);
+    position += width;
+    if (position + skip + width > len) {
+      break;
+    }
+    iq_file_skip(skip, file);
+    position += skip;
+  }
+  // the last partial row is not available
+  if (position + width > len) {
+    TEST_ASSERT(iq_file_read(row, file) != 0);
+  }
+  free(row);
+  iq_file_destroy(file);
+  free(samples);
+}
+
+void test_zstd_file() {
+  assert_compressed_spectrogram(COMPRESSION_ZSTD, COMPRESSION_FILTER_SHUFFLE);
+}
+
+void test_lz4_file() {
+  assert_compressed_spectrogram(COMPRESSION_LZ4, COMPRESSION_FILTER_DELTA);
+}
+
+void test_zstd_rows() {
+  assert_compressed_rows(COMPRESSION_ZSTD, COMPRESSION_FILTER_SHUFFLE);
+}
+
+void test_lz4_rows() {
+  assert_compressed_rows(COMPRESSION_LZ4, COMPRESSION_FILTER_NONE);
+}
+
 void test_invalid_arguments() {
   spec.input_file = NULL;
   TEST_ASSERT_FALSE(0 == spectrogram_main(&spec));
@@ -120,6 +249,11 @@ int main(void) {
   UNITY_BEGIN();
   RUN_TEST(test_plain_file);
   RUN_TEST(test_gzipped_file);
+  RUN_TEST(test_indexed_gzipped_file);
+  RUN_TEST(test_zstd_file);
+  RUN_TEST(test_lz4_file);
+  RUN_TEST(test_zstd_rows);
+  RUN_TEST(test_lz4_rows);
   RUN_TEST(test_invalid_arguments);
   return UNITY_END();
 }
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <unity.h>
+
+#include "../src/squelch.h"
+
+squelch *sq = NULL;
+float complex *input = NULL;
+uint64_t offsets[10];
+size_t lengths[10];
+size_t segments = 0;
+
+static int collect(const float complex *output, size_t output_len, uint64_t sample_offset, void *ctx) {
+  (void) ctx;
+  TEST_ASSERT(segments < 10);
+  // first sample of the output should be the input sample at the offset
+  TEST_ASSERT_EQUAL_FLOAT(crealf(input[sample_offset]), crealf(output[0]));
+  offsets[segments] = sample_offset;
+  lengths[segments] = output_len;
+  segments++;
+  return 0;
+}
+
+static int fail(const float complex *output, size_t output_len, uint64_t sample_offset, void *ctx) {
+  (void) output;
+  (void) output_len;
+  (void) sample_offset;
+  (void) ctx;
+  return -1;
+}
+
+// noise, then signal, then noise
+static void setup_input(size_t len, size_t signal_start, size_t signal_len) {
+  input = malloc(sizeof(float complex) * len);
+  TEST_ASSERT(input != NULL);
+  for (size_t i = 0; i < len; i++) {
+    // unique real part to check offsets
+    float value = 0.01f + 0.00001f * (float) i;
+    if (i >= signal_start && i < signal_start + signal_len) {
+      value = 1.0f + 0.00001f * (float) i;
+    }
+    input[i] = value + 0.0f * I;
+  }
+}
+
+void test_signal_with_preroll_and_hang() {
+  // window = 10 samples
+  TEST_ASSERT_EQUAL_INT(0, squelch_create(1000, 10, 20, 10, &sq));
+  setup_input(300, 100, 30);
+  TEST_ASSERT_EQUAL_INT(0, squelch_process(input, 300, collect, NULL, sq));
+  TEST_ASSERT_EQUAL_size_t(2, segments);
+  TEST_ASSERT_EQUAL_UINT64(90, offsets[0]);
+  TEST_ASSERT_EQUAL_size_t(10, lengths[0]);
+  // 3 windows of signal + 2 windows of hang
+  TEST_ASSERT_EQUAL_UINT64(100, offsets[1]);
+  TEST_ASSERT_EQUAL_size_t(50, lengths[1]);
+}
+
+void test_signal_across_buffers() {
+  TEST_ASSERT_EQUAL_INT(0, squelch_create(1000, 10, 0, 0, &sq));
+  setup_input(300, 100, 100);
+  TEST_ASSERT_EQUAL_INT(0, squelch_process(input, 150, collect, NULL, sq));
+  TEST_ASSERT_EQUAL_INT(0, squelch_process(input + 150, 150, collect, NULL, sq));
+  TEST_ASSERT_EQUAL_size_t(2, segments);
+  TEST_ASSERT_EQUAL_UINT64(100, offsets[0]);
+  TEST_ASSERT_EQUAL_size_t(50, lengths[0]);
+  TEST_ASSERT_EQUAL_UINT64(150, offsets[1]);
+  TEST_ASSERT_EQUAL_size_t(50, lengths[1]);
+}
+
+void test_noise_only() {
+  TEST_ASSERT_EQUAL_INT(0, squelch_create(1000, 10, 20, 10, &sq));
+  setup_input(300, 0, 0);
+  TEST_ASSERT_EQUAL_INT(0, squelch_process(input, 300, collect, NULL, sq));
+  TEST_ASSERT_EQUAL_size_t(0, segments);
+}
+
+void test_callback_failure() {
+  TEST_ASSERT_EQUAL_INT(0, squelch_create(1000, 10, 20, 10, &sq));
+  setup_input(300, 100, 30);
+  TEST_ASSERT_EQUAL_INT(-1, squelch_process(input, 300, fail, NULL, sq));
+}
+
+void test_invalid_sample_rate() {
+  TEST_ASSERT_EQUAL_INT(-1, squelch_create(0, 10, 20, 10, &sq));
+}
+
+void tearDown() {
+  squelch_destroy(sq);
+  sq = NULL;
+  if (input != NULL) {
+    free(input);
+    input = NULL;
+  }
+  segments = 0;
+}
+
+void setUp() {
+  // do nothing
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_signal_with_preroll_and_hang);
+  RUN_TEST(test_signal_across_buffers);
+  RUN_TEST(test_noise_only);
+  RUN_TEST(test_callback_failure);
+  RUN_TEST(test_invalid_sample_rate);
+  return UNITY_END();
+}
@@ -1,8 +1,14 @@
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <unity.h>
+#include <zlib.h>
 
 #include "../src/client/tcp_client.h"
+#include "../src/real_to_iq.h"
+#include "../src/signal_generator.h"
 #include "../src/tcp_server.h"
+#include "../src/thread_scheduling.h"
 #include "airspy_lib_mock.h"
 #include "hackrf_lib_mock.h"
 #include "rtlsdr_lib_mock.h"
@@ -219,6 +225,39 @@ void test_airspy() {
   assert_gzfile(config, 1, expected, sizeof(expected) / sizeof(float) / 2);
 }
 
+void test_airspy_real() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_AIRSPY;
+  config->airspy_sample_type = AIRSPY_SAMPLES_INT16_REAL;
+  config->band_sampling_rate = 48000;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+
+  int length = 200;
+  setup_input_cs16(&input_cs16, 0, length);
+  airspy_setup_mock_data(input_cs16, length);
+  airspy_wait_for_data_read();
+
+  // real samples are converted into iq at half of the rate
+  real_to_iq *converter = NULL;
+  TEST_ASSERT_EQUAL_INT(0, real_to_iq_create(length, &converter));
+  int16_t *expected = NULL;
+  size_t expected_len = 0;
+  real_to_iq_process_int16(input_cs16, length, &expected, &expected_len, converter);
+  TEST_ASSERT_EQUAL_INT(length / 2, expected_len);
+
+  int16_t *actual = malloc(sizeof(int16_t) * 2 * expected_len);
+  TEST_ASSERT(actual != NULL);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, sizeof(int16_t) * 2 * expected_len, client0));
+  TEST_ASSERT_EQUAL_INT16_ARRAY(expected, actual, 2 * expected_len);
+  free(actual);
+  real_to_iq_destroy(converter);
+  airspy_stop_mock();
+}
+
 void test_hackrf() {
   TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
   config->sdr_type = SDR_TYPE_HACKRF;
@@ -247,6 +286,337 @@ void test_hackrf() {
   server = NULL;
 }
 
+void test_passthrough() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_RTL;
+  config->band_sampling_rate = 48000;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  // raw samples can't be shifted or decimated
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 9600, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INVALID_REQUEST);
+  reconnect_client();
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 1);
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client1));
+  send_message(client1, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_FILE_RAW);
+  assert_response(client1, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 2);
+
+  int length = 200;
+  setup_input_cu8(&input, 0, length);
+  rtlsdr_setup_mock_data(input, length);
+  rtlsdr_wait_for_data_read();
+
+  uint8_t *actual = malloc(length);
+  TEST_ASSERT(actual != NULL);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, length, client0));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(input, actual, length);
+  free(actual);
+
+  rtlsdr_stop_mock();
+  stop_tcp_server(server);
+  join_tcp_server_thread(server);
+  server = NULL;
+
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s/%d.cu8", config->base_path, 2);
+  FILE *f = fopen(file_path, "rb");
+  TEST_ASSERT(f != NULL);
+  uint8_t *file_data = malloc(length);
+  TEST_ASSERT(file_data != NULL);
+  TEST_ASSERT_EQUAL_INT(length, fread(file_data, 1, length, f));
+  fclose(f);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(input, file_data, length);
+  free(file_data);
+}
+
+void test_file_replay() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_FILE;
+  config->band_sampling_rate = 48000;
+  config->replay_format = SAMPLE_FORMAT_CS8;
+  config->replay_realtime = false;
+  char file_path[4096];
+  snprintf(file_path, sizeof(file_path), "%s/replay.cs8", config->base_path);
+  config->replay_file = strdup(file_path);
+  TEST_ASSERT(config->replay_file != NULL);
+
+  int length = 200;
+  setup_input_cs8(&input_cs8, 0, length);
+  FILE *f = fopen(file_path, "wb");
+  TEST_ASSERT(f != NULL);
+  TEST_ASSERT_EQUAL_INT(length, fwrite(input_cs8, 1, length, f));
+  fclose(f);
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+
+  int8_t *actual = malloc(length);
+  TEST_ASSERT(actual != NULL);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, length, client0));
+  TEST_ASSERT_EQUAL_INT8_ARRAY(input_cs8, actual, length);
+  free(actual);
+  unlink(file_path);
+}
+
+void test_generator() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_GENERATOR;
+  config->band_sampling_rate = 48000;
+  config->generator_format = SAMPLE_FORMAT_CS16;
+  config->generator_realtime = false;
+  config->generator_tones = malloc(sizeof(int32_t));
+  TEST_ASSERT(config->generator_tones != NULL);
+  config->generator_tones[0] = 1200;
+  config->generator_tones_len = 1;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+
+  size_t samples = 100;
+  signal_generator *expected_generator = NULL;
+  TEST_ASSERT_EQUAL_INT(0, signal_generator_create(config->band_sampling_rate, config->generator_tones, config->generator_tones_len, config->generator_tone_amplitude, config->generator_noise_amplitude, config->generator_burst_ms, config->generator_burst_period_ms, samples, &expected_generator));
+  uint8_t *expected = NULL;
+  signal_generator_next(SAMPLE_FORMAT_CS16, samples, &expected, expected_generator);
+
+  int16_t *actual = malloc(sizeof(int16_t) * 2 * samples);
+  TEST_ASSERT(actual != NULL);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, sizeof(int16_t) * 2 * samples, client0));
+  TEST_ASSERT_EQUAL_INT16_ARRAY((int16_t *)expected, actual, 2 * samples);
+  free(actual);
+  signal_generator_destroy(expected_generator);
+}
+
+void test_stage_stats() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_GENERATOR;
+  config->band_sampling_rate = 48000;
+  config->generator_realtime = false;
+  config->stage_stats = true;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+  uint8_t actual[200];
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, sizeof(actual), client0));
+
+  // histograms are updated after the buffer was written
+  dsp_worker_stats stats = {0};
+  for (int i = 0; i < 100 && stats.buffers == 0; i++) {
+    TEST_ASSERT_EQUAL_INT(0, tcp_server_get_client_stats(server, 0, &stats));
+    usleep(10000);
+  }
+  TEST_ASSERT(stats.buffers > 0);
+  TEST_ASSERT(stats.stage_max_nanos[DSP_STAGE_QUEUE_PUT] > 0);
+  TEST_ASSERT(stats.stage_max_nanos[DSP_STAGE_WRITE] > 0);
+  TEST_ASSERT(stats.stage_p99_nanos[DSP_STAGE_WRITE] >= stats.stage_p50_nanos[DSP_STAGE_WRITE]);
+  sdr_device_stats device_stats;
+  tcp_server_get_device_stats(server, &device_stats);
+  TEST_ASSERT(device_stats.callback_max_nanos > 0);
+}
+
+void test_stats() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_GENERATOR;
+  config->band_sampling_rate = 48000;
+  config->generator_realtime = false;
+#ifdef __linux__
+  // the lowest cpu allowed for the process
+  uint64_t cpus = thread_scheduling_get_cpus();
+  config->device_cpus = cpus & (~cpus + 1);
+  config->dsp_cpus = config->device_cpus;
+#endif
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+  uint8_t actual[200];
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, sizeof(actual), client0));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client1));
+  TEST_ASSERT_EQUAL_INT(0, send_stats_message(client1));
+  assert_response(client1, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 1);
+  struct stats_device device;
+  struct stats_client *clients = NULL;
+  TEST_ASSERT_EQUAL_INT(0, read_stats(1, &device, &clients, client1));
+  TEST_ASSERT(device.buffers > 0);
+  TEST_ASSERT(device.samples > 0);
+  TEST_ASSERT_EQUAL_INT(0, device.lost_samples);
+  TEST_ASSERT_EQUAL_INT(0, clients[0].id);
+  TEST_ASSERT_EQUAL_INT(460100200, clients[0].center_freq);
+  TEST_ASSERT_EQUAL_INT(48000, clients[0].sampling_rate);
+  TEST_ASSERT_EQUAL_INT(460100200, clients[0].band_freq);
+  TEST_ASSERT_EQUAL_INT(REQUEST_DESTINATION_SOCKET_RAW, clients[0].destination);
+  TEST_ASSERT_EQUAL_INT(STATS_KERNEL_NONE, clients[0].kernel);
+#ifdef __linux__
+  TEST_ASSERT_EQUAL_UINT64(config->device_cpus, device.thread_cpus);
+  TEST_ASSERT_EQUAL_UINT64(config->dsp_cpus, clients[0].thread_cpus);
+#endif
+  free(clients);
+}
+
+void test_memory_budget() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  // 64 buffers of 131072 bytes take 8Mb
+  config->memory_budget_mb = 10;
+  config->min_queue_size = 2;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+  // the rest of the budget
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client1));
+  send_message(client1, PROTOCOL_VERSION, TYPE_REQUEST, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET);
+  assert_response(client1, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 1);
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client2));
+  send_message(client2, PROTOCOL_VERSION, TYPE_REQUEST, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET);
+  assert_response(client2, TYPE_RESPONSE, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_OUT_OF_MEMORY);
+  destroy_client(client2);
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client2));
+  TEST_ASSERT_EQUAL_INT(0, send_stats_message(client2));
+  assert_response(client2, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 2);
+  struct stats_device device;
+  struct stats_client *clients = NULL;
+  TEST_ASSERT_EQUAL_INT(0, read_stats(2, &device, &clients, client2));
+  TEST_ASSERT_EQUAL_INT(config->queue_size, clients[0].queue_size);
+  TEST_ASSERT(clients[1].queue_size >= 2);
+  TEST_ASSERT(clients[1].queue_size < config->queue_size);
+  TEST_ASSERT(clients[0].memory_bytes + clients[1].memory_bytes <= 10 * 1024 * 1024);
+  TEST_ASSERT(clients[0].memory_bytes > (uint64_t) config->queue_size * config->buffer_size);
+  free(clients);
+}
+
+void test_cpu_budget() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  // no host can filter 240Msps with 1% of one cpu
+  config->band_sampling_rate = 240000000;
+  config->dsp_cpus = 1;
+  config->cpu_budget_percent = 1;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_OUT_OF_CPU);
+  // passthrough doesn't need dsp
+  reconnect_client();
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, config->band_sampling_rate, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 1);
+}
+
+void test_auto_kernel() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->optimization = AUTO_CF32;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client1));
+  TEST_ASSERT_EQUAL_INT(0, send_stats_message(client1));
+  assert_response(client1, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 1);
+  struct stats_device device;
+  struct stats_client *clients = NULL;
+  TEST_ASSERT_EQUAL_INT(0, read_stats(1, &device, &clients, client1));
+  TEST_ASSERT(clients[0].kernel == STATS_KERNEL_NATIVE_CF32 || clients[0].kernel == STATS_KERNEL_OPTIMIZED_CF32);
+  free(clients);
+}
+
+void test_metrics_failure() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  // already taken by the tcp server itself
+  config->metrics_port = config->port;
+  TEST_ASSERT(start_tcp_server(config, &server) != 0);
+  server = NULL;
+  // everything was released
+  config->metrics_port = 0;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+  reconnect_client();
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+}
+
+void test_rtlsdr_sync() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_RTL;
+  config->band_sampling_rate = 48000;
+  config->rtlsdr_async_buffers = 0;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+
+  int length = 200;
+  setup_input_cu8(&input, 0, length);
+  rtlsdr_setup_mock_data(input, length);
+  rtlsdr_wait_for_data_read();
+
+  uint8_t *actual = malloc(length);
+  TEST_ASSERT(actual != NULL);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, length, client0));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(input, actual, length);
+  free(actual);
+}
+
+void test_time_shift() {
+  TEST_ASSERT_EQUAL_INT(0, create_server_config(&config, "tcp_server.config"));
+  config->sdr_type = SDR_TYPE_RTL;
+  config->band_sampling_rate = 48000;
+  config->time_shift_seconds = 1;
+  TEST_ASSERT_EQUAL_INT(0, start_tcp_server(config, &server));
+
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client0));
+  send_message(client0, PROTOCOL_VERSION, TYPE_REQUEST, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 0);
+
+  int length = 200;
+  setup_input_cu8(&input, 0, 2 * length);
+  rtlsdr_setup_mock_data(input, length);
+  rtlsdr_wait_for_data_read();
+  uint8_t *actual = malloc(2 * length);
+  TEST_ASSERT(actual != NULL);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, length, client0));
+
+  // longer than configured
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client1));
+  send_time_shift_message(client1, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW, 1001);
+  assert_response(client1, TYPE_RESPONSE, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INVALID_REQUEST);
+
+  // only 200 bytes are available in the past
+  TEST_ASSERT_EQUAL_INT(0, create_client(config->bind_address, config->port, &client2));
+  send_time_shift_message(client2, 460100200, 48000, 460100200, REQUEST_DESTINATION_SOCKET_RAW, 1000);
+  assert_response(client2, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 2);
+
+  rtlsdr_setup_mock_data(input + length, length);
+  TEST_ASSERT_EQUAL_INT(0, read_data(actual, 2 * length, client2));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(input, actual, 2 * length);
+  free(actual);
+}
+
+void test_squelch_request() {
+  create_and_init_tcpserver();
+  // squelch works on the decimated output only
+  send_squelch_message(client0, 460100200, config->band_sampling_rate, 460100200, REQUEST_DESTINATION_SOCKET_RAW, 10, 100, 100);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INVALID_REQUEST);
+  reconnect_client();
+  send_squelch_message(client0, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET, 10, 100, 61000);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_FAILURE, RESPONSE_DETAILS_INVALID_REQUEST);
+  reconnect_client();
+  send_squelch_message(client0, 460700000, 48000, 460600000, REQUEST_DESTINATION_SOCKET, 10, 100, 100);
+  assert_response(client0, TYPE_RESPONSE, RESPONSE_STATUS_SUCCESS, 2);
+}
+
 void test_ping() {
   create_and_init_tcpserver();
 
@@ -295,7 +665,20 @@ int main(void) {
   RUN_TEST(test_disconnect_client);
   RUN_TEST(test_rtlsdr);
   RUN_TEST(test_airspy);
+  RUN_TEST(test_airspy_real);
   RUN_TEST(test_hackrf);
+  RUN_TEST(test_passthrough);
+  RUN_TEST(test_rtlsdr_sync);
+  RUN_TEST(test_file_replay);
+  RUN_TEST(test_generator);
+  RUN_TEST(test_stage_stats);
+  RUN_TEST(test_stats);
+  RUN_TEST(test_memory_budget);
+  RUN_TEST(test_cpu_budget);
+  RUN_TEST(test_auto_kernel);
+  RUN_TEST(test_metrics_failure);
+  RUN_TEST(test_time_shift);
+  RUN_TEST(test_squelch_request);
   RUN_TEST(test_out_of_band_frequency_clients);
   RUN_TEST(test_ping);
   return UNITY_END();
@@ -0,0 +1,41 @@
+#include <stdint.h>
+#include <unity.h>
+
+#include "../src/thread_scheduling.h"
+
+uint64_t original_cpus = 0;
+
+void test_defaults_are_not_changed() {
+  TEST_ASSERT_EQUAL_INT(0, thread_scheduling_apply("test", 0, 0));
+  TEST_ASSERT_EQUAL_UINT64(original_cpus, thread_scheduling_get_cpus());
+  TEST_ASSERT_EQUAL_INT(0, thread_scheduling_get_priority());
+}
+
+void test_pin_to_single_cpu() {
+#ifdef __linux__
+  TEST_ASSERT(original_cpus != 0);
+  // the lowest cpu allowed for the process
+  uint64_t cpu = original_cpus & (~original_cpus + 1);
+  TEST_ASSERT_EQUAL_INT(0, thread_scheduling_apply("test", cpu, 0));
+  TEST_ASSERT_EQUAL_UINT64(cpu, thread_scheduling_get_cpus());
+#else
+  TEST_IGNORE_MESSAGE("cpu affinity is not supported");
+#endif
+}
+
+void setUp() {
+  original_cpus = thread_scheduling_get_cpus();
+}
+
+void tearDown() {
+  if (original_cpus != 0) {
+    thread_scheduling_apply("test", original_cpus, 0);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_defaults_are_not_changed);
+  RUN_TEST(test_pin_to_single_cpu);
+  return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "../src/time_shift.h"
+
+time_shift *ring = NULL;
+char file_path[] = "/tmp/sdr_time_shift_test_XXXXXX";
+
+static void put_sequence(uint8_t start, size_t len) {
+  uint8_t buffer[64];
+  for (size_t i = 0; i < len; i++) {
+    buffer[i] = (uint8_t) (start + i);
+  }
+  time_shift_put(buffer, len, ring);
+}
+
+static void assert_sequence(uint8_t start, const uint8_t *actual, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    TEST_ASSERT_EQUAL_UINT8((uint8_t) (start + i), actual[i]);
+  }
+}
+
+void test_read_across_the_boundary() {
+  TEST_ASSERT_EQUAL_INT(0, time_shift_create(10, NULL, &ring));
+  put_sequence(0, 6);
+  put_sequence(6, 6);
+  TEST_ASSERT_EQUAL_UINT64(12, time_shift_get_position(ring));
+  TEST_ASSERT_EQUAL_UINT64(2, time_shift_get_oldest(ring));
+
+  uint8_t output[10];
+  uint64_t position = 4;
+  TEST_ASSERT_EQUAL_size_t(8, time_shift_read(&position, output, sizeof(output), ring));
+  TEST_ASSERT_EQUAL_UINT64(12, position);
+  assert_sequence(4, output, 8);
+  // nothing new
+  TEST_ASSERT_EQUAL_size_t(0, time_shift_read(&position, output, sizeof(output), ring));
+}
+
+void test_overwritten() {
+  TEST_ASSERT_EQUAL_INT(0, time_shift_create(10, NULL, &ring));
+  put_sequence(0, 8);
+  uint64_t position = 1;
+  uint8_t output[4];
+  TEST_ASSERT_EQUAL_size_t(4, time_shift_read(&position, output, sizeof(output), ring));
+  assert_sequence(1, output, 4);
+  // reader is too slow
+  put_sequence(8, 20);
+  TEST_ASSERT_EQUAL_size_t(4, time_shift_read(&position, output, sizeof(output), ring));
+  TEST_ASSERT_EQUAL_UINT64(22, position);
+  assert_sequence(18, output, 4);
+}
+
+void test_buffer_bigger_than_capacity() {
+  TEST_ASSERT_EQUAL_INT(0, time_shift_create(10, NULL, &ring));
+  put_sequence(0, 3);
+  put_sequence(3, 25);
+  TEST_ASSERT_EQUAL_UINT64(28, time_shift_get_position(ring));
+  uint64_t position = 0;
+  uint8_t output[10];
+  TEST_ASSERT_EQUAL_size_t(10, time_shift_read(&position, output, sizeof(output), ring));
+  assert_sequence(18, output, 10);
+}
+
+void test_reset() {
+  TEST_ASSERT_EQUAL_INT(0, time_shift_create(10, NULL, &ring));
+  put_sequence(0, 5);
+  time_shift_reset(ring);
+  TEST_ASSERT_EQUAL_UINT64(0, time_shift_get_position(ring));
+  uint64_t position = 0;
+  uint8_t output[10];
+  TEST_ASSERT_EQUAL_size_t(0, time_shift_read(&position, output, sizeof(output), ring));
+}
+
+void test_file_backed() {
+  int fd = mkstemp(file_path);
+  TEST_ASSERT(fd >= 0);
+  // time_shift opens the file itself
+  close(fd);
+  TEST_ASSERT_EQUAL_INT(0, time_shift_create(16, file_path, &ring));
+  put_sequence(0, 20);
+  uint64_t position = 0;
+  uint8_t output[16];
+  TEST_ASSERT_EQUAL_size_t(16, time_shift_read(&position, output, sizeof(output), ring));
+  assert_sequence(4, output, 16);
+  remove(file_path);
+}
+
+void test_invalid_file() {
+  TEST_ASSERT_EQUAL_INT(-1, time_shift_create(16, "/non-existing-directory/ring", &ring));
+}
+
+void tearDown() {
+  time_shift_destroy(ring);
+  ring = NULL;
+}
+
+void setUp() {
+  // do nothing
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_read_across_the_boundary);
+  RUN_TEST(test_overwritten);
+  RUN_TEST(test_buffer_bigger_than_capacity);
+  RUN_TEST(test_reset);
+  RUN_TEST(test_file_backed);
+  RUN_TEST(test_invalid_file);
+  return UNITY_END();
+}